@@ -15,6 +15,8 @@
 #include "QUnit.h"
 #include "Sorting.h"
 #include <iostream>
+#include <sys/wait.h>
+#include <unistd.h>
 
 int main () {
 
@@ -93,6 +95,81 @@ int main () {
 			}
 		}
 	}
+
+	// crash while loading a B+-Tree whose changes are being logged, by having a
+	// child process exit without shutting down its buffer manager; the tree that
+	// is recovered from the log must have every record, and no half-done splits
+	{
+		unlink ("supplierWAL.bin");
+		unlink ("supplierLog");
+
+		MyDB_SchemaPtr mySchema = make_shared <MyDB_Schema> ();
+		mySchema->appendAtt (make_pair ("suppkey", make_shared <MyDB_IntAttType> ()));
+		mySchema->appendAtt (make_pair ("name", make_shared <MyDB_StringAttType> ()));
+		mySchema->appendAtt (make_pair ("address", make_shared <MyDB_StringAttType> ()));
+		mySchema->appendAtt (make_pair ("nationkey", make_shared <MyDB_IntAttType> ()));
+		mySchema->appendAtt (make_pair ("phone", make_shared <MyDB_StringAttType> ()));
+		mySchema->appendAtt (make_pair ("acctbal", make_shared <MyDB_DoubleAttType> ()));
+		mySchema->appendAtt (make_pair ("comment", make_shared <MyDB_StringAttType> ()));
+
+		pid_t child = fork ();
+		if (child == 0) {
+			MyDB_TablePtr myTable = make_shared <MyDB_Table> ("supplierWAL", "supplierWAL.bin", mySchema);
+			MyDB_BufferManagerPtr myMgr = make_shared <MyDB_BufferManager> (4096, 16, "tempFile");
+			myMgr->useLog ("supplierLog");
+			MyDB_BPlusTreeReaderWriter supplierTable ("suppkey", myTable, myMgr);
+			supplierTable.loadFromTextFile ("supplier.tbl");
+			myMgr->commit ();
+			_exit (0);
+		}
+
+		int status;
+		waitpid (child, &status, 0);
+		QUNIT_IS_TRUE (WIFEXITED (status) && WEXITSTATUS (status) == 0);
+
+		// the table is new to the catalog, so all of its pages come from the log
+		MyDB_TablePtr myTable = make_shared <MyDB_Table> ("supplierWAL", "supplierWAL.bin", mySchema);
+		MyDB_BufferManagerPtr myMgr = make_shared <MyDB_BufferManager> (4096, 16, "tempFile");
+		myMgr->useLog ("supplierLog");
+		MyDB_BPlusTreeReaderWriter supplierTable ("suppkey", myTable, myMgr);
+
+		MyDB_RecordPtr temp = supplierTable.getEmptyRecord ();
+		MyDB_RecordIteratorAltPtr myIter = supplierTable.getIteratorAlt ();
+		int counter = 0;
+		while (myIter->advance ()) {
+			myIter->getCurrent (temp);
+			counter++;
+		}
+		QUNIT_IS_EQUAL (counter, 10000);
+
+		// the keys are 1 through 10000, once each
+		bool allRight = true;
+		for (int i = 0; i < 20; i++) {
+			srand48 (i);
+			int lowBound = lrand48 () % 10000;
+			int highBound = lrand48 () % 10000;
+			if (lowBound > highBound) {
+				int temp = lowBound;
+				lowBound = highBound;
+				highBound = temp;
+			}
+
+			MyDB_IntAttValPtr low = make_shared <MyDB_IntAttVal> ();
+			low->set (lowBound);
+			MyDB_IntAttValPtr high = make_shared <MyDB_IntAttVal> ();
+			high->set (highBound);
+			myIter = supplierTable.getRangeIteratorAlt (low, high);
+
+			int counter = 0;
+			while (myIter->advance ()) {
+				myIter->getCurrent (temp);
+				counter++;
+			}
+			if (counter != highBound - max (lowBound, 1) + 1)
+				allRight = false;
+		}
+		QUNIT_IS_TRUE (allRight);
+	}
 }
 
 #endif
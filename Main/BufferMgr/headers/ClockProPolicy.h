@@ -0,0 +1,62 @@
+
+#ifndef CLOCK_PRO_POLICY_H
+#define CLOCK_PRO_POLICY_H
+
+#include "MyDB_ReplacementPolicy.h"
+#include "PageList.h"
+#include <queue>
+#include <unordered_map>
+
+// a simplified CLOCK-Pro (Jiang, Chen, and Zhang).  Accessing a page only sets
+// its reference bit.  Resident pages are either hot or cold, and each kind is
+// swept by its own clock hand (the tail of the corresponding list).  A cold page
+// that is read in starts a "test period"; if it is referenced again during the
+// test period it becomes hot.  A cold page that is kicked out while still in its
+// test period is remembered as a non-resident test page, and if it is read in
+// again before the test period ends, it comes back hot and the target number of
+// cold pages is increased.  Test periods that end without a re-reference
+// decrease the target.  The hot hand demotes unreferenced hot pages whenever
+// there are more hot pages than the target allows.  A scan reads pages that are
+// never re-referenced, so it only ever cycles through the cold pages
+class ClockProPolicy : public MyDB_ReplacementPolicy {
+
+public:
+
+	// creates the policy for a buffer with numPages pages
+	ClockProPolicy (size_t numPages);
+
+	void pageIn (MyDB_Page *page) override;
+	void unpinned (MyDB_Page *page) override;
+	void touch (MyDB_Page *page) override;
+	void remove (MyDB_Page *page) override;
+	MyDB_Page *victim () override;
+	size_t size () override;
+
+private:
+
+	// the values of MyDB_Page::policyState
+	enum {Cold = 1, ColdInTest = 2, Hot = 3};
+
+	// runs the hot hand until the number of hot pages is within the target
+	void runHotHand ();
+
+	// turns a cold page into a hot one
+	void promote (MyDB_Page *page);
+
+	// resident cold and hot pages; the tail of each list is where its hand points
+	PageList cold;
+	PageList hot;
+
+	// the non-resident test pages, plus the order in which they were kicked
+	// out (this may have stale entries)
+	unordered_map <PageKey, long, PageKeyHash> test;
+	queue <pair <PageKey, long>> testOrder;
+	long numKickedOut;
+
+	// the number of pages in the buffer, and the target number of cold pages
+	size_t capacity;
+	size_t coldTarget;
+};
+
+#endif
+
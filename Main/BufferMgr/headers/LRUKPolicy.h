@@ -0,0 +1,67 @@
+
+#ifndef LRUK_POLICY_H
+#define LRUK_POLICY_H
+
+#include "MyDB_ReplacementPolicy.h"
+#include "PageList.h"
+#include <queue>
+#include <set>
+#include <unordered_map>
+
+// LRU-K, with K = 2: the page that gets kicked out is the one whose second-most
+// recent reference is the oldest.  Pages that have only been referenced once
+// have an infinite backward 2-distance, so they are kicked out first, in LRU
+// order.  This means that a page that is read once by a big scan cannot push
+// out a page that is referenced over and over, such as a B+-Tree directory page.
+//
+// A reference that comes within correlatedPeriod ticks of the previous reference
+// to the same page (as when a page is read, then an output page is written,
+// then the same page is read again) is considered to be part of the same
+// reference.  Times are logical: the clock ticks once per reference.  The time
+// of the last reference to recently kicked-out pages is remembered, so that a
+// page that comes right back is treated as having been referenced twice
+class LRUKPolicy : public MyDB_ReplacementPolicy {
+
+public:
+
+	// creates the policy for a buffer with numPages pages
+	LRUKPolicy (size_t numPages);
+
+	void pageIn (MyDB_Page *page) override;
+	void unpinned (MyDB_Page *page) override;
+	void touch (MyDB_Page *page) override;
+	void remove (MyDB_Page *page) override;
+	MyDB_Page *victim () override;
+	size_t size () override;
+
+private:
+
+	// records a reference to the page at the current time
+	void reference (MyDB_Page *page);
+
+	// puts the page into (or takes it out of) once or twice, depending on its history
+	void place (MyDB_Page *page);
+	void unplace (MyDB_Page *page);
+
+	// resident pages that have been referenced only once, from MRU to LRU
+	PageList once;
+
+	// resident pages that have been referenced at least twice, ordered by the
+	// time of the second-most recent reference
+	set <pair <long, MyDB_Page *>> twice;
+
+	// the time of the last reference to each recently kicked-out page, plus the
+	// order in which they were kicked out, so that we only remember numPages of them
+	unordered_map <PageKey, long, PageKeyHash> history;
+	queue <pair <PageKey, long>> historyOrder;
+	size_t maxHistory;
+
+	// the current logical time
+	long now;
+
+	// references at most this many ticks apart are correlated
+	static const long correlatedPeriod = 2;
+};
+
+#endif
+
@@ -0,0 +1,50 @@
+
+#ifndef LRU_POLICY_H
+#define LRU_POLICY_H
+
+#include "MyDB_ReplacementPolicy.h"
+#include "PageList.h"
+
+// plain LRU: every access moves the page to the head of a single list, and the
+// page at the tail is the one that gets kicked out
+class LRUPolicy : public MyDB_ReplacementPolicy {
+
+public:
+
+	void pageIn (MyDB_Page *page) override {
+		page->inPolicy = true;
+		lastUsed.pushFront (page);
+	}
+
+	void unpinned (MyDB_Page *page) override {
+		pageIn (page);
+	}
+
+	void touch (MyDB_Page *page) override {
+		lastUsed.moveToFront (page);
+	}
+
+	void remove (MyDB_Page *page) override {
+		page->inPolicy = false;
+		lastUsed.remove (page);
+	}
+
+	MyDB_Page *victim () override {
+		MyDB_Page *returnVal = lastUsed.popBack ();
+		if (returnVal != nullptr)
+			returnVal->inPolicy = false;
+		return returnVal;
+	}
+
+	size_t size () override {
+		return lastUsed.size ();
+	}
+
+private:
+
+	// all of the pages, from MRU to LRU
+	PageList lastUsed;
+};
+
+#endif
+
@@ -13,26 +13,58 @@
 #ifndef BUFFER_MGR_H
 #define BUFFER_MGR_H
 
-#include "CheckLRU.h"
+#include <condition_variable>
 #include <map>
 #include <memory>
+#include "MyDB_BufferStats.h"
+#include "MyDB_LogManager.h"
 #include "MyDB_Page.h"
 #include "MyDB_PageHandle.h"
+#include "MyDB_ReadAhead.h"
+#include "MyDB_ReplacementPolicy.h"
 #include "MyDB_Table.h"
-#include "PageCompare.h"
+#include "MyDB_TempSpace.h"
+#include "PageTable.h"
+#include <mutex>
 #include <queue>
-#include "TableCompare.h"
-#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 using namespace std;
 
 class MyDB_BufferManager;
 typedef shared_ptr <MyDB_BufferManager> MyDB_BufferManagerPtr;
 
+// thrown when the bytes of a page are needed, but every page in the buffer has
+// stayed pinned for longer than the frame wait timeout.  Nothing has been lost;
+// an operator that uses a lot of the buffer (such as a sort) can catch this,
+// give back some of its pages, and try again with less
+class MyDB_BufferFullError : public runtime_error {
+
+public:
+
+	MyDB_BufferFullError () : runtime_error ("Can't get any RAM to read a page!!") {}
+};
+
+// thrown when a page read from disk does not match its checksum (say, because
+// only part of it made it to disk before a crash); the page is not buffered
+class MyDB_PageCorruptError : public runtime_error {
+
+public:
+
+	MyDB_PageCorruptError (string what) : runtime_error (what) {}
+};
+
 class MyDB_BufferManager {
 
 public:
 
+	// all of the methods here may be called by several threads at once.  Note
+	// that the bytes of an unpinned page can be kicked out of RAM as a result
+	// of the activity of any thread, so pages that are shared among threads
+	// should be pinned
+
 	// gets the i^th page in the table whichTable... note that if the page
 	// is currently being used (that is, the page is current buffered) a handle 
 	// to that already-buffered page should be returned
@@ -45,57 +77,244 @@ public:
 	// table
 	MyDB_PageHandle getPage ();
 
+	// like the above, except that the page goes into the given region of the temp
+	// space; the pages of a region are laid out one after another on disk, in the
+	// order that they were asked for, so a run that is spilled into a region of
+	// its own is written and read back sequentially
+	MyDB_PageHandle getPage (MyDB_TempRegionPtr inMe);
+
+	// creates a new region of the temp space, for one operator or spilled run
+	MyDB_TempRegionPtr makeTempRegion ();
+
+	// spreads the temp pages over a file in each of the given directories (say,
+	// one per disk) rather than writing them all to the temp file; the files are
+	// named after the temp file.  This has to be done before any temp page is
+	// asked for
+	void useTempDirectories (vector <string> dirs);
+
 	// gets the i^th page in the table whichTable... the only difference 
 	// between this method and getPage (whicTable, i) is that the page will be 
 	// pinned in RAM; it cannot be written out to the file... note that in Chris'
 	// implementation, a request for a pinned page that is made when the buffer
-	// is ENTIRELY full of pinned pages will return a nullptr
+	// is ENTIRELY full of pinned pages will return a nullptr (here, after waiting
+	// up to the frame wait timeout for some other page to be unpinned)
 	MyDB_PageHandle getPinnedPage (MyDB_TablePtr whichTable, long i);
 
 	// gets a temporary page, like getPage (), except that this one is pinned
 	MyDB_PageHandle getPinnedPage ();
 
+	// like the above, except that the pin is charged to the given quota; if the
+	// quota is used up, a nullptr is returned right away.  Asking for a page that
+	// is already pinned is not charged
+	MyDB_PageHandle getPinnedPage (MyDB_TablePtr whichTable, long i, MyDB_PinQuotaPtr quota);
+	MyDB_PageHandle getPinnedPage (MyDB_PinQuotaPtr quota);
+
+	// like the above, except that the page goes into the given region of the temp
+	// space, as with getPage (inMe); an operator that writes a run out from several
+	// threads at once pins the page that it is filling, so that another thread
+	// cannot kick it out from under it
+	MyDB_PageHandle getPinnedPage (MyDB_TempRegionPtr inMe, MyDB_PinQuotaPtr quota);
+
+	// when every page in the buffer is pinned, a request for RAM waits up to this
+	// many milliseconds for a page to be unpinned before it gives up; a pinned
+	// page request then returns a nullptr, and reading the bytes of an unpinned
+	// page throws a MyDB_BufferFullError
+	void setFrameWaitTimeout (size_t millis);
+
+	// the number of frames that are not taken up by pinned pages; an operator can
+	// use this to decide how much of the buffer it can count on
+	size_t getNumUnpinnedFrames ();
+
+	// turns checksums on or off (they are on to start with).  When they are on,
+	// every page that has a MyDB_PageHeader gets its checksum filled in when it
+	// is written back, and checked when it is read (or, for a page in a read-only
+	// mapping, when it is first asked for); a page that fails the check makes the
+	// access throw a MyDB_PageCorruptError.  Pages without a header
+	// are left alone, except in a table whose pages all have one (see
+	// MyDB_Table :: getPageFormat); there, the page has been damaged
+	void setChecksums (bool on);
+
 	// un-pins the specified page
 	void unpin (MyDB_PageHandle unpinMe);
 
+	// asks that pages lowPage through highPage of the table be read in the
+	// background, because a scan is about to get to them; this is only a hint
+	void readAhead (MyDB_TablePtr whichTable, long lowPage, long highPage);
+
+	// the number of pages that a sequential scan should ask to be read ahead of
+	// the page that it is currently on
+	size_t getReadAheadPages ();
+
+	// from now on, pages of the table are served straight out of a read-only
+	// memory mapping of its file, rather than being copied into the buffer;
+	// the pages cannot be written to, and they are never kicked out.  Only pages
+	// that lie entirely within the file (as it is when this is called) are mapped
+	void mapReadOnly (MyDB_TablePtr whichTable);
+
+	// from now on, every change to a page of a table that is reported with
+	// wroteBytes (offset, len) is logged to the given file, and a dirty page is
+	// not written back until the log is on disk up to its last change; the log
+	// is synced in the background, every few milliseconds.  First, though, any
+	// changes that are in the log from before (say, from before a crash) are
+	// redone on the tables' files.  This has to be done before any page is
+	// asked for, and before any other thread uses the buffer manager
+	void useLog (string logFile);
+
+	// the last page of the table that was changed by redoing the log, since the
+	// catalog may not know about the pages that were added before a crash; -1 if
+	// none (or if there is no log)
+	long getRecoveredLastPage (MyDB_TablePtr whichTable);
+
+	// the changes to pages of tables that the calling thread makes between these
+	// two calls are logged as one group, so after a crash, either all of them
+	// or none of them are redone.  The pages that are changed stay in the buffer
+	// (and are not written back) until the end.  Calls may be nested; only the
+	// outermost pair counts.  These do nothing if there is no log
+	void beginAction ();
+	void endAction ();
+
+	// waits until every change logged so far (by any thread) is on disk; the
+	// syncs of threads that commit at about the same time are shared
+	void commit ();
+
+	// writes back every dirty page of every table, syncs the files, and empties
+	// the log, so that there is nothing to redo; waits for any actions that are
+	// under way to end first (so must not be called inside of one).  If a page
+	// cannot be written, the log is kept, since it is all that has the changes
+	void checkpoint ();
+
+	// writes all of the dirty pages of the given table (or of every table) back
+	// to disk; the pages stay buffered.  Pages are written in file order, and
+	// runs of consecutive pages are written with a single call
+	void flushTable (MyDB_TablePtr whichTable);
+	void flushAll ();
+
 	// creates an LRU buffer manager... params are as follows:
 	// 1) the size of each page is pageSize 
 	// 2) the number of pages managed by the buffer manager is numPages;
 	// 3) temporary pages are written to the file tempFile
 	MyDB_BufferManager (size_t pageSize, size_t numPages, string tempFile);
+
+	// like the above, except that the buffer manager uses the given replacement
+	// policy to decide which page to kick out (LRU-K, 2Q, and CLOCK-Pro are all
+	// resistant to being flushed by large scans)
+	MyDB_BufferManager (size_t pageSize, size_t numPages, string tempFile, MyDB_PolicyType policyType);
+
+	// like the above, except that if directIO is true, files are opened with
+	// O_DIRECT so that the buffer is the only place that pages are cached (the
+	// OS page cache is bypassed).  This needs the page size to be a multiple
+	// of 4KB, and a file system that supports it; otherwise, the normal,
+	// buffered I/O is used
+	MyDB_BufferManager (size_t pageSize, size_t numPages, string tempFile, MyDB_PolicyType policyType,
+		bool directIO);
 	
 	// when the buffer manager is destroyed, all of the dirty pages need to be
-	// written back to disk, and any temporary files need to be deleted
+	// written back to disk (after which the log, if any, is emptied), and any
+	// temporary files need to be deleted
 	~MyDB_BufferManager ();
 
 	// returns the page size
 	size_t getPageSize ();
+
+	// the number of page accesses that did (did not) find the page already buffered
+	size_t getNumHits ();
+	size_t getNumMisses ();
+
+	// the number of misses that were served by pages that had been read ahead
+	size_t getNumReadAheadHits ();
+
+	// returns a snapshot of all of the buffer manager's counters, the I/O latency
+	// histograms, and the number of pages of each table that are buffered
+	MyDB_BufferStats getStats ();
+
+	// from now on, the stats are printed to the given stream every so many
+	// milliseconds (by the flusher thread, so not more often than it wakes up);
+	// zero turns this off.  The stream must stay around until this is turned off
+	void dumpStatsEvery (size_t millis, ostream &toMe);
 	
 private:
 
-	// tells us the LRU number of each of the pages
-	set <MyDB_PageHandle, CheckLRU> lastUsed;
-
-	// list of ALL of the page objects that are currently in existence
-	map <pair <MyDB_TablePtr, size_t>, MyDB_PagePtr, PageCompare> allPages;
+	// the page table and the replacement state are split into shards, and a page
+	// always lives in the shard picked by hashing (table id, page number); each
+	// shard has its own latch, so threads working on different shards do not
+	// contend with one another
+	struct Shard {
+
+		// protects everything else in the shard, as well as the bytes, dirty
+		// bit, and policy bookkeeping of every page that lives in the shard
+		mutex latch;
+
+		// decides which of the shard's buffered, unpinned pages gets kicked out
+		MyDB_ReplacementPolicyPtr policy;
+
+		// the page that was accessed most recently; repeated accesses to the same
+		// page (as when iterating through its records) are not passed on to the policy
+		MyDB_Page *lastAccessed;
+
+		// the number of dirty pages that have been kicked out of the shard
+		size_t numDirtyEvictions;
+
+		// list of ALL of the page objects in the shard that are currently in
+		// existence, keyed on (table id, page number)
+		PageTable allPages;
+	};
+
+	// all of the shards; there is a power-of-two number of them
+	vector <unique_ptr <Shard>> shards;
+
+	// reads pages in the background for sequential scans
+	MyDB_ReadAheadPtr readAheadPool;
+
+	// a thread that periodically writes back dirty pages that no one is using,
+	// so that fewer pages have to be written one at a time as they are kicked out
+	thread flusher;
+	mutex flusherLatch;
+	condition_variable flusherWake;
+	bool flusherStopping;
+
+	// how often the flusher prints the stats (0 for never), and where; protected
+	// by flusherLatch
+	size_t statsInterval;
+	ostream *statsOut;
+
+	// every thread that uses the buffer manager counts what it does in its own
+	// MyDB_ThreadStats, so that counting costs no more than a couple of plain
+	// stores; they are all added up when someone asks for the stats.  The
+	// serial number tells the buffer managers apart, even if one is created
+	// where another one used to be
+	long serialNum;
+	mutex statsLatch;
+	vector <shared_ptr <MyDB_ThreadStats>> allThreadStats;
+
+	// returns the counters of the calling thread
+	MyDB_ThreadStats &myStats ();
+
+	// adds up the given counter over all of the threads
+	size_t sumCounter (MyDB_StatCounter which);
+
+	// protects the list of FDs
+	mutex fileLatch;
 	
-	// lists the FDs for all of the files
-	map <MyDB_TablePtr, int, TableCompare> fds;
+	// the FDs for all of the files, indexed by table id; -1 if not yet open
+	vector <int> fds;
 
-	// all of the chunks of RAM that are currently not allocated
-	vector <void *> availableRam;
+	// hands out the slots that temp pages are written to
+	MyDB_TempSpacePtr tempSpace;
 
-	// all of the positions in the temporary file that are currently not in use
-	priority_queue<size_t, vector<size_t>, greater<size_t>> availablePositions;
+	// all of the frames are carved out of one contiguous arena; frame i starts
+	// frameSize * i bytes into it
+	char *arena;
+	size_t arenaSize;
+	size_t frameSize;
 
-	// the page size
-	size_t pageSize;
+	// protects freeFrames
+	mutex ramLatch;
 
-	// the time tick associated with the MRU page
-	long lastTimeTick;
+	// the indices of all of the frames that are currently not allocated
+	vector <size_t> freeFrames;
 
-	// the last position in the temporary file
-	size_t lastTempPos;
+	// the page size
+	size_t pageSize;
 
 	// where we write the data
 	string tempFile;
@@ -106,15 +325,179 @@ private:
 	// so that the page can access these private methods
 	friend class MyDB_Page;
 
-	// kick out the LRU page
-	void kickOutPage ();
-
-	// process an access to the given page
-	void access (MyDB_Page &updateMe);
+	// returns the number of the shard that the given page lives in
+	size_t shardOf (long tableID, size_t pos);
+
+	// kick out the page chosen by the shard's replacement policy, and return its
+	// RAM; a dirty page that cannot be written back is passed over, and so is one
+	// whose changes are not durable in the log yet (needLSN is raised to the LSN
+	// that the log has to be flushed to for it).  Returns nullptr if the shard has
+	// no unpinned, buffered pages that can be kicked out... the caller must hold
+	// the shard's latch
+	void *kickOutPage (Shard &fromMe, uint64_t &needLSN);
+
+	// returns a chunk of RAM for a page, kicking out a page if needed (starting
+	// with the given shard); if the only pages that can be kicked out are waiting
+	// for the log, the log is flushed first, without holding any latch.  Returns
+	// nullptr if every page in the buffer is pinned... the caller must not hold
+	// any shard latch
+	void *getFreeFrame (size_t preferMe);
+
+	// gives back a chunk of RAM that is no longer needed
+	void releaseFrame (void *ram);
+
+	// like getFreeFrame, except that if every page is pinned, this waits up to the
+	// frame wait timeout for one to be unpinned
+	void *waitForFrame (size_t preferMe);
+
+	// called whenever a frame may have become available (a frame was given back,
+	// or a page was unpinned), to wake up anyone waiting for one
+	void frameMayBeFree ();
+
+	// called when the page stops being pinned; gives the pin back to its quota...
+	// the caller must hold the shard's latch
+	void pinEnded (MyDB_Page &unpinMe);
+
+	// used to wait for a frame: the number of threads waiting, and a count of the
+	// events that may have made a frame available, so that none are missed
+	atomic <size_t> frameWaitTimeout;
+	atomic <size_t> numFrameWaiters;
+	atomic <size_t> numFrameEvents;
+	mutex frameWaitLatch;
+	condition_variable frameFreed;
+
+	// convert between the index of a frame and its address in the arena
+	void *frameAt (size_t index);
+	size_t frameIndex (void *frame);
+
+	// removes the page from the shard's list of all pages, recycling its temp
+	// file slot... the caller must hold the shard's latch
+	void forgetPage (Shard &fromMe, MyDB_Page &forgetMe);
+
+	// returns the FD for the given table, opening the file if it is not open
+	int openFile (MyDB_TablePtr whichTable);
+
+	// opens the file with the given flags, adding O_DIRECT if we are doing direct I/O
+	int openForIO (string fileName, int flags);
+
+	// creates the object for a page of a table, pointing it into the table's
+	// read-only mapping if there is one; a mapped page is checked right away (see
+	// checkPage), since it is never read.  The caller must hold the shard's latch
+	MyDB_PagePtr makePage (MyDB_TablePtr whichTable, long i, int fd);
+
+	// returns the page's bytes in the table's read-only mapping; nullptr if the
+	// table is not mapped, or if the page is not in the mapped part of the file
+	char *mappedBytes (long tableID, long i);
+
+	// the read-only mappings of tables (address and length), indexed by table
+	// id; the address is nullptr if the table is not mapped.  If a table is
+	// mapped again, the old mapping is kept in oldMappings until the end, since
+	// there might still be pages that point into it.  Protected by fileLatch
+	vector <pair <char *, size_t>> mappings;
+	vector <pair <char *, size_t>> oldMappings;
+
+	// true if files are opened with O_DIRECT
+	bool directIO;
+
+	// true if pages are checksummed
+	atomic <bool> checksums;
+
+	// process an access to the given page, and return its bytes
+	void *access (MyDB_Page &updateMe);
+
+	// reads the page into the given RAM (from a copy that was read ahead, if
+	// there is one), and hands it to the policy unless it is
+	// being pinned... the caller must hold the shard's latch
+	void readPage (Shard &inMe, MyDB_Page &readMe, void *ram, bool pinned);
+
+	// true if the page must have a MyDB_PageHeader: it is in a table that was
+	// written in a format with one, and it is not past the end of the file (a
+	// page there has never been written, so it reads as zeros)
+	bool mustHaveHeader (MyDB_Page &page);
+
+	// if checksums are on, checks the bytes of the page (see setChecksums); if
+	// they fail, counts the failure and returns what is wrong with the page, to
+	// go into a MyDB_PageCorruptError.  Returns "" if the page is fine
+	string checkPage (MyDB_Page &page);
 
 	// removes all traces of the page from the buffer manager
 	void killPage (MyDB_Page &killMe);
 
+	// writes back the dirty pages of the given table (-1 for all tables); if
+	// onlyUnused is true, pages that someone has a handle to are skipped.  If
+	// emptyLog is true, the files are then synced and the log is emptied, all
+	// before any more changes can be logged (so every shard is latched until
+	// then); otherwise, the pages are copied one shard at a time, holding only
+	// that shard's latch, and written back without holding any
+	void flushDirty (long tableID, bool onlyUnused, bool emptyLog);
+
+	// only one thread writes back pages in bulk at a time, so that a copy of a
+	// page taken by one cannot land on disk after a newer one taken by another
+	mutex writeBackLatch;
+
+	// the bytes of a page that is to be written back, and the LSN of the last
+	// change to them
+	struct PageImage {
+		MyDB_Page *page;
+		void *bytes;
+		uint64_t lsn;
+	};
+
+	// writes the given page images in (table, page number) order, coalescing
+	// consecutive pages into one write, once the log is durable up to their last
+	// changes... the pages must not be read back in until this returns.  A page
+	// that cannot be written is marked dirty again, and false is returned
+	bool writeBack (vector <PageImage> &images);
+
+	// the write-ahead log; nullptr if changes are not being logged.  It is only
+	// set (by useLog) while every shard is latched, and before any pages exist
+	MyDB_LogManagerPtr log;
+
+	// logs the change to the page (as a group of its own, or as part of the
+	// calling thread's action)
+	void logChange (MyDB_Page &changed, size_t offset, size_t len);
+
+	// the changes that a thread has made in the action that it is in, and the
+	// pages that it changed
+	struct LoggedAction {
+		int depth;
+		MyDB_LogGroup changes;
+		vector <MyDB_PageHandle> pages;
+	};
+
+	// the actions that are under way, by thread.  A checkpoint waits for there
+	// to be none, and while it is going on, no new ones are begun
+	mutex actionLatch;
+	condition_variable actionsChanged;
+	map <thread :: id, LoggedAction> actions;
+	bool checkpointing;
+
+	// the last page of each file that was changed by redoing the log, by file
+	// name; protected by fileLatch
+	map <string, long> recoveredPages;
+
+	// the loop run by the flusher thread
+	void flushInBackground ();
+
+};
+
+// begins a logged action when it is created, and ends it when it goes away
+// (even if an exception is thrown in between)
+class MyDB_ActionGuard {
+
+public:
+
+	MyDB_ActionGuard (MyDB_BufferManager &mgrIn) : mgr (mgrIn) {
+		mgr.beginAction ();
+	}
+
+	~MyDB_ActionGuard () {
+		mgr.endAction ();
+	}
+
+private:
+
+	MyDB_BufferManager &mgr;
 };
 
 #endif
@@ -0,0 +1,125 @@
+
+#ifndef BUFFER_STATS_H
+#define BUFFER_STATS_H
+
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// the events that the buffer manager counts
+enum MyDB_StatCounter {HitCount, MissCount, EvictionCount, WriteBackCount, WriteFailureCount, PinFailureCount,
+	ChecksumFailureCount, LogWaitCount, NumStatCounters};
+
+// I/O latencies are kept in histograms; bucket i counts the I/Os that took
+// from 2^i up to 2^(i+1) microseconds (bucket 0 also counts anything faster)
+#define NUM_LATENCY_BUCKETS 24
+
+// the counters that one thread has collected for one buffer manager.  Only
+// that thread ever changes them, so an update is a plain load and store rather
+// than an atomic read-modify-write; they are atomic so that they can be read
+// (and added up) by another thread at any time
+struct MyDB_ThreadStats {
+
+	atomic <size_t> counters[NumStatCounters];
+	atomic <size_t> readLatency[NUM_LATENCY_BUCKETS];
+	atomic <size_t> writeLatency[NUM_LATENCY_BUCKETS];
+
+	MyDB_ThreadStats () {
+		for (auto &counter : counters)
+			counter = 0;
+		for (int i = 0; i < NUM_LATENCY_BUCKETS; i++) {
+			readLatency[i] = 0;
+			writeLatency[i] = 0;
+		}
+	}
+
+	void count (MyDB_StatCounter which, size_t howMany = 1) {
+		bump (counters[which], howMany);
+	}
+
+	// records an I/O that took the given number of microseconds
+	void timeRead (size_t micros) {
+		bump (readLatency[bucketFor (micros)], 1);
+	}
+
+	void timeWrite (size_t micros) {
+		bump (writeLatency[bucketFor (micros)], 1);
+	}
+
+private:
+
+	static void bump (atomic <size_t> &counter, size_t howMany) {
+		counter.store (counter.load (memory_order_relaxed) + howMany, memory_order_relaxed);
+	}
+
+	static int bucketFor (size_t micros) {
+		int bucket = 0;
+		while (micros > 1 && bucket < NUM_LATENCY_BUCKETS - 1) {
+			micros >>= 1;
+			bucket++;
+		}
+		return bucket;
+	}
+};
+
+// a snapshot of everything that the buffer manager knows about how it is doing
+struct MyDB_BufferStats {
+
+	// accesses that found (did not find) the page buffered
+	size_t numHits;
+	size_t numMisses;
+
+	// misses that were served by a page that had been read ahead
+	size_t numReadAheadHits;
+
+	// pages kicked out of the buffer, and dirty pages written back to disk
+	size_t numEvictions;
+	size_t numWriteBacks;
+
+	// dirty pages that could not be written back (say, because the disk is full);
+	// they stay dirty, and are written again later
+	size_t numWriteFailures;
+
+	// requests for a pinned page that failed because the buffer was all pinned
+	size_t numPinFailures;
+
+	// pages read from disk that did not match their checksums
+	size_t numChecksumFailures;
+
+	// groups of changes logged, times the log was synced, and write-backs that
+	// had to wait for the log to be synced first (0 if there is no log)
+	size_t numLogGroups;
+	size_t numLogSyncs;
+	size_t numLogWaits;
+
+	// the size of the buffer, and how much of it is free or pinned
+	size_t numFrames;
+	size_t numFreeFrames;
+	size_t numPinnedPages;
+
+	// the number of temp pages in use, and the number of pages that the temp
+	// files take up on disk (which is more, since they are handed out in extents)
+	size_t tempFilePages;
+	size_t tempSpacePages;
+
+	// the number of buffered pages of each table (temp pages are under "(temp)")
+	map <string, size_t> residentPages;
+
+	// histograms of the read and write latencies; see NUM_LATENCY_BUCKETS
+	vector <size_t> readLatency;
+	vector <size_t> writeLatency;
+
+	MyDB_BufferStats ();
+
+	// the fraction of accesses that were hits
+	double getHitRate ();
+
+	// prints out the stats
+	void print (ostream &toMe);
+};
+
+#endif
@@ -0,0 +1,136 @@
+
+#ifndef LOG_MGR_H
+#define LOG_MGR_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+class MyDB_LogManager;
+typedef shared_ptr <MyDB_LogManager> MyDB_LogManagerPtr;
+
+// a set of changes to pages that is logged, and redone after a crash, as a
+// unit: either all of them are redone, or none are.  Each change is an
+// after-image of some bytes of a page of a file
+class MyDB_LogGroup {
+
+public:
+
+	// adds the change of len bytes at the given offset of page pageNum of the file
+	void add (const string &fileName, size_t pageNum, size_t offset, const void *bytes, size_t len);
+
+	// true if there are no changes in the group
+	bool isEmpty ();
+
+private:
+
+	friend class MyDB_LogManager;
+
+	// the changes, laid out as they are in the log
+	vector <char> changes;
+};
+
+// the write-ahead log.  Groups of changes are appended to a buffer in RAM, and
+// a writer thread writes the buffer to the end of the log file and syncs it,
+// so that everyone who is waiting for their changes to be durable is taken care
+// of by a single sync (group commit).  The writer also syncs every so often on
+// its own, so changes make it to disk soon even if no one waits for them.
+//
+// The log sequence number (LSN) of a group is the number of bytes of groups
+// that had been logged once it was appended, counting from when the log was
+// created; a group is durable once the durable LSN has reached its LSN.  A page
+// with changes in the log must not be written back until the log is durable up
+// to the LSN of its last change (the write-ahead rule), which is up to the
+// buffer manager
+class MyDB_LogManager {
+
+public:
+
+	// opens (or creates) the log in the given file; the log must have been
+	// written with the same page size
+	MyDB_LogManager (string logFile, size_t pageSize);
+
+	// writes out whatever is left, and closes the log
+	~MyDB_LogManager ();
+
+	// redoes every complete group in the log on the files that it names, in
+	// order, and then empties the log; a group that only partly made it to disk
+	// ends the log.  lastPages is set to the last page of each file that was
+	// changed.  This has to be done before anything else is logged
+	void recover (map <string, long> &lastPages);
+
+	// appends the group to the log, and returns its LSN
+	uint64_t append (MyDB_LogGroup &appendMe);
+
+	// waits until every group up to the given LSN is durable
+	void flushTo (uint64_t lsn);
+
+	// waits until every group appended so far is durable
+	void flushAll ();
+
+	// empties the log; every page that had changes in it must have been written
+	// back, and synced, first.  LSNs keep counting up from where they were
+	void truncate ();
+
+	// the LSN up to which the log is durable
+	uint64_t getDurableLSN ();
+
+	// the number of times that the log file was synced, the number of groups
+	// appended, and the number of groups redone by recover ()
+	size_t getNumSyncs ();
+	size_t getNumGroups ();
+	size_t getNumRecovered ();
+
+private:
+
+	// the loop run by the writer thread
+	void writeInBackground ();
+
+	// writes the header of an empty log, whose first group follows startLSN
+	void writeHeader ();
+
+	// protects everything below
+	mutex latch;
+
+	// wakes up the writer, and tells waiters that more of the log is durable
+	condition_variable writerWake;
+	condition_variable flushed;
+
+	// groups that have not been written to the file yet
+	vector <char> buffer;
+
+	// the LSN at the start of the log file, the LSN up to which the log has been
+	// handed to the writer, the LSN at the end of the buffer, and the LSN up to
+	// which the file has been synced
+	uint64_t startLSN;
+	uint64_t writtenLSN;
+	uint64_t endLSN;
+	uint64_t durableLSN;
+
+	// true while the writer is writing (without holding the latch)
+	bool writing;
+
+	// the number of threads waiting for the log to be durable
+	size_t numWaiters;
+
+	bool stopping;
+
+	size_t numSyncs;
+	size_t numGroups;
+	size_t numRecovered;
+
+	string logFile;
+	int fd;
+	size_t pageSize;
+
+	thread writer;
+};
+
+#endif
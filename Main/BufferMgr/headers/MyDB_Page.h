@@ -12,7 +12,10 @@
 #ifndef PAGE_H
 #define PAGE_H
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include "MyDB_PinQuota.h"
 #include "MyDB_Table.h"
 #include <string>
 
@@ -34,6 +37,10 @@ public:
 	// let the page know that we have written to the bytes
 	void wroteBytes ();
 
+	// the same, for a change to len bytes starting at offset; if the buffer
+	// manager is logging, the change is logged
+	void wroteBytes (size_t offset, size_t len);
+
 	// there are no more references to this page when this is called...
 	// if the page owns any RAM, it should give it back to the parent
 	// buffer manager
@@ -60,7 +67,12 @@ private:
 
 	friend class MyDB_BufferManager;
 	friend class PageComp;
-	friend class CheckLRU;
+	friend class PageList;
+	friend class MyDB_ReplacementPolicy;
+	friend class LRUPolicy;
+	friend class LRUKPolicy;
+	friend class TwoQPolicy;
+	friend class ClockProPolicy;
 
 	// a pointer to the raw bytes
 	void *bytes;
@@ -69,7 +81,7 @@ private:
 	size_t numBytes;
 
 	// tells us if this page needs to be written back
-	bool isDirty;	
+	atomic <bool> isDirty;
 
 	// pointer to the parent buffer manager
 	MyDB_BufferManager& parent;		
@@ -78,14 +90,64 @@ private:
 	// this is a temp page that does not belong to any relation
 	MyDB_TablePtr myTable;
 
+	// the identifier of that relation, as assigned by the catalog; -1 for a temp page
+	long tableID;
+
 	// this is the position of the page in the relation
 	size_t pos;
 
-	// this is the last time that the page had been accessed
-	long timeTick;
-
-	// the number of references
-	int refCount;
+	// the file that the page is read from and written to, and the position of
+	// the page in that file; this is the same as pos, except for temp pages,
+	// which are spread over the temp files by the temp space
+	int fd;
+	size_t filePos;
+
+	// true if the bytes of the page are in a read-only mapping of the file,
+	// rather than in a buffer frame
+	bool isMapped;
+
+	// true iff the page is buffered and not pinned, in which case the buffer
+	// manager's replacement policy is tracking it as a candidate for eviction
+	bool inPolicy;
+
+	// links for the intrusive list(s) used by the replacement policy
+	MyDB_Page *policyPrev;
+	MyDB_Page *policyNext;
+
+	// bookkeeping that belongs to the replacement policy: which of its queues
+	// the page lives in, a CLOCK reference bit, and the logical times of the
+	// last two (uncorrelated) references to the page
+	int policyState;
+	bool refBit;
+	long lastTick;
+	long histTick;
+
+	// the quota that the page's pin is charged to; nullptr if the page is
+	// not pinned, or if the pin was not asked for with a quota
+	MyDB_PinQuotaPtr pinQuota;
+
+	// the LSN of the last logged change to the page; the page cannot be written
+	// back until the log is durable up to here
+	uint64_t lsn;
+
+	// true if the page has changes that are part of a logged action that has not
+	// ended yet; such a page cannot be written back, and is kept in the buffer by
+	// taking it away from the policy (in which case actionPinned is true) until
+	// the action ends
+	bool inAction;
+	bool actionPinned;
+
+	// true while a copy of the page is being written back by flushDirty; until
+	// the write lands, the page is kept in the buffer so that it cannot be read
+	// back in from disk before it is there.  If it would otherwise be in the
+	// policy, it is taken away from the policy (in which case flushPinned is
+	// true) until the write is done
+	bool isFlushing;
+	bool flushPinned;
+
+	// the number of references; handles to the same page can be created and
+	// destroyed by different threads, so this is atomic
+	atomic <int> refCount;
 };
 
 #endif
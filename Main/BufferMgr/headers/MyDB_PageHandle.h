@@ -40,6 +40,14 @@ public:
 		page->wroteBytes ();
 	}
 
+	// the same, except that only len bytes starting at offset were written; if
+	// the buffer manager is keeping a log, this is what gets logged, so a change
+	// to a page of a table that is reported with the other version is not
+	// recovered after a crash
+	void wroteBytes (size_t offset, size_t len) {
+		page->wroteBytes (offset, len);
+	}
+
 	// There are no more references to the handle when this is called...
 	// this should decrmeent a reference count to the number of handles
 	// to the particular page that it references.  If the number of 
@@ -64,7 +72,6 @@ private:
 		return page->getParent ();
 	}
 
-	friend class CheckLRU;
 	friend class MyDB_BufferManager;
 	MyDB_PagePtr page;
 };
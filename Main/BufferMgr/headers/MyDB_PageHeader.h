@@ -0,0 +1,107 @@
+
+#ifndef PAGE_HEADER_H
+#define PAGE_HEADER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// the version of the page format that is written by this code; version 2 added
+// the slot directory, and version 3 length-prefixed the strings in records
+#define PAGE_FORMAT_VERSION 3
+
+// pages written before this version have a header, but no slots; like the pages
+// written before there was a header, their records are one after another, from
+// the end of the header up to numBytesUsed
+#define SLOT_DIRECTORY_VERSION 2
+
+// the most records (slots) that a page can hold
+#define MAX_PAGE_SLOTS 0xffff
+
+// says where a record is on the page; a record that has been deleted has its
+// offset set to zero, and its space is reclaimed when the page is compacted
+struct MyDB_PageSlot {
+
+	// the number of bytes from the start of the page to the record
+	uint32_t offset;
+
+	// the size of the record
+	uint32_t length;
+};
+
+// marks a page as having a header; pages without it are just raw bytes, or were
+// written before there was a header.  Those have the page type in their first
+// bytes and the number of bytes in use right after it, where numBytesUsed is
+// now, and their records are one after another from there up to that many bytes
+#define PAGE_MAGIC 0x4244794d
+
+// the header at the start of every page that holds records.  The buffer
+// manager uses it to check that a page read from disk is the page that was
+// written: the checksum covers the header (with the checksum taken to be zero)
+// and all of the used bytes of the page, and it is filled in every time the
+// page is written back.  A page that was only partly written (say, because of
+// a crash) does not match its checksum.
+//
+// The records on a page are found through a directory of slots at the end of
+// the page: slot 0 is in the last bytes of the page, slot 1 right before it, and
+// so on, while the records themselves are put one after another right after the
+// header.  So the page fills up from both ends, and the k^th record can be found
+// without looking at any of the ones before it
+struct MyDB_PageHeader {
+
+	// the MyDB_PageType of the page
+	uint32_t pageType;
+
+	// PAGE_MAGIC
+	uint32_t magic;
+
+	// the number of bytes at the start of the page that are in use, including
+	// this header; records start right after it.  This does not count the slots
+	uint64_t numBytesUsed;
+
+	// the log sequence number of the last change to the page
+	uint64_t lsn;
+
+	// CRC32C of the used part of the page
+	uint32_t checksum;
+
+	// the PAGE_FORMAT_VERSION that the page was written with
+	uint16_t version;
+
+	// the number of slots at the end of the page
+	uint16_t numSlots;
+
+	// sets up a header for an empty page at the start of the given bytes
+	static void format (void *page);
+
+	// true if the page has a header
+	static bool isFormatted (void *page);
+
+	// true if the records on the page are one after another, with no slots, as
+	// they were before SLOT_DIRECTORY_VERSION; a page that was never written counts
+	static bool isSequential (void *page);
+
+	// where the first record on such a page is, and the end of the last one
+	static size_t getSequentialStart (void *page);
+	static size_t getSequentialEnd (void *page, size_t pageSize);
+
+	// returns the i^th slot of the page
+	static MyDB_PageSlot *getSlot (void *page, size_t pageSize, size_t i);
+
+	// fills in the checksum of the page, if it has a header
+	static void stamp (void *page, size_t pageSize);
+
+	// true if the page has a header and its checksum is right; a page without a
+	// header is taken to be a legacy page, and passes, unless needHeader is true
+	static bool verify (void *page, size_t pageSize, bool needHeader);
+
+	// computes CRC32C, using the SSE4.2 instruction when the CPU has it
+	static uint32_t crc32c (const void *data, size_t len);
+
+	// the same, always done in software; this is here for testing
+	static uint32_t crc32cSoftware (const void *data, size_t len);
+
+	// true if crc32c uses the CPU's instruction
+	static bool hasHardwareCRC ();
+};
+
+#endif
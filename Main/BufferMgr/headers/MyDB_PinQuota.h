@@ -0,0 +1,59 @@
+
+#ifndef PIN_QUOTA_H
+#define PIN_QUOTA_H
+
+#include <atomic>
+#include <memory>
+
+using namespace std;
+
+class MyDB_PinQuota;
+typedef shared_ptr <MyDB_PinQuota> MyDB_PinQuotaPtr;
+
+// a limit on the number of pages that one consumer (an operator, a query) may
+// have pinned at once, so that no consumer can pin the whole buffer and starve
+// the others.  A pin is charged to the quota that it was asked for with, and
+// is given back when the page is unpinned
+class MyDB_PinQuota {
+
+public:
+
+	// creates a quota that allows at most maxPinned pages to be pinned
+	MyDB_PinQuota (size_t maxPinnedIn) {
+		maxPinned = maxPinnedIn;
+		numPinned = 0;
+	}
+
+	// the number of pages currently pinned under this quota
+	size_t getNumPinned () {
+		return numPinned;
+	}
+
+	size_t getMaxPinned () {
+		return maxPinned;
+	}
+
+private:
+
+	friend class MyDB_BufferManager;
+
+	// takes one more pin from the quota; returns false if it is used up
+	bool charge () {
+		size_t old = numPinned;
+		while (old < maxPinned) {
+			if (numPinned.compare_exchange_weak (old, old + 1))
+				return true;
+		}
+		return false;
+	}
+
+	// gives back a pin
+	void credit () {
+		numPinned--;
+	}
+
+	size_t maxPinned;
+	atomic <size_t> numPinned;
+};
+
+#endif
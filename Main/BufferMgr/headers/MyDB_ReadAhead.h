@@ -0,0 +1,103 @@
+
+#ifndef READ_AHEAD_H
+#define READ_AHEAD_H
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include "MyDB_ReplacementPolicy.h"
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+class MyDB_ReadAhead;
+typedef shared_ptr <MyDB_ReadAhead> MyDB_ReadAheadPtr;
+
+// reads table pages in the background, on a small pool of I/O threads, so that
+// a sequential scan does not stall on every page fault.  Pages are read into
+// staging buffers owned by this object rather than into the buffer pool; when
+// the buffer manager misses on a page that has been read ahead, it copies the
+// staged bytes into the frame instead of going to disk.  That way, the I/O
+// threads never kick anything out of the buffer, and the bytes of an unpinned
+// page stay put until the thread that is using them calls the buffer manager
+class MyDB_ReadAhead {
+
+public:
+
+	// sets up a read-ahead pool with numBuffers staging buffers of pageSize bytes
+	// each, served by numThreads I/O threads (which are started when the first
+	// page is requested)
+	MyDB_ReadAhead (size_t pageSize, size_t numBuffers, size_t numThreads);
+
+	// stops the I/O threads and frees the staging buffers
+	~MyDB_ReadAhead ();
+
+	// asks that the page at position pos of the file fd (which belongs to the
+	// table with the given id) be read in the background; this is just a hint,
+	// and it is ignored if there are no staging buffers to spare
+	void request (long tableID, int fd, size_t pos);
+
+	// if the page has been (or is being) read ahead, waits for the read to finish,
+	// copies the bytes into intoMe, and returns true; otherwise, returns false
+	bool consume (long tableID, size_t pos, void *intoMe);
+
+	// the page is about to be written to disk, so any staged copy is out of date
+	void invalidate (long tableID, size_t pos);
+
+	// the number of page misses that were served from a staged copy
+	size_t getNumHits ();
+
+private:
+
+	// the states that a staged page goes through
+	enum EntryState {Queued, Reading, Done, Dropped};
+
+	struct Entry {
+		long tableID;
+		int fd;
+		size_t pos;
+		void *bytes;
+		EntryState state;
+		long seqNum;
+	};
+
+	typedef shared_ptr <Entry> EntryPtr;
+
+	// the loop run by each of the I/O threads
+	void work ();
+
+	// removes the entry, and gives its buffer back if no I/O thread is using it...
+	// the caller must hold the latch
+	void drop (EntryPtr dropMe);
+
+	// protects everything below
+	mutex latch;
+
+	// signaled when there is work to do, and when a read finishes
+	condition_variable workReady;
+	condition_variable readDone;
+
+	// all of the pages that are queued, being read, or staged
+	unordered_map <PageKey, EntryPtr, PageKeyHash> entries;
+
+	// the pages that are waiting for an I/O thread
+	deque <EntryPtr> todo;
+
+	// the staging buffers that are not in use
+	vector <void *> freeBuffers;
+
+	// the I/O threads, and whether they have been asked to quit
+	vector <thread> workers;
+	bool stopping;
+
+	size_t pageSize;
+	size_t numBuffers;
+	size_t numThreads;
+	long nextSeqNum;
+	size_t numHits;
+};
+
+#endif
@@ -0,0 +1,75 @@
+
+#ifndef REPLACEMENT_POLICY_H
+#define REPLACEMENT_POLICY_H
+
+#include <functional>
+#include <memory>
+#include "MyDB_Page.h"
+#include <utility>
+
+using namespace std;
+
+// this lists all of the different replacement policies that the buffer manager
+// can be created with
+enum MyDB_PolicyType {LRUReplacement, LRUKReplacement, TwoQReplacement, ClockProReplacement};
+
+// identifies a page by (table id, page number), so that a policy can remember
+// things about a page after the page object itself is gone
+typedef pair <long, size_t> PageKey;
+
+struct PageKeyHash {
+	size_t operator() (const PageKey &key) const {
+		return hash <long> () (key.first) * 31 + hash <size_t> () (key.second);
+	}
+};
+
+class MyDB_ReplacementPolicy;
+typedef shared_ptr <MyDB_ReplacementPolicy> MyDB_ReplacementPolicyPtr;
+
+// a replacement policy decides which buffered page gets kicked out when the
+// buffer manager needs RAM.  It only ever sees pages that are buffered and not
+// pinned; every such page is "in" the policy.  All of the bookkeeping that a
+// policy needs on a resident page is stored in the page itself, so that the
+// common operation (touch) is cheap
+class MyDB_ReplacementPolicy {
+
+public:
+
+	// creates a policy of the given type for a buffer with numPages pages
+	static MyDB_ReplacementPolicyPtr create (MyDB_PolicyType type, size_t numPages);
+
+	// the page has just been read into RAM, and it can now be kicked out
+	virtual void pageIn (MyDB_Page *page) = 0;
+
+	// the page was pinned, and now it is not, so it can be kicked out again
+	virtual void unpinned (MyDB_Page *page) = 0;
+
+	// the page, which is in the policy, has just been accessed
+	virtual void touch (MyDB_Page *page) = 0;
+
+	// the page, which is in the policy, is being pinned or thrown away
+	virtual void remove (MyDB_Page *page) = 0;
+
+	// chooses a page to kick out, removes it from the policy, and returns it;
+	// returns nullptr if there are no pages in the policy
+	virtual MyDB_Page *victim () = 0;
+
+	// the number of pages in the policy
+	virtual size_t size () = 0;
+
+	// true iff the page is in the policy
+	bool contains (MyDB_Page *page) {
+		return page->inPolicy;
+	}
+
+	virtual ~MyDB_ReplacementPolicy () {}
+
+protected:
+
+	static PageKey keyOf (MyDB_Page *page) {
+		return make_pair (page->tableID, page->pos);
+	}
+};
+
+#endif
+
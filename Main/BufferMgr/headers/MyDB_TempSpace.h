@@ -0,0 +1,140 @@
+
+#ifndef TEMP_SPACE_H
+#define TEMP_SPACE_H
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class MyDB_TempSpace;
+typedef shared_ptr <MyDB_TempSpace> MyDB_TempSpacePtr;
+
+class MyDB_TempRegion;
+typedef shared_ptr <MyDB_TempRegion> MyDB_TempRegionPtr;
+
+// manages the slots that temp pages are written to.  The slots are handed out
+// in extents of contiguous pages, and the extents are spread round-robin over
+// one or more temp files (say, one per disk).  A slot is named by a single
+// number, its position, which is what the buffer manager uses as the page
+// number of a temp page.
+//
+// Pages that are asked for without a region share a default set of extents,
+// and their slots are recycled lowest-first, as soon as they are freed.  Pages
+// asked for in a region (one per operator, or per spilled run) are laid out one
+// after another in the region's own extents, so they can be written and read
+// back sequentially; an extent of a region is given back to the file system
+// (by punching a hole, or by truncating the file) once all of its pages are gone
+class MyDB_TempSpace {
+
+public:
+
+	// the temp pages go to the given files; each one is opened with openMe the
+	// first time that it is needed, and is deleted when this goes away
+	MyDB_TempSpace (vector <string> fileNames, size_t pageSize, function <int (string)> openMe);
+	~MyDB_TempSpace ();
+
+	// use these files instead; this can only be done before any slot is handed out
+	bool setFiles (vector <string> fileNames);
+
+	// hands out a slot for a page in the given region (nullptr for the default one)
+	size_t allocate (MyDB_TempRegion *inMe);
+
+	// gives back a slot
+	void release (size_t pos);
+
+	// finds the file (and the position within the file) that the slot is in
+	void locate (size_t pos, int &fd, size_t &filePos);
+
+	// the number of slots that are in use, and the number of pages that the
+	// temp files take up on disk
+	size_t getNumPages ();
+	size_t getNumFilePages ();
+
+private:
+
+	friend class MyDB_TempRegion;
+
+	// the region is done with the extent it has been filling up
+	void retire (long extent);
+
+	// returns the number of an unused extent (creating one if needed) and gives
+	// it to the given owner; the caller must hold the latch
+	long newExtent (int owner);
+
+	// gives an extent, none of whose pages are in use, back to the file system;
+	// the caller must hold the latch
+	void freeExtent (long extent);
+
+	// returns the FD of the given file, opening it if needed; the caller must
+	// hold the latch
+	int fdFor (size_t whichFile);
+
+	// an extent is either free, part of the default extents, or owned by a region
+	enum {FreeExtent, DefaultExtent, RegionExtent};
+
+	struct Extent {
+
+		// who the extent belongs to
+		int owner;
+
+		// the number of its slots that have been handed out, and how many of
+		// those are still in use
+		size_t numAllocated;
+		size_t numLive;
+
+		// true if the owner will not hand out any more of its slots
+		bool retired;
+	};
+
+	// protects everything
+	mutex latch;
+
+	// all of the extents; extent i lives in file i % fileNames.size ()
+	vector <Extent> extents;
+
+	// extents that are free; may also contain extents that have since been
+	// truncated away or re-used, which are skipped over
+	priority_queue <long, vector <long>, greater <long>> freeExtents;
+
+	// the slots of the default extents that are not in use, and the default
+	// extent that new slots are taken from (-1 if none)
+	priority_queue <size_t, vector <size_t>, greater <size_t>> freeSlots;
+	long defaultExtent;
+
+	// the files, and their FDs (-1 if not open yet)
+	vector <string> fileNames;
+	vector <int> fds;
+	function <int (string)> openMe;
+
+	size_t pageSize;
+
+	// the number of slots in use
+	size_t numLive;
+};
+
+// the extents that one consumer of temp pages writes its pages into
+class MyDB_TempRegion {
+
+public:
+
+	MyDB_TempRegion (MyDB_TempSpacePtr space);
+
+	// the region's last extent can be given back once its pages are gone
+	~MyDB_TempRegion ();
+
+private:
+
+	friend class MyDB_TempSpace;
+
+	MyDB_TempSpacePtr space;
+
+	// the extent that pages are currently being put into; -1 if none
+	long extent;
+};
+
+#endif
@@ -0,0 +1,83 @@
+
+#ifndef PAGE_LIST_H
+#define PAGE_LIST_H
+
+#include "MyDB_Page.h"
+
+// an intrusive, doubly-linked list of pages, running from the head (the most
+// recently inserted page) to the tail.  The links live inside of the pages
+// themselves, so inserting, removing, and moving a page are all O(1) and never
+// allocate.  A page can be in at most one PageList at a time
+class PageList {
+
+public:
+
+	PageList () {
+		head = nullptr;
+		tail = nullptr;
+		count = 0;
+	}
+
+	// adds the page at the head of the list
+	void pushFront (MyDB_Page *page) {
+		page->policyPrev = nullptr;
+		page->policyNext = head;
+		if (head != nullptr)
+			head->policyPrev = page;
+		else
+			tail = page;
+		head = page;
+		count++;
+	}
+
+	// removes the page from wherever it is in the list
+	void remove (MyDB_Page *page) {
+		if (page->policyPrev != nullptr)
+			page->policyPrev->policyNext = page->policyNext;
+		else
+			head = page->policyNext;
+
+		if (page->policyNext != nullptr)
+			page->policyNext->policyPrev = page->policyPrev;
+		else
+			tail = page->policyPrev;
+
+		page->policyPrev = nullptr;
+		page->policyNext = nullptr;
+		count--;
+	}
+
+	// moves the page to the head of the list
+	void moveToFront (MyDB_Page *page) {
+		if (head == page)
+			return;
+		remove (page);
+		pushFront (page);
+	}
+
+	// returns the page at the tail of the list; nullptr if the list is empty
+	MyDB_Page *back () {
+		return tail;
+	}
+
+	// removes and returns the page at the tail of the list; nullptr if empty
+	MyDB_Page *popBack () {
+		MyDB_Page *returnVal = tail;
+		if (returnVal != nullptr)
+			remove (returnVal);
+		return returnVal;
+	}
+
+	size_t size () {
+		return count;
+	}
+
+private:
+
+	MyDB_Page *head;
+	MyDB_Page *tail;
+	size_t count;
+};
+
+#endif
+
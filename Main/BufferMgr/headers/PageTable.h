@@ -0,0 +1,134 @@
+
+#ifndef PAGE_TABLE_H
+#define PAGE_TABLE_H
+
+#include <functional>
+#include "MyDB_Page.h"
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+// an open-addressing (linear probing) hash table that maps a (table id, page
+// number) pair to the page object.  Temp pages use a table id of -1.  A lookup
+// is a single probe sequence over a flat array, with no tree walk and no
+// shared_ptr comparisons
+class PageTable {
+
+public:
+
+	PageTable () {
+		numUsed = 0;
+		slots.resize (16);
+	}
+
+	// returns the page stored under the given key; nullptr if there is none
+	MyDB_PagePtr find (long tableID, size_t pos) {
+		Slot &slot = slots[probe (tableID, pos)];
+		return slot.page;
+	}
+
+	// returns a reference to the entry for the given key, creating an empty
+	// entry if there is none... if the returned pointer is nullptr, the caller
+	// is expected to store a page into it
+	MyDB_PagePtr &findOrInsert (long tableID, size_t pos) {
+
+		// grow first, so that the probe below stays valid
+		if ((numUsed + 1) * 2 > slots.size ())
+			grow ();
+
+		Slot &slot = slots[probe (tableID, pos)];
+		if (slot.page == nullptr) {
+			slot.tableID = tableID;
+			slot.pos = pos;
+			numUsed++;
+		}
+		return slot.page;
+	}
+
+	// removes the entry for the given key, if there is one
+	void erase (long tableID, size_t pos) {
+
+		size_t mask = slots.size () - 1;
+		size_t hole = probe (tableID, pos);
+		if (slots[hole].page == nullptr)
+			return;
+
+		slots[hole].page = nullptr;
+		numUsed--;
+
+		// shift back any later entries in the run that would no longer be
+		// reachable across the hole; this avoids the need for tombstones
+		for (size_t i = (hole + 1) & mask; slots[i].page != nullptr; i = (i + 1) & mask) {
+			size_t home = hash (slots[i].tableID, slots[i].pos) & mask;
+			if (((i - home) & mask) >= ((i - hole) & mask)) {
+				slots[hole] = slots[i];
+				slots[i].page = nullptr;
+				hole = i;
+			}
+		}
+	}
+
+	// calls the given function on every page in the table
+	void forEach (function <void (MyDB_PagePtr &)> doMe) {
+		for (Slot &slot : slots) {
+			if (slot.page != nullptr)
+				doMe (slot.page);
+		}
+	}
+
+	// removes everything
+	void clear () {
+		vector <Slot> empty (16);
+		slots.swap (empty);
+		numUsed = 0;
+	}
+
+	size_t size () {
+		return numUsed;
+	}
+
+private:
+
+	struct Slot {
+		long tableID;
+		size_t pos;
+		MyDB_PagePtr page;
+	};
+
+	static size_t hash (long tableID, size_t pos) {
+		uint64_t h = (((uint64_t) tableID) << 40) ^ (uint64_t) pos;
+		h *= 0x9E3779B97F4A7C15ULL;
+		return (size_t) (h ^ (h >> 29));
+	}
+
+	// returns the slot holding the key, or the empty slot where it would go
+	size_t probe (long tableID, size_t pos) {
+		size_t mask = slots.size () - 1;
+		size_t i = hash (tableID, pos) & mask;
+		while (slots[i].page != nullptr && (slots[i].tableID != tableID || slots[i].pos != pos))
+			i = (i + 1) & mask;
+		return i;
+	}
+
+	// doubles the size of the table
+	void grow () {
+		vector <Slot> oldSlots (slots.size () * 2);
+		slots.swap (oldSlots);
+		size_t mask = slots.size () - 1;
+		for (Slot &slot : oldSlots) {
+			if (slot.page == nullptr)
+				continue;
+			size_t i = hash (slot.tableID, slot.pos) & mask;
+			while (slots[i].page != nullptr)
+				i = (i + 1) & mask;
+			slots[i] = std::move (slot);
+		}
+	}
+
+	vector <Slot> slots;
+	size_t numUsed;
+};
+
+#endif
+
@@ -0,0 +1,53 @@
+
+#ifndef TWOQ_POLICY_H
+#define TWOQ_POLICY_H
+
+#include "MyDB_ReplacementPolicy.h"
+#include "PageList.h"
+#include <queue>
+#include <unordered_map>
+
+// the full version of 2Q (Johnson and Shasha).  A page that is read in for the
+// first time goes into A1in, a FIFO queue; accessing it again while it is there
+// does nothing.  When a page is kicked out of A1in, its id is remembered in
+// A1out.  A page that is read in while its id is in A1out has proven that it is
+// referenced repeatedly, so it goes into Am, which is managed as LRU.  A scan
+// only ever cycles through A1in, so it cannot flush the pages in Am
+class TwoQPolicy : public MyDB_ReplacementPolicy {
+
+public:
+
+	// creates the policy for a buffer with numPages pages
+	TwoQPolicy (size_t numPages);
+
+	void pageIn (MyDB_Page *page) override;
+	void unpinned (MyDB_Page *page) override;
+	void touch (MyDB_Page *page) override;
+	void remove (MyDB_Page *page) override;
+	MyDB_Page *victim () override;
+	size_t size () override;
+
+private:
+
+	// the values of MyDB_Page::policyState for the two resident queues
+	enum {InA1in = 1, InAm = 2};
+
+	// resident pages that have been read in once, newest first
+	PageList a1in;
+
+	// resident pages that are known to be hot, from MRU to LRU
+	PageList am;
+
+	// ids of the pages that were recently kicked out of A1in; the queue gives
+	// the order in which they were kicked out, and may have stale entries
+	unordered_map <PageKey, long, PageKeyHash> a1out;
+	queue <pair <PageKey, long>> a1outOrder;
+	long numKickedOut;
+
+	// the target size of A1in, and the number of ids that A1out remembers
+	size_t kin;
+	size_t kout;
+};
+
+#endif
+
@@ -0,0 +1,144 @@
+
+#ifndef CLOCK_PRO_POLICY_C
+#define CLOCK_PRO_POLICY_C
+
+#include "ClockProPolicy.h"
+
+ClockProPolicy :: ClockProPolicy (size_t numPages) {
+	capacity = numPages;
+	if (capacity < 2)
+		capacity = 2;
+	coldTarget = 1;
+	numKickedOut = 0;
+}
+
+void ClockProPolicy :: promote (MyDB_Page *page) {
+	page->policyState = Hot;
+	page->refBit = false;
+	hot.pushFront (page);
+	runHotHand ();
+}
+
+void ClockProPolicy :: runHotHand () {
+
+	// each page either gets its reference bit cleared or gets demoted, so this
+	// sweeps the hot pages at most twice
+	while (hot.size () > capacity - coldTarget) {
+		MyDB_Page *page = hot.popBack ();
+		if (page->refBit) {
+			page->refBit = false;
+			hot.pushFront (page);
+		} else {
+			page->policyState = Cold;
+			cold.pushFront (page);
+		}
+	}
+}
+
+void ClockProPolicy :: pageIn (MyDB_Page *page) {
+
+	page->inPolicy = true;
+	page->refBit = false;
+
+	// if this is a non-resident test page, it was re-referenced during its test
+	// period, so it comes back in hot and we should keep more cold pages around
+	auto it = test.find (keyOf (page));
+	if (it != test.end ()) {
+		test.erase (it);
+		if (coldTarget < capacity - 1)
+			coldTarget++;
+		promote (page);
+		return;
+	}
+
+	page->policyState = ColdInTest;
+	cold.pushFront (page);
+}
+
+void ClockProPolicy :: unpinned (MyDB_Page *page) {
+
+	page->inPolicy = true;
+	if (page->policyState == Hot) {
+		hot.pushFront (page);
+		runHotHand ();
+	} else {
+		if (page->policyState != Cold)
+			page->policyState = ColdInTest;
+		cold.pushFront (page);
+	}
+}
+
+void ClockProPolicy :: touch (MyDB_Page *page) {
+	page->refBit = true;
+}
+
+void ClockProPolicy :: remove (MyDB_Page *page) {
+	page->inPolicy = false;
+	if (page->policyState == Hot)
+		hot.remove (page);
+	else
+		cold.remove (page);
+}
+
+MyDB_Page *ClockProPolicy :: victim () {
+
+	while (true) {
+
+		// if there are no cold pages, demote a hot one
+		if (cold.size () == 0) {
+			MyDB_Page *page = hot.popBack ();
+			if (page == nullptr)
+				return nullptr;
+			page->policyState = Cold;
+			page->refBit = false;
+			cold.pushFront (page);
+		}
+
+		// run the cold hand
+		MyDB_Page *page = cold.popBack ();
+
+		// a referenced cold page is either promoted (if it was re-referenced during
+		// its test period) or starts a new test period
+		if (page->refBit) {
+			page->refBit = false;
+			if (page->policyState == ColdInTest) {
+				promote (page);
+			} else {
+				page->policyState = ColdInTest;
+				cold.pushFront (page);
+			}
+			continue;
+		}
+
+		// otherwise, this is the page to kick out
+		page->inPolicy = false;
+		if (page->policyState == ColdInTest) {
+
+			PageKey key = keyOf (page);
+			test[key] = ++numKickedOut;
+			testOrder.push (make_pair (key, numKickedOut));
+
+			// end the oldest test periods if we remember too many pages; each one
+			// that ends without a re-reference means we need fewer cold pages
+			while (testOrder.size () > capacity) {
+				auto oldest = testOrder.front ();
+				testOrder.pop ();
+				auto it = test.find (oldest.first);
+				if (it != test.end () && it->second == oldest.second) {
+					test.erase (it);
+					if (coldTarget > 1)
+						coldTarget--;
+				}
+			}
+		}
+
+		return page;
+	}
+}
+
+size_t ClockProPolicy :: size () {
+	return cold.size () + hot.size ();
+}
+
+#endif
+
@@ -0,0 +1,105 @@
+
+#ifndef LRUK_POLICY_C
+#define LRUK_POLICY_C
+
+#include "LRUKPolicy.h"
+
+LRUKPolicy :: LRUKPolicy (size_t numPages) {
+	maxHistory = numPages;
+	now = 0;
+}
+
+void LRUKPolicy :: reference (MyDB_Page *page) {
+
+	now++;
+
+	// a correlated reference just moves the last reference time
+	if (page->lastTick != -1 && now - page->lastTick <= correlatedPeriod) {
+		page->lastTick = now;
+		return;
+	}
+
+	page->histTick = page->lastTick;
+	page->lastTick = now;
+}
+
+void LRUKPolicy :: place (MyDB_Page *page) {
+	if (page->histTick == -1)
+		once.pushFront (page);
+	else
+		twice.insert (make_pair (page->histTick, page));
+}
+
+void LRUKPolicy :: unplace (MyDB_Page *page) {
+	if (page->histTick == -1)
+		once.remove (page);
+	else
+		twice.erase (make_pair (page->histTick, page));
+}
+
+void LRUKPolicy :: pageIn (MyDB_Page *page) {
+
+	// see if we remember the last time this page was referenced
+	auto it = history.find (keyOf (page));
+	if (it != history.end ()) {
+		page->lastTick = it->second;
+		history.erase (it);
+	}
+
+	reference (page);
+	page->inPolicy = true;
+	place (page);
+}
+
+void LRUKPolicy :: unpinned (MyDB_Page *page) {
+	page->inPolicy = true;
+	place (page);
+}
+
+void LRUKPolicy :: touch (MyDB_Page *page) {
+	unplace (page);
+	reference (page);
+	place (page);
+}
+
+void LRUKPolicy :: remove (MyDB_Page *page) {
+	page->inPolicy = false;
+	unplace (page);
+}
+
+MyDB_Page *LRUKPolicy :: victim () {
+
+	// pages with only one reference go first
+	MyDB_Page *returnVal = once.popBack ();
+	if (returnVal == nullptr) {
+		if (twice.empty ())
+			return nullptr;
+		returnVal = twice.begin ()->second;
+		twice.erase (twice.begin ());
+	}
+	returnVal->inPolicy = false;
+
+	// remember when this page was last referenced
+	PageKey key = keyOf (returnVal);
+	history[key] = returnVal->lastTick;
+	historyOrder.push (make_pair (key, returnVal->lastTick));
+
+	// and forget the oldest page, if we are remembering too many; note that the
+	// entry in the queue may be stale if the page has since come back
+	while (historyOrder.size () > maxHistory) {
+		auto oldest = historyOrder.front ();
+		historyOrder.pop ();
+		auto it = history.find (oldest.first);
+		if (it != history.end () && it->second == oldest.second)
+			history.erase (it);
+	}
+
+	return returnVal;
+}
+
+size_t LRUKPolicy :: size () {
+	return once.size () + twice.size ();
+}
+
+#endif
+
@@ -13,10 +13,18 @@
 #ifndef BUFFER_MGR_C
 #define BUFFER_MGR_C
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
 #include <fcntl.h>
 #include <iostream>
 #include "MyDB_BufferManager.h"
 #include "MyDB_Page.h"
+#include "MyDB_PageHeader.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/uio.h>
 #include <unistd.h>
@@ -24,251 +32,1289 @@
 
 using namespace std;
 
+// the buffer is split into at most this many shards, and each shard manages at
+// least this many pages on average; small buffers get a single shard
+#define MAX_SHARDS 16
+#define MIN_PAGES_PER_SHARD 64
+
+// the number of pages that a scan keeps in flight ahead of itself, and the
+// number of threads that do the reading
+#define READ_AHEAD_PAGES 16
+#define NUM_IO_THREADS 2
+
+// how often the flusher wakes up to write back dirty pages that no one is using
+#define FLUSH_INTERVAL_MS 100
+
+// the flusher is also woken up early after this many dirty pages have been
+// kicked out (and so written back one at a time) from a shard
+#define FLUSH_AFTER_EVICTIONS 64
+
+// for direct I/O, frames are aligned (and sized) to this many bytes; otherwise,
+// they are aligned to a cache line
+#define DIRECT_IO_ALIGNMENT 4096
+#define FRAME_ALIGNMENT 64
+
+// the size of a huge page, which the frame arena is backed with if it is big enough
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// by default, how long a request for RAM waits for a page to be unpinned when
+// every page in the buffer is pinned
+#define DEFAULT_FRAME_WAIT_MS 1000
+
 size_t MyDB_BufferManager :: getPageSize () {
 	return pageSize;
 }
 
-MyDB_PageHandle MyDB_BufferManager :: getPage (MyDB_TablePtr whichTable, long i) {
-		
-	// open the file, if it is not open
-	if (fds.count (whichTable) == 0) {
-		int fd = open (whichTable->getStorageLoc ().c_str (), O_CREAT | O_RDWR, 0666);
-		fds[whichTable] = fd;
+// used to give every buffer manager its own serial number
+static atomic <long> nextSerialNum (0);
+
+// the number of microseconds since the given time
+static size_t microsSince (chrono::steady_clock::time_point start) {
+	return chrono::duration_cast <chrono::microseconds> (chrono::steady_clock::now () - start).count ();
+}
+
+// writes the given buffers out to the file, starting at the given position; a
+// write that is cut short (or interrupted by a signal) is picked up where it left
+// off.  Returns false if the write fails
+static bool writeFully (int fd, struct iovec *iov, int count, off_t pos) {
+	while (count > 0) {
+		ssize_t numWritten = pwritev (fd, iov, count, pos);
+		if (numWritten < 0 && errno == EINTR)
+			continue;
+		if (numWritten <= 0)
+			return false;
+
+		// skip over the buffers that made it, and into the one that did not
+		pos += numWritten;
+		while (count > 0 && (size_t) numWritten >= iov->iov_len) {
+			numWritten -= iov->iov_len;
+			iov++;
+			count--;
+		}
+		if (count > 0) {
+			iov->iov_base = (char *) iov->iov_base + numWritten;
+			iov->iov_len -= numWritten;
+		}
+	}
+	return true;
+}
+
+size_t MyDB_BufferManager :: getNumHits () {
+	return sumCounter (HitCount);
+}
+
+size_t MyDB_BufferManager :: getNumMisses () {
+	return sumCounter (MissCount);
+}
+
+size_t MyDB_BufferManager :: getNumReadAheadHits () {
+	return readAheadPool->getNumHits ();
+}
+
+MyDB_ThreadStats &MyDB_BufferManager :: myStats () {
+
+	// each thread remembers its counters for every buffer manager that it uses
+	static thread_local vector <pair <long, shared_ptr <MyDB_ThreadStats>>> mine;
+	for (auto &entry : mine) {
+		if (entry.first == serialNum)
+			return *entry.second;
+	}
+
+	// this is the first time that this thread has used this buffer manager; while we
+	// are at it, forget the counters of any buffer manager that has gone away
+	mine.erase (remove_if (mine.begin (), mine.end (), [] (pair <long, shared_ptr <MyDB_ThreadStats>> &entry) {
+		return entry.second.use_count () == 1;
+	}), mine.end ());
+
+	shared_ptr <MyDB_ThreadStats> returnVal = make_shared <MyDB_ThreadStats> ();
+	{
+		lock_guard <mutex> guard (statsLatch);
+		allThreadStats.push_back (returnVal);
+	}
+	mine.push_back (make_pair (serialNum, returnVal));
+	return *returnVal;
+}
+
+size_t MyDB_BufferManager :: sumCounter (MyDB_StatCounter which) {
+	lock_guard <mutex> guard (statsLatch);
+	size_t returnVal = 0;
+	for (auto &stats : allThreadStats)
+		returnVal += stats->counters[which];
+	return returnVal;
+}
+
+MyDB_BufferStats MyDB_BufferManager :: getStats () {
+
+	MyDB_BufferStats returnVal;
+
+	// add up the counters of all of the threads
+	{
+		lock_guard <mutex> guard (statsLatch);
+		for (auto &stats : allThreadStats) {
+			returnVal.numHits += stats->counters[HitCount];
+			returnVal.numMisses += stats->counters[MissCount];
+			returnVal.numEvictions += stats->counters[EvictionCount];
+			returnVal.numWriteBacks += stats->counters[WriteBackCount];
+			returnVal.numWriteFailures += stats->counters[WriteFailureCount];
+			returnVal.numPinFailures += stats->counters[PinFailureCount];
+			returnVal.numChecksumFailures += stats->counters[ChecksumFailureCount];
+			returnVal.numLogWaits += stats->counters[LogWaitCount];
+			for (int i = 0; i < NUM_LATENCY_BUCKETS; i++) {
+				returnVal.readLatency[i] += stats->readLatency[i];
+				returnVal.writeLatency[i] += stats->writeLatency[i];
+			}
+		}
+	}
+
+	if (readAheadPool != nullptr)
+		returnVal.numReadAheadHits = readAheadPool->getNumHits ();
+
+	// look at what is in the buffer, one shard at a time
+	returnVal.numFrames = numPages;
+	for (auto &shard : shards) {
+		lock_guard <mutex> guard (shard->latch);
+		shard->allPages.forEach ([&] (MyDB_PagePtr &page) {
+			if (page->bytes == nullptr || page->isMapped)
+				return;
+			returnVal.residentPages[page->myTable == nullptr ? "(temp)" : page->myTable->getName ()]++;
+			if (!shard->policy->contains (page.get ()))
+				returnVal.numPinnedPages++;
+		});
+	}
+
+	{
+		lock_guard <mutex> guard (ramLatch);
+		returnVal.numFreeFrames = freeFrames.size ();
+	}
+
+	returnVal.tempFilePages = tempSpace->getNumPages ();
+	returnVal.tempSpacePages = tempSpace->getNumFilePages ();
+
+	if (log != nullptr) {
+		returnVal.numLogGroups = log->getNumGroups ();
+		returnVal.numLogSyncs = log->getNumSyncs ();
+	}
+
+	return returnVal;
+}
+
+void MyDB_BufferManager :: setChecksums (bool on) {
+	checksums = on;
+}
+
+void MyDB_BufferManager :: setFrameWaitTimeout (size_t millis) {
+	frameWaitTimeout = millis;
+}
+
+size_t MyDB_BufferManager :: getNumUnpinnedFrames () {
+	size_t numPinned = 0;
+	for (auto &shard : shards) {
+		lock_guard <mutex> guard (shard->latch);
+		shard->allPages.forEach ([&] (MyDB_PagePtr &page) {
+			if (page->bytes != nullptr && !page->isMapped && !shard->policy->contains (page.get ()))
+				numPinned++;
+		});
 	}
+	return numPages - numPinned;
+}
+
+void MyDB_BufferManager :: dumpStatsEvery (size_t millis, ostream &toMe) {
+	lock_guard <mutex> guard (flusherLatch);
+	statsInterval = millis;
+	statsOut = &toMe;
+}
+
+size_t MyDB_BufferManager :: getReadAheadPages () {
+	return READ_AHEAD_PAGES;
+}
+
+void MyDB_BufferManager :: readAhead (MyDB_TablePtr whichTable, long lowPage, long highPage) {
 
 	// make sure we don't have a null table
 	if (whichTable == nullptr) {
-		cout << "Can't allocate a page with a null table!!\n";
+		cout << "Can't read ahead from a null table!!\n";
 		exit (1);
 	}
-	
-	// next, see if the page is already in existence
-	pair <MyDB_TablePtr, long> whichPage = make_pair (whichTable, i);
-	if (allPages.count (whichPage) == 0) {
 
-		// it is not there, so create a page
-		MyDB_PagePtr returnVal = make_shared <MyDB_Page> (whichTable, i, *this);
-		allPages [whichPage] = returnVal;
-		return make_shared <MyDB_PageHandleBase> (returnVal);
+	int fd = openFile (whichTable);
+	long id = whichTable->getID ();
+
+	// if the table is mapped, the OS does the reading; just tell it what is coming
+	char *low = mappedBytes (id, lowPage);
+	if (low != nullptr) {
+		char *high = mappedBytes (id, highPage);
+		size_t osPageSize = sysconf (_SC_PAGESIZE);
+		char *start = (char *) (((size_t) low) / osPageSize * osPageSize);
+		size_t length = (high == nullptr ? low : high) + pageSize - start;
+		madvise (start, length, MADV_SEQUENTIAL);
+		madvise (start, length, MADV_WILLNEED);
+		return;
 	}
 
-	// it is there, so return it
-	return make_shared <MyDB_PageHandleBase> (allPages [whichPage]);
+	for (long i = lowPage; i <= highPage; i++) {
+
+		// there is no need to read a page that is already buffered
+		{
+			Shard &shard = *shards[shardOf (id, i)];
+			lock_guard <mutex> guard (shard.latch);
+			MyDB_PagePtr page = shard.allPages.find (id, i);
+			if (page != nullptr && page->bytes != nullptr)
+				continue;
+		}
+
+		readAheadPool->request (id, fd, i);
+	}
 }
 
-MyDB_PageHandle MyDB_BufferManager :: getPage () {
+void MyDB_BufferManager :: flushTable (MyDB_TablePtr whichTable) {
 
-	// open the file, if it is not open
-	if (fds.count (nullptr) == 0) {
-		int fd = open (tempFile.c_str (), O_TRUNC | O_CREAT | O_RDWR, 0666);
-		fds[nullptr] = fd;
+	// make sure we don't have a null table
+	if (whichTable == nullptr) {
+		cout << "Can't flush a null table!!\n";
+		exit (1);
 	}
 
-	// check if we are extending the size of the temp file
-	size_t pos;
-	if (availablePositions.size () == 0) {
-		pos = lastTempPos++;
-	} else {
-		pos = availablePositions.top ();
-		availablePositions.pop ();
+	flushDirty (whichTable->getID (), false, false);
+}
+
+void MyDB_BufferManager :: flushAll () {
+	flushDirty (-1, false, false);
+}
+
+void MyDB_BufferManager :: flushDirty (long tableID, bool onlyUnused, bool emptyLog) {
+
+	// only one bulk write back at a time
+	lock_guard <mutex> writeBackGuard (writeBackLatch);
+
+	// finds the dirty pages of a shard; a temp page is never written back, since
+	// no one can read it after its handles are gone.  Only the buffer manager hands
+	// out handles, and it needs the shard's latch to do so, so a page that has no
+	// handles cannot be written to by anyone while we hold the latch.  A page with
+	// changes from a logged action that is under way is not written back until
+	// the action ends... the caller must hold the shard's latch
+	auto findDirty = [&] (Shard &shard, vector <MyDB_Page *> &dirty) {
+		shard.allPages.forEach ([&] (MyDB_PagePtr &page) {
+			if (page->bytes != nullptr && page->isDirty && page->myTable != nullptr && !page->isMapped &&
+				!page->inAction && (tableID == -1 || page->tableID == tableID) && 
+				(!onlyUnused || page->refCount == 0))
+				dirty.push_back (page.get ());
+		});
+	};
+
+	// emptying the log means latching every shard until it is done: changes can
+	// only be logged while holding a shard latch, so nothing can be logged
+	// between writing the pages and emptying the log.  Since the shards are always
+	// latched in the same order, and nothing else ever holds more than one shard
+	// latch, this cannot deadlock
+	if (emptyLog) {
+		for (auto &shard : shards)
+			shard->latch.lock ();
+
+		vector <MyDB_Page *> dirty;
+		for (auto &shard : shards)
+			findDirty (*shard, dirty);
+
+		vector <PageImage> images;
+		for (MyDB_Page *page : dirty) {
+			images.push_back ({page, page->bytes, page->lsn});
+			page->isDirty = false;
+		}
+
+		// if a page did not make it to disk, the log is all that has its changes
+		if (writeBack (images) && log != nullptr) {
+			{
+				lock_guard <mutex> guard (fileLatch);
+				for (int fd : fds) {
+					if (fd != -1)
+						fsync (fd);
+				}
+			}
+			log->truncate ();
+		}
+
+		for (auto shard = shards.rbegin (); shard != shards.rend (); shard++)
+			(*shard)->latch.unlock ();
+		return;
 	}
 
-	MyDB_PagePtr returnVal = make_shared <MyDB_Page> (nullptr, pos, *this);
-	pair <MyDB_TablePtr, long> whichPage = make_pair (nullptr, pos);
-	allPages [whichPage] = returnVal;
-	return make_shared <MyDB_PageHandleBase> (returnVal);
+	// otherwise, the shards are gone through one at a time, so that the others can
+	// be used in the meantime.  The pages are copied, so that they can be changed
+	// while they are being written, and held in the buffer until the copies are on
+	// disk; the copies of all of the shards are then written together (so that
+	// consecutive pages, which live in different shards, are still written with
+	// one call) without holding any latch.  A page is marked clean before it is
+	// copied, so any change that is not in the copy dirties it again.  If there
+	// is no RAM for the copies, the pages just stay dirty
+	vector <PageImage> images;
+	vector <MyDB_PageHandle> held;
+	vector <char *> copies;
+	for (auto &shardPtr : shards) {
+		Shard &shard = *shardPtr;
+		lock_guard <mutex> guard (shard.latch);
+
+		vector <MyDB_Page *> dirty;
+		findDirty (shard, dirty);
+		char *copy = nullptr;
+		if (dirty.empty () || posix_memalign ((void **) &copy, DIRECT_IO_ALIGNMENT, dirty.size () * pageSize) != 0)
+			continue;
+		copies.push_back (copy);
+
+		for (size_t i = 0; i < dirty.size (); i++) {
+			MyDB_Page *page = dirty[i];
+			page->isDirty.exchange (false);
+			memcpy (copy + i * pageSize, page->bytes, pageSize);
+			images.push_back ({page, copy + i * pageSize, page->lsn});
+			page->isFlushing = true;
+			if (shard.policy->contains (page)) {
+				shard.policy->remove (page);
+				page->flushPinned = true;
+			}
+			held.push_back (make_shared <MyDB_PageHandleBase> (shard.allPages.find (page->tableID, page->pos)));
+		}
+	}
+
+	writeBack (images);
+	for (char *copy : copies)
+		free (copy);
+
+	// now the pages can be kicked out again; a page that a logged action has
+	// changed in the meantime stays held until the action ends
+	for (PageImage &image : images) {
+		MyDB_Page &page = *image.page;
+		Shard &shard = *shards[shardOf (page.tableID, page.pos)];
+		lock_guard <mutex> guard (shard.latch);
+		page.isFlushing = false;
+		if (page.flushPinned) {
+			page.flushPinned = false;
+			if (page.inAction) {
+				page.actionPinned = true;
+			} else {
+				shard.policy->unpinned (&page);
+				shard.lastAccessed = nullptr;
+				frameMayBeFree ();
+			}
+		}
+	}
+
+	// the handles are dropped without holding any latch
 }
 
-void MyDB_BufferManager :: kickOutPage () {
-	
-	// find the oldest page
-	auto it = lastUsed.begin();
-	auto page = *it;
+bool MyDB_BufferManager :: writeBack (vector <PageImage> &images) {
+
+	sort (images.begin (), images.end (), [] (const PageImage &lhs, const PageImage &rhs) {
+		return lhs.page->tableID < rhs.page->tableID || 
+			(lhs.page->tableID == rhs.page->tableID && lhs.page->pos < rhs.page->pos);
+	});
+
+	// the write-ahead rule: the log has to be on disk up to the last change to
+	// any of the pages before they are
+	if (log != nullptr) {
+		uint64_t lsn = 0;
+		for (PageImage &image : images)
+			lsn = max (lsn, image.lsn);
+		if (lsn > log->getDurableLSN ()) {
+			myStats ().count (LogWaitCount);
+			log->flushTo (lsn);
+		}
+	}
 
-	// write it back if necessary
-	if (page->page->isDirty) {
-		lseek (fds[page->page->myTable], page->page->pos * pageSize, SEEK_SET);
-		write (fds[page->page->myTable], page->page->bytes, pageSize);
-		page->page->isDirty = false;
+	// write each run of consecutive pages with one call; the pages of a run that
+	// cannot be written are dirty again, so that they are written later
+	bool returnVal = true;
+	vector <struct iovec> run;
+	for (size_t i = 0; i < images.size (); i++) {
+
+		if (checksums)
+			MyDB_PageHeader :: stamp (images[i].bytes, pageSize);
+
+		struct iovec next;
+		next.iov_base = images[i].bytes;
+		next.iov_len = pageSize;
+		run.push_back (next);
+
+		bool endOfRun = i + 1 == images.size () || images[i + 1].page->tableID != images[i].page->tableID ||
+			images[i + 1].page->pos != images[i].page->pos + 1 || run.size () == IOV_MAX;
+		if (endOfRun) {
+			size_t firstInRun = i + 1 - run.size ();
+			MyDB_Page *first = images[firstInRun].page;
+			auto start = chrono::steady_clock::now ();
+			bool written = writeFully (first->fd, run.data (), run.size (), first->filePos * pageSize);
+			myStats ().timeWrite (microsSince (start));
+			if (written) {
+				myStats ().count (WriteBackCount, run.size ());
+			} else {
+				myStats ().count (WriteFailureCount, run.size ());
+				for (size_t j = firstInRun; j <= i; j++)
+					images[j].page->isDirty = true;
+				returnVal = false;
+			}
+			run.clear ();
+		}
 	}
 
-	// remove it
-	lastUsed.erase (page);
+	// any copy that was read ahead is now stale
+	if (readAheadPool != nullptr) {
+		for (PageImage &image : images)
+			readAheadPool->invalidate (image.page->tableID, image.page->pos);
+	}
 
-	// and remember its RAM
-	availableRam.push_back (page->page->bytes);
-	page->page->bytes = nullptr;
+	return returnVal;
 }
 
-void MyDB_BufferManager :: killPage (MyDB_Page &killMe) {
-	
-	// we have no refreences left to him
-	killMe.refCount = -1;
+void MyDB_BufferManager :: useLog (string logFile) {
 
-	// if this is a temp page, recycle his slot
-	if (killMe.myTable == nullptr) {
-		availablePositions.push (killMe.pos);
+	if (log != nullptr) {
+		cout << "Already logging!!\n";
+		exit (1);
+	}
+
+	for (auto &shard : shards) {
+		lock_guard <mutex> guard (shard->latch);
+		if (shard->allPages.size () != 0) {
+			cout << "Can't start logging once pages are in use!!\n";
+			exit (1);
+		}
 	}
 
-	// find the page
-	pair <MyDB_TablePtr, long> whichPage = make_pair (killMe.myTable, killMe.pos);
-	if (allPages.count (whichPage) != 0) {
-		auto myPtr = allPages[whichPage];
+	// redo whatever is in the log, straight onto the files; no pages are buffered,
+	// so there is nothing in RAM that could be out of date afterwards
+	MyDB_LogManagerPtr newLog = make_shared <MyDB_LogManager> (logFile, pageSize);
+	{
+		lock_guard <mutex> guard (fileLatch);
+		newLog->recover (recoveredPages);
+	}
+
+	for (auto &shard : shards)
+		shard->latch.lock ();
+	log = newLog;
+	for (auto shard = shards.rbegin (); shard != shards.rend (); shard++)
+		(*shard)->latch.unlock ();
+}
+
+long MyDB_BufferManager :: getRecoveredLastPage (MyDB_TablePtr whichTable) {
+	lock_guard <mutex> guard (fileLatch);
+	auto found = recoveredPages.find (whichTable->getStorageLoc ());
+	if (found == recoveredPages.end ())
+		return -1;
+	return found->second;
+}
+
+void MyDB_BufferManager :: beginAction () {
+
+	if (log == nullptr)
+		return;
+
+	unique_lock <mutex> guard (actionLatch);
+	auto found = actions.find (this_thread :: get_id ());
+	if (found != actions.end ()) {
+		found->second.depth++;
+		return;
+	}
 
-		// special case is when there are no refs left to this page, but he is pinned
-		// in this case... we just unpin him
-		MyDB_PageHandle temp = make_shared <MyDB_PageHandleBase> (myPtr);
-		if (killMe.bytes != nullptr && lastUsed.count (temp) == 0) {
-			temp->page->incRefCount ();
-			unpin (temp);	
+	actionsChanged.wait (guard, [&] {return !checkpointing;});
+	actions[this_thread :: get_id ()].depth = 1;
+}
+
+void MyDB_BufferManager :: endAction () {
+
+	if (log == nullptr)
+		return;
+
+	// only the thread itself ever changes or removes its action, so it can be
+	// used without the latch
+	LoggedAction *action;
+	{
+		lock_guard <mutex> guard (actionLatch);
+		auto found = actions.find (this_thread :: get_id ());
+		if (found == actions.end () || --found->second.depth > 0)
 			return;
+		action = &found->second;
+	}
+
+	// log the changes as one group; the pages are still held, so none of them
+	// can have been written back yet
+	uint64_t lsn = 0;
+	if (!action->changes.isEmpty ())
+		lsn = log->append (action->changes);
+
+	// and let the pages go
+	for (MyDB_PageHandle &handle : action->pages) {
+		MyDB_Page &page = *handle->page;
+		Shard &shard = *shards[shardOf (page.tableID, page.pos)];
+		lock_guard <mutex> guard (shard.latch);
+		page.lsn = lsn;
+		page.inAction = false;
+		if (page.bytes != nullptr && MyDB_PageHeader :: isFormatted (page.bytes))
+			((MyDB_PageHeader *) page.bytes)->lsn = lsn;
+		if (page.actionPinned) {
+			page.actionPinned = false;
+			if (page.isFlushing) {
+				page.flushPinned = true;
+			} else {
+				shard.policy->unpinned (&page);
+				shard.lastAccessed = nullptr;
+			}
+			pinEnded (page);
 		}
+	}
+
+	// the action is only done once its pages are let go, so that a checkpoint
+	// does not skip over them; the handles are dropped without holding any latch
+	vector <MyDB_PageHandle> pages;
+	pages.swap (action->pages);
+	{
+		lock_guard <mutex> guard (actionLatch);
+		actions.erase (this_thread :: get_id ());
+	}
+	actionsChanged.notify_all ();
+}
+
+void MyDB_BufferManager :: logChange (MyDB_Page &changed, size_t offset, size_t len) {
+
+	// temp pages do not outlive the buffer manager, so they are never logged
+	if (log == nullptr || changed.myTable == nullptr || changed.isMapped)
+		return;
+
+	if (offset + len > pageSize) {
+		cout << "Can't log a change past the end of a page!!\n";
+		exit (1);
+	}
+
+	// see if the calling thread is in an action
+	LoggedAction *action = nullptr;
+	{
+		lock_guard <mutex> guard (actionLatch);
+		auto found = actions.find (this_thread :: get_id ());
+		if (found != actions.end ())
+			action = &found->second;
+	}
+
+	Shard &shard = *shards[shardOf (changed.tableID, changed.pos)];
+	lock_guard <mutex> guard (shard.latch);
+
+	// if another thread kicked the page out before we got here, the change is
+	// already on disk, and there is nothing left to log it from
+	if (changed.bytes == nullptr)
+		return;
 
-		// kill from the LRU list, if needed
-		if (lastUsed.count (temp) != 0) {
-			auto page = *(lastUsed.find (temp));
-		       	lastUsed.erase (page);
+	char *bytes = (char *) changed.bytes;
+	if (action == nullptr) {
+		MyDB_LogGroup group;
+		group.add (changed.myTable->getStorageLoc (), changed.pos, offset, bytes + offset, len);
+		changed.lsn = log->append (group);
+		if (MyDB_PageHeader :: isFormatted (bytes))
+			((MyDB_PageHeader *) bytes)->lsn = changed.lsn;
+		return;
+	}
+
+	// the first time that the action changes the page, hold on to it; if it is
+	// not pinned, take it away from the policy so that it is not kicked out
+	action->changes.add (changed.myTable->getStorageLoc (), changed.pos, offset, bytes + offset, len);
+	if (!changed.inAction) {
+		changed.inAction = true;
+		if (shard.policy->contains (&changed)) {
+			shard.policy->remove (&changed);
+			changed.actionPinned = true;
+		} else if (changed.flushPinned) {
+			changed.flushPinned = false;
+			changed.actionPinned = true;
 		}
+		action->pages.push_back (make_shared <MyDB_PageHandleBase> (shard.allPages.find (changed.tableID, changed.pos)));
+	}
+}
 
-		// kill from the list of all pages
-		auto page = allPages.find (whichPage);
-		allPages.erase (page); 
+void MyDB_BufferManager :: commit () {
+	if (log != nullptr)
+		log->flushAll ();
+}
+
+void MyDB_BufferManager :: checkpoint () {
+
+	// wait for the actions that are under way to end, without letting any new ones begin
+	{
+		unique_lock <mutex> guard (actionLatch);
+		actionsChanged.wait (guard, [&] {return !checkpointing;});
+		checkpointing = true;
+		actionsChanged.wait (guard, [&] {return actions.empty ();});
 	}
 
-	// if it is dirty, write it
-	if (killMe.isDirty) {
-		lseek (fds[killMe.myTable], killMe.pos * pageSize, SEEK_SET);
-		write (fds[killMe.myTable], killMe.bytes, pageSize);
-		killMe.isDirty = false;
+	flushDirty (-1, false, true);
+
+	{
+		lock_guard <mutex> guard (actionLatch);
+		checkpointing = false;
 	}
+	actionsChanged.notify_all ();
+}
 
-	// if there is some RAM, remember it
-	if (killMe.bytes != nullptr) {
-		availableRam.push_back (killMe.bytes);
-		killMe.bytes = nullptr;
+void MyDB_BufferManager :: flushInBackground () {
+
+	unique_lock <mutex> guard (flusherLatch);
+	auto lastDump = chrono::steady_clock::now ();
+	while (!flusherStopping) {
+		flusherWake.wait_for (guard, chrono::milliseconds (FLUSH_INTERVAL_MS));
+		if (flusherStopping)
+			return;
+
+		guard.unlock ();
+		flushDirty (-1, true, false);
+		guard.lock ();
+
+		// the stats are printed while holding the latch, so that once the dump is
+		// turned off, nothing is being written to the stream
+		if (statsInterval != 0 && microsSince (lastDump) >= statsInterval * 1000) {
+			getStats ().print (*statsOut);
+			lastDump = chrono::steady_clock::now ();
+		}
 	}
 }
 
-void MyDB_BufferManager :: access (MyDB_Page &updateMeIn) {
+size_t MyDB_BufferManager :: shardOf (long tableID, size_t pos) {
+
+	// consecutive pages of a table go to different shards, so that threads
+	// scanning the same table do not all line up on one latch
+	return (pos + ((size_t) tableID) * 7) & (shards.size () - 1);
+}
+
+MyDB_PageHandle MyDB_BufferManager :: getPage (MyDB_TablePtr whichTable, long i) {
+		
+	// make sure we don't have a null table
+	if (whichTable == nullptr) {
+		cout << "Can't allocate a page with a null table!!\n";
+		exit (1);
+	}
 	
-	// if this page was just accessed, get outta here
-	if (updateMeIn.timeTick > lastTimeTick - (numPages / 2) && updateMeIn.bytes != nullptr) {
+	// open the file, if it is not open
+	int fd = openFile (whichTable);
+
+	// next, see if the page is already in existence; if it is not there, create it
+	long id = whichTable->getID ();
+	Shard &shard = *shards[shardOf (id, i)];
+	lock_guard <mutex> guard (shard.latch);
+	MyDB_PagePtr returnVal = shard.allPages.find (id, i);
+	if (returnVal == nullptr) {
+		returnVal = makePage (whichTable, i, fd);
+		shard.allPages.findOrInsert (id, i) = returnVal;
+	}
+
+	return make_shared <MyDB_PageHandleBase> (returnVal);
+}
+
+MyDB_PagePtr MyDB_BufferManager :: makePage (MyDB_TablePtr whichTable, long i, int fd) {
+	MyDB_PagePtr returnVal = make_shared <MyDB_Page> (whichTable, i, *this);
+	returnVal->fd = fd;
+	returnVal->bytes = mappedBytes (returnVal->tableID, i);
+	if (returnVal->bytes != nullptr) {
+		string problem = checkPage (*returnVal);
+		if (problem != "")
+			throw MyDB_PageCorruptError (problem);
+		returnVal->isMapped = true;
+		returnVal->numBytes = pageSize;
+	}
+	return returnVal;
+}
+
+char *MyDB_BufferManager :: mappedBytes (long tableID, long i) {
+	lock_guard <mutex> guard (fileLatch);
+	if (tableID < 0 || tableID >= (long) mappings.size () || mappings[tableID].first == nullptr)
+		return nullptr;
+	if (i < 0 || (i + 1) * pageSize > mappings[tableID].second)
+		return nullptr;
+	return mappings[tableID].first + i * pageSize;
+}
+
+void MyDB_BufferManager :: mapReadOnly (MyDB_TablePtr whichTable) {
+
+	// make sure we don't have a null table
+	if (whichTable == nullptr) {
+		cout << "Can't map a null table!!\n";
+		exit (1);
+	}
+
+	// the file has to be up to date before we look at it directly
+	flushTable (whichTable);
+
+	int fd = openFile (whichTable);
+	struct stat fileInfo;
+	if (fstat (fd, &fileInfo) != 0 || fileInfo.st_size == 0)
+		return;
+
+	void *mapping = mmap (nullptr, fileInfo.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (mapping == MAP_FAILED)
 		return;
+
+	lock_guard <mutex> guard (fileLatch);
+	size_t id = whichTable->getID ();
+	if (id >= mappings.size ())
+		mappings.resize (id + 1, make_pair ((char *) nullptr, (size_t) 0));
+	if (mappings[id].first != nullptr)
+		oldMappings.push_back (mappings[id]);
+	mappings[id] = make_pair ((char *) mapping, (size_t) fileInfo.st_size);
+}
+
+int MyDB_BufferManager :: openFile (MyDB_TablePtr whichTable) {
+
+	lock_guard <mutex> guard (fileLatch);
+
+	size_t id = whichTable->getID ();
+	if (id >= fds.size ())
+		fds.resize (id + 1, -1);
+
+	if (fds[id] == -1)
+		fds[id] = openForIO (whichTable->getStorageLoc (), O_CREAT | O_RDWR);
+
+	return fds[id];
+}
+
+int MyDB_BufferManager :: openForIO (string fileName, int flags) {
+
+	// not every file system supports O_DIRECT; if this one does not, just
+	// go through the OS page cache
+	if (directIO) {
+		int fd = open (fileName.c_str (), flags | O_DIRECT, 0666);
+		if (fd != -1)
+			return fd;
 	}
 
-	// get the page 
-	pair <MyDB_TablePtr, long> findMe = make_pair (updateMeIn.myTable, updateMeIn.pos);
-	auto updateMe = allPages [findMe];
+	return open (fileName.c_str (), flags, 0666);
+}
 
-	// first, see if it is currently in the LRU list; if so, just remove it
-	MyDB_PageHandle temp = make_shared <MyDB_PageHandleBase> (updateMe);
-	if (lastUsed.count (temp) == 1) {
-		lastUsed.erase (temp);
-		updateMe->timeTick = ++lastTimeTick;
-		lastUsed.insert (temp);
+MyDB_PageHandle MyDB_BufferManager :: getPage () {
+	return getPage (nullptr);
+}
 
-	// verify that we are not pinned
-	} else if (updateMe->bytes == nullptr) {
-		
-		// not in the LRU list means that we don't have its contents buffered
-		// see if there is space
-		if (availableRam.size () == 0)
-			kickOutPage ();
+MyDB_PageHandle MyDB_BufferManager :: getPage (MyDB_TempRegionPtr inMe) {
+
+	// get a slot in the temp space, and find out where it is
+	size_t pos = tempSpace->allocate (inMe.get ());
+	MyDB_PagePtr returnVal = make_shared <MyDB_Page> (nullptr, pos, *this);
+	tempSpace->locate (pos, returnVal->fd, returnVal->filePos);
+
+	Shard &shard = *shards[shardOf (-1, pos)];
+	lock_guard <mutex> guard (shard.latch);
+	shard.allPages.findOrInsert (-1, pos) = returnVal;
+	return make_shared <MyDB_PageHandleBase> (returnVal);
+}
+
+MyDB_TempRegionPtr MyDB_BufferManager :: makeTempRegion () {
+	return make_shared <MyDB_TempRegion> (tempSpace);
+}
+
+void MyDB_BufferManager :: useTempDirectories (vector <string> dirs) {
+
+	// the files are named after the temp file
+	string name = tempFile.substr (tempFile.find_last_of ('/') + 1);
+	vector <string> fileNames;
+	for (string &dir : dirs)
+		fileNames.push_back (dir + "/" + name);
+
+	if (!tempSpace->setFiles (fileNames)) {
+		cout << "Can't change the temp directories once temp pages are in use!!\n";
+		exit (1);
+	}
+}
+
+void *MyDB_BufferManager :: kickOutPage (Shard &fromMe, uint64_t &needLSN) {
+	
+	// find the page to kick out (this also removes it from the policy), and write
+	// it back if necessary; this makes any copy that was read ahead (or that was
+	// being read while we wrote) stale.  A page that cannot be written, or that
+	// cannot be written until the log is flushed (which we do not wait for while
+	// holding the shard's latch), is not kicked out, but given back to the policy
+	// once we have found another one
+	MyDB_ThreadStats &stats = myStats ();
+	vector <MyDB_Page *> unwritten;
+	MyDB_Page *page;
+	while ((page = fromMe.policy->victim ()) != nullptr && page->isDirty) {
+		if (log != nullptr && page->lsn > log->getDurableLSN ()) {
+			needLSN = max (needLSN, page->lsn);
+			unwritten.push_back (page);
+			continue;
+		}
+		page->isDirty = false;
+		if (checksums)
+			MyDB_PageHeader :: stamp (page->bytes, pageSize);
+		struct iovec whole;
+		whole.iov_base = page->bytes;
+		whole.iov_len = pageSize;
+		auto start = chrono::steady_clock::now ();
+		bool written = writeFully (page->fd, &whole, 1, page->filePos * pageSize);
+		stats.timeWrite (microsSince (start));
+		if (!written) {
+			stats.count (WriteFailureCount);
+			page->isDirty = true;
+			unwritten.push_back (page);
+			continue;
+		}
+		stats.count (WriteBackCount);
+		readAheadPool->invalidate (page->tableID, page->pos);
+
+		// if we keep writing pages back one at a time, it is time for the flusher
+		// to write back the others in bulk
+		if (++fromMe.numDirtyEvictions % FLUSH_AFTER_EVICTIONS == 0)
+			flusherWake.notify_one ();
+		break;
+	}
+
+	for (MyDB_Page *giveBack : unwritten)
+		fromMe.policy->unpinned (giveBack);
+	if (page == nullptr)
+		return nullptr;
+	stats.count (EvictionCount);
+
+	// and take its RAM
+	void *returnVal = page->bytes;
+	page->bytes = nullptr;
+
+	// if no one is referencing the page, there is no reason to remember it; note
+	// that this can destroy the page, so it must be the last thing we do with it...
+	// new references are only handed out under the shard's latch, which we hold
+	if (page->refCount == 0)
+		forgetPage (fromMe, *page);
+
+	return returnVal;
+}
+
+void *MyDB_BufferManager :: getFreeFrame (size_t preferMe) {
+
+	// see if there is space
+	{
+		lock_guard <mutex> guard (ramLatch);
+		if (freeFrames.size () != 0) {
+			void *returnVal = frameAt (freeFrames.back ());
+			freeFrames.pop_back ();
+			return returnVal;
+		}
+	}
+
+	// if not, kick out a page; we try our own shard first, and only take a page
+	// from another shard if all of ours are pinned.  Only one latch is held at a
+	// time, so there is no chance of deadlock.  If every page that could be
+	// kicked out is waiting for the log, we flush the log (holding no latch, so
+	// that the shards can be used meanwhile) and try again
+	while (true) {
+		uint64_t needLSN = 0;
+		for (size_t i = 0; i < shards.size (); i++) {
+			Shard &shard = *shards[(preferMe + i) & (shards.size () - 1)];
+			lock_guard <mutex> guard (shard.latch);
+			void *returnVal = kickOutPage (shard, needLSN);
+			if (returnVal != nullptr)
+				return returnVal;
+		}
 
 		// if there is no space, we cannot do anything
-		if (availableRam.size () == 0) {
-			cout << "Can't get any RAM to read a page!!\n";
-			exit (1);
+		if (needLSN == 0)
+			return nullptr;
+
+		myStats ().count (LogWaitCount);
+		log->flushTo (needLSN);
+	}
+}
+
+void *MyDB_BufferManager :: waitForFrame (size_t preferMe) {
+
+	void *returnVal = getFreeFrame (preferMe);
+	if (returnVal != nullptr || frameWaitTimeout == 0)
+		return returnVal;
+
+	// every page is pinned, so wait for someone to unpin one; the event count is
+	// read before each try, so that an unpin that happens while we are trying is
+	// not missed
+	auto deadline = chrono::steady_clock::now () + chrono::milliseconds (frameWaitTimeout);
+	numFrameWaiters++;
+	while (returnVal == nullptr) {
+		size_t seen = numFrameEvents;
+		returnVal = getFreeFrame (preferMe);
+		if (returnVal != nullptr)
+			break;
+
+		unique_lock <mutex> guard (frameWaitLatch);
+		if (!frameFreed.wait_until (guard, deadline, [&] {return numFrameEvents != seen;}))
+			break;
+	}
+	numFrameWaiters--;
+
+	return returnVal;
+}
+
+void MyDB_BufferManager :: frameMayBeFree () {
+
+	// the latch is only needed if someone might be waiting; taking it before
+	// notifying means that a waiter cannot be between its check and its wait
+	numFrameEvents++;
+	if (numFrameWaiters != 0) {
+		lock_guard <mutex> guard (frameWaitLatch);
+		frameFreed.notify_all ();
+	}
+}
+
+void MyDB_BufferManager :: pinEnded (MyDB_Page &unpinMe) {
+	if (unpinMe.pinQuota != nullptr) {
+		unpinMe.pinQuota->credit ();
+		unpinMe.pinQuota = nullptr;
+	}
+	frameMayBeFree ();
+}
+
+void MyDB_BufferManager :: releaseFrame (void *ram) {
+	{
+		lock_guard <mutex> guard (ramLatch);
+		freeFrames.push_back (frameIndex (ram));
+	}
+	frameMayBeFree ();
+}
+
+void *MyDB_BufferManager :: frameAt (size_t index) {
+	return arena + index * frameSize;
+}
+
+size_t MyDB_BufferManager :: frameIndex (void *frame) {
+	return ((char *) frame - arena) / frameSize;
+}
+
+void MyDB_BufferManager :: forgetPage (Shard &fromMe, MyDB_Page &forgetMe) {
+
+	// if this is a temp page, recycle his slot
+	if (forgetMe.myTable == nullptr)
+		tempSpace->release (forgetMe.pos);
+
+	// the page object may be about to go away
+	if (fromMe.lastAccessed == &forgetMe)
+		fromMe.lastAccessed = nullptr;
+
+	fromMe.allPages.erase (forgetMe.tableID, forgetMe.pos);
+}
+
+void MyDB_BufferManager :: killPage (MyDB_Page &killMe) {
+
+	Shard &shard = *shards[shardOf (killMe.tableID, killMe.pos)];
+	lock_guard <mutex> guard (shard.latch);
+
+	// while we were waiting for the latch, another thread may have handed out a
+	// new reference to the page, or kicked it out and forgotten it
+	if (killMe.refCount != 0 || shard.allPages.find (killMe.tableID, killMe.pos).get () != &killMe)
+		return;
+	
+	// a mapped page has nothing to give back, and it is cheap to set up again
+	if (killMe.isMapped) {
+		forgetPage (shard, killMe);
+		return;
+	}
+
+	// a temp page with no references can never be read again, so there is no
+	// reason to write it back... just give back its RAM and its slot
+	if (killMe.myTable == nullptr) {
+		if (shard.policy->contains (&killMe))
+			shard.policy->remove (&killMe);
+		else if (killMe.bytes != nullptr)
+			pinEnded (killMe);
+		if (killMe.bytes != nullptr) {
+			releaseFrame (killMe.bytes);
+			killMe.bytes = nullptr;
 		}
+		killMe.isDirty = false;
+		forgetPage (shard, killMe);
+		return;
+	}
+
+	// special case is when there are no refs left to this page, but he is pinned
+	// in this case... we just unpin him
+	if (killMe.bytes != nullptr && !shard.policy->contains (&killMe)) {
+		shard.policy->unpinned (&killMe);
+		shard.lastAccessed = nullptr;
+		pinEnded (killMe);
+		return;
+	}
+
+	// if he is still buffered, keep him around in case someone asks for him again;
+	// he will be forgotten when he is kicked out of the buffer
+	if (killMe.bytes != nullptr)
+		return;
 
-		// get some RAM for the page
-		updateMe->bytes = availableRam[availableRam.size () - 1]; 
-		updateMe->numBytes = pageSize;
-		availableRam.pop_back ();
+	// otherwise, there is nothing left to remember
+	forgetPage (shard, killMe);
+}
+
+void MyDB_BufferManager :: readPage (Shard &inMe, MyDB_Page &readMe, void *ram, bool pinned) {
 
-		// and read it
-		lseek (fds[updateMe->myTable], updateMe->pos * pageSize, SEEK_SET);
-		read (fds[updateMe->myTable], updateMe->bytes, pageSize);
+	readMe.bytes = ram;
+	readMe.numBytes = pageSize;
+	if (!readAheadPool->consume (readMe.tableID, readMe.pos, readMe.bytes)) {
+		auto start = chrono::steady_clock::now ();
+		ssize_t numRead = pread (readMe.fd, readMe.bytes, pageSize, readMe.filePos * pageSize);
+		myStats ().timeRead (microsSince (start));
 
-		updateMe->timeTick = ++lastTimeTick;
-		lastUsed.insert (temp);
+		// the part of the page past the end of the file reads as zeros, rather than
+		// as whatever was left in the frame
+		if (numRead < (ssize_t) pageSize)
+			memset (((char *) readMe.bytes) + max (numRead, (ssize_t) 0), 0, pageSize - max (numRead, (ssize_t) 0));
 	}
 
+	string problem = checkPage (readMe);
+	if (problem != "") {
+		readMe.bytes = nullptr;
+		releaseFrame (ram);
+		throw MyDB_PageCorruptError (problem);
+	}
+
+	if (!pinned)
+		inMe.policy->pageIn (&readMe);
 }
 
-MyDB_PageHandle MyDB_BufferManager :: getPinnedPage (MyDB_TablePtr whichTable, long i) {
+bool MyDB_BufferManager :: mustHaveHeader (MyDB_Page &page) {
 
-	// open the file, if it is not open
-	if (fds.count (whichTable) == 0) {
-		int fd = open (whichTable->getStorageLoc ().c_str (), O_CREAT | O_RDWR, 0666);
-		fds[whichTable] = fd;
+	if (page.myTable == nullptr || page.myTable->getPageFormat () == 0)
+		return false;
+
+	struct stat fileInfo;
+	if (fstat (page.fd, &fileInfo) != 0)
+		return false;
+	return (off_t) (page.filePos * pageSize) < fileInfo.st_size;
+}
+
+string MyDB_BufferManager :: checkPage (MyDB_Page &page) {
+
+	if (!checksums)
+		return "";
+
+	bool noHeader = !MyDB_PageHeader :: isFormatted (page.bytes) && mustHaveHeader (page);
+	if (MyDB_PageHeader :: verify (page.bytes, pageSize, noHeader))
+		return "";
+
+	myStats ().count (ChecksumFailureCount);
+	return "Page " + to_string (page.pos) + " of " + 
+		(page.myTable == nullptr ? string ("the temp file") : "table " + page.myTable->getName ()) + 
+		(noHeader ? " has lost its header!!" : " does not match its checksum!!");
+}
+
+void *MyDB_BufferManager :: access (MyDB_Page &updateMe) {
+
+	size_t shardNum = shardOf (updateMe.tableID, updateMe.pos);
+	Shard &shard = *shards[shardNum];
+	
+	// if the page is buffered, just let the policy know about the access
+	{
+		lock_guard <mutex> guard (shard.latch);
+		if (updateMe.bytes != nullptr) {
+			myStats ().count (HitCount);
+			if (&updateMe != shard.lastAccessed && shard.policy->contains (&updateMe))
+				shard.policy->touch (&updateMe);
+			shard.lastAccessed = &updateMe;
+			return updateMe.bytes;
+		}
+	}
+
+	// otherwise, we don't have its contents buffered, so get some RAM for the page;
+	// this may need to kick out a page from another shard, so we do not hold our latch
+	void *ram = waitForFrame (shardNum);
+
+	// if every page stays pinned, let the caller decide what to do about it
+	if (ram == nullptr) {
+		myStats ().count (PinFailureCount);
+		throw MyDB_BufferFullError ();
 	}
 
+	// and read it, unless another thread beat us to it
+	lock_guard <mutex> guard (shard.latch);
+	myStats ().count (MissCount);
+	if (updateMe.bytes != nullptr)
+		releaseFrame (ram);
+	else
+		readPage (shard, updateMe, ram, false);
+
+	shard.lastAccessed = &updateMe;
+	return updateMe.bytes;
+}
+
+MyDB_PageHandle MyDB_BufferManager :: getPinnedPage (MyDB_TablePtr whichTable, long i) {
+	return getPinnedPage (whichTable, i, nullptr);
+}
+
+MyDB_PageHandle MyDB_BufferManager :: getPinnedPage () {
+	return getPinnedPage (nullptr);
+}
+
+MyDB_PageHandle MyDB_BufferManager :: getPinnedPage (MyDB_TablePtr whichTable, long i, MyDB_PinQuotaPtr quota) {
+
 	// make sure we don't have a null table
 	if (whichTable == nullptr) {
 		cout << "Can't allocate a page with a null table!!\n";
 		exit (1);
 	}
 
-	// first, see if the page is there in the buffer
-	pair <MyDB_TablePtr, long> whichPage = make_pair (whichTable, i);
-	if (allPages.count (whichPage) == 0) {
+	// open the file, if it is not open
+	int fd = openFile (whichTable);
+
+	long id = whichTable->getID ();
+	size_t shardNum = shardOf (id, i);
+	Shard &shard = *shards[shardNum];
+
+	// first, see if the page is there in the buffer; if it is buffered, then 
+	// pinning it just means taking it out of the policy
+	{
+		lock_guard <mutex> guard (shard.latch);
+		MyDB_PagePtr returnVal = shard.allPages.find (id, i);
+
+		// a page that is in a read-only mapping never needs any RAM
+		if (returnVal == nullptr && mappedBytes (id, i) != nullptr) {
+			returnVal = makePage (whichTable, i, fd);
+			shard.allPages.findOrInsert (id, i) = returnVal;
+		}
 
-		// see if there is space to make a pinned page
-		if (availableRam.size () == 0)
-			kickOutPage ();
+		if (returnVal != nullptr && returnVal->bytes != nullptr) {
+			myStats ().count (HitCount);
+			// a page that is only being held by a logged action (or a write back)
+			// becomes pinned for real, so it is left pinned when that is done
+			if (shard.policy->contains (returnVal.get ()) || returnVal->actionPinned || returnVal->flushPinned) {
+				if (quota != nullptr && !quota->charge ()) {
+					myStats ().count (PinFailureCount);
+					return nullptr;
+				}
+				if (returnVal->actionPinned)
+					returnVal->actionPinned = false;
+				else if (returnVal->flushPinned)
+					returnVal->flushPinned = false;
+				else
+					shard.policy->remove (returnVal.get ());
+				returnVal->pinQuota = quota;
+			}
+			return make_shared <MyDB_PageHandleBase> (returnVal);
+		}
+	}
 
-		// if there is no space, we cannot do anything
-		if (availableRam.size () == 0) 
-			return nullptr;
+	// the pin is charged up front, and given back if it turns out not to be needed
+	if (quota != nullptr && !quota->charge ()) {
+		myStats ().count (PinFailureCount);
+		return nullptr;
+	}
 
-		// set up the return val
-		MyDB_PagePtr returnVal = make_shared <MyDB_Page> (whichTable, i, *this);
-		returnVal->bytes = availableRam[availableRam.size () - 1];
-		returnVal->numBytes = pageSize;
-		availableRam.pop_back ();
-		allPages [whichPage] = returnVal;
+	// see if there is space to make a pinned page; if there is no space, we cannot
+	// do anything
+	void *ram = waitForFrame (shardNum);
+	if (ram == nullptr) {
+		if (quota != nullptr)
+			quota->credit ();
+		myStats ().count (PinFailureCount);
+		return nullptr;
+	}
 
-		// and read it
-		lseek (fds[returnVal->myTable], returnVal->pos * pageSize, SEEK_SET);
-		read (fds[returnVal->myTable], returnVal->bytes, pageSize);
+	// set up the return val
+	lock_guard <mutex> guard (shard.latch);
+	MyDB_PagePtr returnVal = shard.allPages.find (id, i);
+	if (returnVal == nullptr) {
+		try {
+			returnVal = makePage (whichTable, i, fd);
+		} catch (MyDB_PageCorruptError &e) {
+			releaseFrame (ram);
+			if (quota != nullptr)
+				quota->credit ();
+			throw;
+		}
+		shard.allPages.findOrInsert (id, i) = returnVal;
+	}
 
-		// get outta here
-		return make_shared <MyDB_PageHandleBase> (returnVal);
+	// and read it, unless another thread beat us to it
+	myStats ().count (MissCount);
+	if (returnVal->bytes != nullptr) {
+		releaseFrame (ram);
+		if (shard.policy->contains (returnVal.get ())) {
+			shard.policy->remove (returnVal.get ());
+			returnVal->pinQuota = quota;
+		} else if (returnVal->actionPinned) {
+			returnVal->actionPinned = false;
+			returnVal->pinQuota = quota;
+		} else if (returnVal->flushPinned) {
+			returnVal->flushPinned = false;
+			returnVal->pinQuota = quota;
+		} else if (quota != nullptr) {
+			quota->credit ();
+		}
+	} else {
+		try {
+			readPage (shard, *returnVal, ram, true);
+		} catch (MyDB_PageCorruptError &e) {
+			if (quota != nullptr)
+				quota->credit ();
+			throw;
+		}
+		returnVal->pinQuota = quota;
 	}
 
-	return make_shared <MyDB_PageHandleBase> (allPages [whichPage]);
+	// get outta here
+	return make_shared <MyDB_PageHandleBase> (returnVal);
 }
 
-MyDB_PageHandle MyDB_BufferManager :: getPinnedPage () {
+MyDB_PageHandle MyDB_BufferManager :: getPinnedPage (MyDB_PinQuotaPtr quota) {
+	return getPinnedPage (MyDB_TempRegionPtr (), quota);
+}
 
-	// see if there is space to make a pinned page
-	if (availableRam.size () == 0)
-		kickOutPage ();
+MyDB_PageHandle MyDB_BufferManager :: getPinnedPage (MyDB_TempRegionPtr inMe, MyDB_PinQuotaPtr quota) {
 
-	// if there is no space, we cannot do anything
-	if (availableRam.size () == 0) 
+	if (quota != nullptr && !quota->charge ()) {
+		myStats ().count (PinFailureCount);
 		return nullptr;
+	}
 
 	// get a page to return
-	MyDB_PageHandle returnVal = getPage ();
-	returnVal->page->bytes = availableRam[availableRam.size () - 1];
-	returnVal->page->numBytes = pageSize;
-	availableRam.pop_back ();
+	MyDB_PageHandle returnVal = getPage (inMe);
+	MyDB_Page &page = *returnVal->page;
+	size_t shardNum = shardOf (-1, page.pos);
+
+	// see if there is space to make a pinned page; if there is no space, we cannot 
+	// do anything (and the temp page goes away with its handle)
+	void *ram = waitForFrame (shardNum);
+	if (ram == nullptr) {
+		if (quota != nullptr)
+			quota->credit ();
+		myStats ().count (PinFailureCount);
+		return nullptr;
+	}
+
+	lock_guard <mutex> guard (shards[shardNum]->latch);
+	page.bytes = ram;
+	page.numBytes = pageSize;
+	page.pinQuota = quota;
 
 	// and get outta here
 	return returnVal;
 }
 
 void MyDB_BufferManager :: unpin (MyDB_PageHandle unpinMe) {
-	if (lastUsed.count (unpinMe) != 1) {
-		lastUsed.erase (unpinMe);
-		unpinMe->page->timeTick = ++lastTimeTick;
-		lastUsed.insert (unpinMe);
+	MyDB_Page *page = unpinMe->page.get ();
+	Shard &shard = *shards[shardOf (page->tableID, page->pos)];
+	lock_guard <mutex> guard (shard.latch);
+
+	// a page that a logged action has changed stays held until the action ends
+	if (page->inAction) {
+		if (!page->actionPinned) {
+			page->actionPinned = true;
+			pinEnded (*page);
+		}
+		return;
+	}
+
+	// a page that is being written back goes back to the policy once the write
+	// is done
+	if (page->bytes != nullptr && !page->isMapped && !shard.policy->contains (page) && !page->flushPinned) {
+		if (page->isFlushing) {
+			page->flushPinned = true;
+		} else {
+			shard.policy->unpinned (page);
+			shard.lastAccessed = nullptr;
+		}
+		pinEnded (*page);
 	}
 }
 
-MyDB_BufferManager :: MyDB_BufferManager (size_t pageSizeIn, size_t numPagesIn, string tempFileIn) {
+MyDB_BufferManager :: MyDB_BufferManager (size_t pageSizeIn, size_t numPagesIn, string tempFileIn) :
+	MyDB_BufferManager (pageSizeIn, numPagesIn, tempFileIn, LRUReplacement) {}
+
+MyDB_BufferManager :: MyDB_BufferManager (size_t pageSizeIn, size_t numPagesIn, string tempFileIn, 
+	MyDB_PolicyType policyType) :
+	MyDB_BufferManager (pageSizeIn, numPagesIn, tempFileIn, policyType, false) {}
+
+MyDB_BufferManager :: MyDB_BufferManager (size_t pageSizeIn, size_t numPagesIn, string tempFileIn, 
+	MyDB_PolicyType policyType, bool directIOIn) {
 
 	// remember the inputs
 	pageSize = pageSizeIn;
@@ -276,42 +1322,128 @@ MyDB_BufferManager :: MyDB_BufferManager (size_t pageSizeIn, size_t numPagesIn,
 	// this is the location where we write temp pages
 	tempFile = tempFileIn;
 
-	// start at time tick zero
-	lastTimeTick = 0;
-
-	// position in temp file
-	lastTempPos = 0;
+	// the temp file is opened the first time a temp page is asked for
+	tempSpace = make_shared <MyDB_TempSpace> (vector <string> {tempFile}, pageSize, [this] (string fileName) {
+		return openForIO (fileName, O_TRUNC | O_CREAT | O_RDWR);
+	});
 
 	// the number of pages
 	numPages = numPagesIn;
 
-	// create all of the RAM
-	for (size_t i = 0; i < numPages; i++) {
-		availableRam.push_back (malloc (pageSizeIn));
+	// O_DIRECT needs every transfer to be a multiple of the disk block size
+	directIO = directIOIn && pageSize % DIRECT_IO_ALIGNMENT == 0;
+
+	// set up the shards, each with its own replacement policy
+	size_t numShards = 1;
+	while (numShards < MAX_SHARDS && numShards * 2 * MIN_PAGES_PER_SHARD <= numPages)
+		numShards *= 2;
+
+	for (size_t i = 0; i < numShards; i++) {
+		shards.push_back (unique_ptr <Shard> (new Shard));
+		shards[i]->policy = MyDB_ReplacementPolicy :: create (policyType, numPages / numShards);
+		shards[i]->lastAccessed = nullptr;
+		shards[i]->numDirtyEvictions = 0;
+	}
+
+	// the read-ahead pool gets enough staging buffers for a couple of scans
+	readAheadPool = make_shared <MyDB_ReadAhead> (pageSize, 2 * READ_AHEAD_PAGES, NUM_IO_THREADS);
+
+	// create all of the RAM, as one arena of frames; every frame starts on a
+	// cache line, and for direct I/O, the page size is a multiple of the OS page
+	// size, so that every frame starts on an OS page
+	frameSize = (pageSize + FRAME_ALIGNMENT - 1) / FRAME_ALIGNMENT * FRAME_ALIGNMENT;
+	arenaSize = frameSize * (numPages == 0 ? 1 : numPages);
+
+	// try to back the arena with huge pages, so that it takes up fewer TLB entries;
+	// this only works if huge pages have been reserved, so if it does not, ask for
+	// transparent huge pages instead
+	arena = (char *) MAP_FAILED;
+	if (arenaSize >= HUGE_PAGE_SIZE) {
+		size_t hugeSize = (arenaSize + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+		arena = (char *) mmap (nullptr, hugeSize, PROT_READ | PROT_WRITE, 
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (arena != (char *) MAP_FAILED)
+			arenaSize = hugeSize;
+	}
+
+	if (arena == (char *) MAP_FAILED) {
+		arena = (char *) mmap (nullptr, arenaSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (arena == (char *) MAP_FAILED) {
+			cout << "Can't allocate RAM for the buffer!!\n";
+			exit (1);
+		}
+		if (arenaSize >= HUGE_PAGE_SIZE)
+			madvise (arena, arenaSize, MADV_HUGEPAGE);
+	}
+
+	// frame 0 is handed out first
+	for (size_t i = numPages; i > 0; i--) {
+		freeFrames.push_back (i - 1);
 	}	
+
+	// the counters are set up as threads start using the buffer manager
+	serialNum = nextSerialNum++;
+
+	// pages are checksummed unless asked otherwise
+	checksums = true;
+
+	// nobody is waiting for a frame yet
+	frameWaitTimeout = DEFAULT_FRAME_WAIT_MS;
+	numFrameWaiters = 0;
+	numFrameEvents = 0;
+
+	// nothing is logged until asked for
+	checkpointing = false;
+
+	// and start writing back dirty pages in the background
+	flusherStopping = false;
+	statsInterval = 0;
+	statsOut = nullptr;
+	flusher = thread (&MyDB_BufferManager :: flushInBackground, this);
 }
 
 MyDB_BufferManager :: ~MyDB_BufferManager () {
-	
-	// kill the list of all pages
-	map <pair <MyDB_TablePtr, size_t>, MyDB_PagePtr, PageCompare> empty;
-	allPages = empty;
 
-	// kill the LRU list	
-	set <MyDB_PageHandle, CheckLRU> emptyAgain;
-	lastUsed = emptyAgain;
+	// stop the flusher, and any reading in the background, before the files go away
+	{
+		lock_guard <mutex> guard (flusherLatch);
+		flusherStopping = true;
+	}
+	flusherWake.notify_one ();
+	flusher.join ();
+	readAheadPool = nullptr;
+	
+	// write back all of the dirty pages, in file order, after which there is
+	// nothing in the log that needs to be redone
+	flushDirty (-1, false, true);
+	log = nullptr;
+
+	// kill the list of all pages; the pages no longer own any RAM
+	for (auto &shard : shards) {
+		shard->allPages.forEach ([&] (MyDB_PagePtr &myPage) {
+			myPage->bytes = nullptr;
+		});
+		shard->allPages.clear ();
+	}
 
-	// delete the rest of the RAM
-	for (auto ram : availableRam) {
-		free (ram);
+	// and delete the RAM, and any mappings of tables
+	munmap (arena, arenaSize);
+	for (auto &mapping : mappings) {
+		if (mapping.first != nullptr)
+			munmap (mapping.first, mapping.second);
 	}
+	for (auto &mapping : oldMappings)
+		munmap (mapping.first, mapping.second);
 
 	// finally, close the files
-	for (auto fd : fds) {
-		close (fd.second);
+	for (int fd : fds) {
+		if (fd != -1)
+			close (fd);
 	}
 
-	unlink (tempFile.c_str ());
+	// this closes and deletes the temp files (unless a region of the temp space
+	// is still around, in which case that happens when it goes away)
+	tempSpace = nullptr;
 }
 
 
@@ -0,0 +1,68 @@
+
+#ifndef BUFFER_STATS_C
+#define BUFFER_STATS_C
+
+#include "MyDB_BufferStats.h"
+
+MyDB_BufferStats :: MyDB_BufferStats () {
+	numHits = 0;
+	numMisses = 0;
+	numReadAheadHits = 0;
+	numEvictions = 0;
+	numWriteBacks = 0;
+	numWriteFailures = 0;
+	numPinFailures = 0;
+	numChecksumFailures = 0;
+	numLogGroups = 0;
+	numLogSyncs = 0;
+	numLogWaits = 0;
+	numFrames = 0;
+	numFreeFrames = 0;
+	numPinnedPages = 0;
+	tempFilePages = 0;
+	tempSpacePages = 0;
+	readLatency.resize (NUM_LATENCY_BUCKETS, 0);
+	writeLatency.resize (NUM_LATENCY_BUCKETS, 0);
+}
+
+double MyDB_BufferStats :: getHitRate () {
+	if (numHits + numMisses == 0)
+		return 0;
+	return numHits / (double) (numHits + numMisses);
+}
+
+// prints the non-empty buckets of a latency histogram
+static void printHistogram (ostream &toMe, vector <size_t> &histogram) {
+	bool any = false;
+	for (int i = 0; i < NUM_LATENCY_BUCKETS; i++) {
+		if (histogram[i] == 0)
+			continue;
+		toMe << " <" << (2UL << i) << "us:" << histogram[i];
+		any = true;
+	}
+	if (!any)
+		toMe << " none";
+	toMe << "\n";
+}
+
+void MyDB_BufferStats :: print (ostream &toMe) {
+	toMe << "buffer: " << numHits << " hits, " << numMisses << " misses (hit rate " << getHitRate () << "), "
+		<< numReadAheadHits << " read ahead\n";
+	toMe << "buffer: " << numEvictions << " evictions, " << numWriteBacks << " write-backs, "
+		<< numWriteFailures << " failed writes, " << numPinFailures << " pin failures, " 
+		<< numChecksumFailures << " bad checksums\n";
+	toMe << "buffer: " << numLogGroups << " log groups, " << numLogSyncs << " log syncs, "
+		<< numLogWaits << " write-backs waited for the log\n";
+	toMe << "buffer: " << numFrames << " frames, " << numFreeFrames << " free, " << numPinnedPages
+		<< " pinned; " << tempFilePages << " temp pages, in " << tempSpacePages << " pages of temp files\n";
+	toMe << "buffer: resident pages:";
+	for (auto &table : residentPages)
+		toMe << " " << table.first << "=" << table.second;
+	toMe << "\n";
+	toMe << "buffer: read latency:";
+	printHistogram (toMe, readLatency);
+	toMe << "buffer: write latency:";
+	printHistogram (toMe, writeLatency);
+}
+
+#endif
@@ -0,0 +1,379 @@
+
+#ifndef LOG_MGR_C
+#define LOG_MGR_C
+
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <iostream>
+#include "MyDB_LogManager.h"
+#include "MyDB_PageHeader.h"
+#include <sys/stat.h>
+#include <unistd.h>
+
+// marks a file as a log
+#define LOG_MAGIC 0x474f4c4d
+
+// the version of the log format that is written by this code
+#define LOG_FORMAT_VERSION 1
+
+// how often the writer syncs the log when no one is waiting on it
+#define LOG_SYNC_INTERVAL_MS 10
+
+// once this many bytes have been logged, the writer is woken up to write them,
+// even if no one is waiting yet
+#define LOG_BUFFER_BYTES (4 * 1024 * 1024)
+
+// while recovering, at most this many pages are kept in RAM at once
+#define RECOVERY_PAGES 256
+
+// the start of the log file
+struct LogHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t pageSize;
+	uint64_t startLSN;
+	uint64_t unused;
+};
+
+// every group in the log starts with the number of bytes of changes in it, and
+// the CRC32C of those bytes; a group that only partly made it to disk (because
+// it was being written when the system crashed) does not match its CRC
+struct GroupHeader {
+	uint32_t numBytes;
+	uint32_t checksum;
+};
+
+// and each change is laid out as the length of the file name, the name, the
+// page number, the offset into the page, the number of bytes, and the bytes
+struct ChangeHeader {
+	uint64_t pageNum;
+	uint32_t offset;
+	uint32_t numBytes;
+};
+
+void MyDB_LogGroup :: add (const string &fileName, size_t pageNum, size_t offset, const void *bytes, size_t len) {
+	uint16_t nameLen = fileName.size ();
+	ChangeHeader header;
+	header.pageNum = pageNum;
+	header.offset = offset;
+	header.numBytes = len;
+	changes.insert (changes.end (), (const char *) &nameLen, ((const char *) &nameLen) + sizeof (nameLen));
+	changes.insert (changes.end (), fileName.begin (), fileName.end ());
+	changes.insert (changes.end (), (const char *) &header, ((const char *) &header) + sizeof (header));
+	changes.insert (changes.end (), (const char *) bytes, ((const char *) bytes) + len);
+}
+
+bool MyDB_LogGroup :: isEmpty () {
+	return changes.empty ();
+}
+
+// goes through the changes in a group that was read from the log, calling doMe
+// on each; returns false (without calling doMe) if the group does not make sense
+static bool forEachChange (vector <char> &group, size_t pageSize,
+	function <void (string &, size_t, size_t, char *, size_t)> doMe) {
+
+	// first make sure that every change is well-formed...
+	for (int pass = 0; pass < 2; pass++) {
+		size_t pos = 0;
+		while (pos < group.size ()) {
+
+			uint16_t nameLen;
+			if (pos + sizeof (nameLen) > group.size ())
+				return false;
+			memcpy (&nameLen, &group[pos], sizeof (nameLen));
+			pos += sizeof (nameLen);
+
+			ChangeHeader header;
+			if (pos + nameLen + sizeof (header) > group.size ())
+				return false;
+			string fileName (&group[pos], nameLen);
+			pos += nameLen;
+			memcpy (&header, &group[pos], sizeof (header));
+			pos += sizeof (header);
+
+			if (pos + header.numBytes > group.size () || header.offset + (size_t) header.numBytes > pageSize)
+				return false;
+
+			// ...and only then apply them
+			if (pass == 1)
+				doMe (fileName, header.pageNum, header.offset, &group[pos], header.numBytes);
+			pos += header.numBytes;
+		}
+	}
+	return true;
+}
+
+MyDB_LogManager :: MyDB_LogManager (string logFileIn, size_t pageSizeIn) {
+
+	logFile = logFileIn;
+	pageSize = pageSizeIn;
+	fd = open (logFile.c_str (), O_CREAT | O_RDWR, 0666);
+	if (fd == -1) {
+		cout << "Can't open the log " << logFile << "!!\n";
+		exit (1);
+	}
+
+	// a new log starts out with no groups; otherwise, pick up the numbering where it was
+	LogHeader header;
+	ssize_t numRead = pread (fd, &header, sizeof (header), 0);
+	if (numRead == 0) {
+		startLSN = 0;
+		writeHeader ();
+	} else if (numRead != (ssize_t) sizeof (header) || header.magic != LOG_MAGIC) {
+		cout << logFile << " is not a log!!\n";
+		exit (1);
+	} else if (header.pageSize != pageSize) {
+		cout << "The log " << logFile << " was written with a different page size!!\n";
+		exit (1);
+	} else {
+		startLSN = header.startLSN;
+	}
+
+	writtenLSN = endLSN = durableLSN = startLSN;
+	writing = false;
+	numWaiters = 0;
+	stopping = false;
+	numSyncs = 0;
+	numGroups = 0;
+	numRecovered = 0;
+	writer = thread (&MyDB_LogManager :: writeInBackground, this);
+}
+
+MyDB_LogManager :: ~MyDB_LogManager () {
+
+	// the writer writes out whatever is left before it stops
+	{
+		lock_guard <mutex> guard (latch);
+		stopping = true;
+	}
+	writerWake.notify_one ();
+	writer.join ();
+	close (fd);
+}
+
+void MyDB_LogManager :: writeHeader () {
+	LogHeader header;
+	header.magic = LOG_MAGIC;
+	header.version = LOG_FORMAT_VERSION;
+	header.pageSize = pageSize;
+	header.startLSN = startLSN;
+	header.unused = 0;
+	pwrite (fd, &header, sizeof (header), 0);
+	ftruncate (fd, sizeof (header));
+	fdatasync (fd);
+}
+
+void MyDB_LogManager :: recover (map <string, long> &lastPages) {
+
+	// the pages being redone, and the files that they are in
+	map <pair <string, size_t>, vector <char>> pages;
+	map <string, int> files;
+
+	// writes all of the pages in RAM back to their files
+	auto writeOut = [&] () {
+		for (auto &page : pages) {
+			MyDB_PageHeader :: stamp (page.second.data (), pageSize);
+			pwrite (files[page.first.first], page.second.data (), pageSize, page.first.second * pageSize);
+		}
+		pages.clear ();
+	};
+
+	// returns the given page, reading it in if it is not in RAM
+	auto getPage = [&] (string &fileName, size_t pageNum) -> vector <char> & {
+		auto key = make_pair (fileName, pageNum);
+		auto found = pages.find (key);
+		if (found != pages.end ())
+			return found->second;
+
+		if (pages.size () == RECOVERY_PAGES)
+			writeOut ();
+
+		if (files.count (fileName) == 0)
+			files[fileName] = open (fileName.c_str (), O_CREAT | O_RDWR, 0666);
+
+		// the part of the page past the end of the file reads as zeros
+		vector <char> &page = pages[key];
+		page.resize (pageSize, 0);
+		pread (files[fileName], page.data (), pageSize, pageNum * pageSize);
+		return page;
+	};
+
+	struct stat fileInfo;
+	fstat (fd, &fileInfo);
+	size_t fileSize = fileInfo.st_size;
+
+	// go through the groups in order, until we run into the end of the log or a
+	// group that did not make it to disk in one piece
+	uint64_t lsn = startLSN;
+	size_t pos = sizeof (LogHeader);
+	while (pos + sizeof (GroupHeader) <= fileSize) {
+
+		GroupHeader header;
+		if (pread (fd, &header, sizeof (header), pos) != (ssize_t) sizeof (header) ||
+			header.numBytes > fileSize - pos - sizeof (header))
+			break;
+
+		vector <char> group (header.numBytes);
+		if (pread (fd, group.data (), header.numBytes, pos + sizeof (header)) != (ssize_t) header.numBytes ||
+			MyDB_PageHeader :: crc32c (group.data (), group.size ()) != header.checksum)
+			break;
+
+		// redo the changes; the pages end up with the LSN of the group, just as
+		// they did when the changes were first made
+		uint64_t groupLSN = lsn + sizeof (header) + header.numBytes;
+		bool ok = forEachChange (group, pageSize, [&] (string &fileName, size_t pageNum, size_t offset,
+			char *bytes, size_t len) {
+
+			vector <char> &page = getPage (fileName, pageNum);
+			memcpy (page.data () + offset, bytes, len);
+			if (MyDB_PageHeader :: isFormatted (page.data ()))
+				((MyDB_PageHeader *) page.data ())->lsn = groupLSN;
+
+			if (lastPages.count (fileName) == 0 || lastPages[fileName] < (long) pageNum)
+				lastPages[fileName] = pageNum;
+		});
+
+		if (!ok)
+			break;
+
+		lsn = groupLSN;
+		pos += sizeof (header) + header.numBytes;
+		numRecovered++;
+	}
+
+	// get the pages onto disk for good, and then start the log over
+	writeOut ();
+	for (auto &file : files) {
+		fsync (file.second);
+		close (file.second);
+	}
+
+	lock_guard <mutex> guard (latch);
+	startLSN = writtenLSN = endLSN = durableLSN = lsn;
+	writeHeader ();
+}
+
+uint64_t MyDB_LogManager :: append (MyDB_LogGroup &appendMe) {
+
+	GroupHeader header;
+	header.numBytes = appendMe.changes.size ();
+	header.checksum = MyDB_PageHeader :: crc32c (appendMe.changes.data (), appendMe.changes.size ());
+
+	lock_guard <mutex> guard (latch);
+	buffer.insert (buffer.end (), (char *) &header, ((char *) &header) + sizeof (header));
+	buffer.insert (buffer.end (), appendMe.changes.begin (), appendMe.changes.end ());
+	endLSN += sizeof (header) + header.numBytes;
+	numGroups++;
+
+	if (buffer.size () >= LOG_BUFFER_BYTES)
+		writerWake.notify_one ();
+
+	return endLSN;
+}
+
+void MyDB_LogManager :: flushTo (uint64_t lsn) {
+
+	unique_lock <mutex> guard (latch);
+	lsn = min (lsn, endLSN);
+	if (durableLSN >= lsn)
+		return;
+
+	// the writer takes everything that is in the buffer when it wakes up, so
+	// anyone else who is waiting gets their groups synced along with ours
+	numWaiters++;
+	writerWake.notify_one ();
+	flushed.wait (guard, [&] {return durableLSN >= lsn;});
+	numWaiters--;
+}
+
+void MyDB_LogManager :: flushAll () {
+	uint64_t lsn;
+	{
+		lock_guard <mutex> guard (latch);
+		lsn = endLSN;
+	}
+	flushTo (lsn);
+}
+
+void MyDB_LogManager :: truncate () {
+
+	unique_lock <mutex> guard (latch);
+	uint64_t lsn = endLSN;
+	numWaiters++;
+	writerWake.notify_one ();
+	flushed.wait (guard, [&] {return durableLSN >= lsn && !writing;});
+	numWaiters--;
+
+	// anything logged since then goes at the start of the emptied file
+	startLSN = writtenLSN;
+	writeHeader ();
+}
+
+uint64_t MyDB_LogManager :: getDurableLSN () {
+	lock_guard <mutex> guard (latch);
+	return durableLSN;
+}
+
+size_t MyDB_LogManager :: getNumSyncs () {
+	lock_guard <mutex> guard (latch);
+	return numSyncs;
+}
+
+size_t MyDB_LogManager :: getNumGroups () {
+	lock_guard <mutex> guard (latch);
+	return numGroups;
+}
+
+size_t MyDB_LogManager :: getNumRecovered () {
+	lock_guard <mutex> guard (latch);
+	return numRecovered;
+}
+
+void MyDB_LogManager :: writeInBackground () {
+
+	unique_lock <mutex> guard (latch);
+	while (true) {
+
+		// sleep unless someone is waiting on groups that are not written yet, or
+		// there is a lot to write
+		if (!stopping && (numWaiters == 0 || buffer.empty ()) && buffer.size () < LOG_BUFFER_BYTES)
+			writerWake.wait_for (guard, chrono::milliseconds (LOG_SYNC_INTERVAL_MS));
+
+		if (buffer.empty ()) {
+			if (stopping)
+				return;
+			continue;
+		}
+
+		// take everything in the buffer, and write and sync it without the latch,
+		// so that groups can be appended in the meantime
+		vector <char> writeMe;
+		writeMe.swap (buffer);
+		size_t pos = sizeof (LogHeader) + (writtenLSN - startLSN);
+		writtenLSN = endLSN;
+		uint64_t lsn = endLSN;
+		writing = true;
+		guard.unlock ();
+
+		size_t done = 0;
+		while (done < writeMe.size ()) {
+			ssize_t numWritten = pwrite (fd, writeMe.data () + done, writeMe.size () - done, pos + done);
+			if (numWritten <= 0) {
+				cout << "Can't write to the log " << logFile << "!!\n";
+				exit (1);
+			}
+			done += numWritten;
+		}
+		fdatasync (fd);
+
+		guard.lock ();
+		writing = false;
+		durableLSN = lsn;
+		numSyncs++;
+		flushed.notify_all ();
+	}
+}
+
+#endif
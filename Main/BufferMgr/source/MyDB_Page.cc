@@ -17,27 +17,45 @@
 #include "MyDB_Table.h"
 
 void *MyDB_Page :: getBytes () {
-	parent.access (*this);	
-	return bytes;
+	return parent.access (*this);
 }
 
 void MyDB_Page :: wroteBytes () {
 	isDirty = true;
 }
 
+void MyDB_Page :: wroteBytes (size_t offset, size_t len) {
+	isDirty = true;
+	parent.logChange (*this, offset, len);
+}
+
 MyDB_Page :: ~MyDB_Page () {}
 
 MyDB_Page :: MyDB_Page (MyDB_TablePtr myTableIn, size_t iin, MyDB_BufferManager &parentIn) : 
 	parent (parentIn), myTable (myTableIn), pos (iin) { 
 	bytes = nullptr;
+	tableID = (myTable == nullptr) ? -1 : (long) myTable->getID ();
+	fd = -1;
+	filePos = iin;
+	isMapped = false;
 	isDirty = false;	
+	lsn = 0;
+	inAction = false;
+	actionPinned = false;
+	isFlushing = false;
+	flushPinned = false;
 	refCount = 0;
-	timeTick = -1;
+	inPolicy = false;
+	policyPrev = nullptr;
+	policyNext = nullptr;
+	policyState = 0;
+	refBit = false;
+	lastTick = -1;
+	histTick = -1;
 }
 
 void MyDB_Page :: decRefCount () {
-	refCount--;
-	if (refCount == 0) {
+	if (--refCount == 0) {
 		parent.killPage (*this);
 	}
 }
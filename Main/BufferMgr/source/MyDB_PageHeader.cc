@@ -0,0 +1,164 @@
+
+#ifndef PAGE_HEADER_C
+#define PAGE_HEADER_C
+
+#include <cstring>
+#include "MyDB_PageHeader.h"
+
+#if defined (__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+// the CRC32C polynomial, bit-reversed
+#define CRC32C_POLY 0x82f63b78
+
+// the table for computing CRC32C one byte at a time
+struct CRCTable {
+
+	uint32_t entries[256];
+
+	CRCTable () {
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t entry = i;
+			for (int bit = 0; bit < 8; bit++)
+				entry = (entry & 1) ? (entry >> 1) ^ CRC32C_POLY : entry >> 1;
+			entries[i] = entry;
+		}
+	}
+};
+
+// the running CRC, one byte at a time, using the table
+static uint32_t softwareUpdate (uint32_t crc, const char *data, size_t len) {
+	static CRCTable table;
+	for (size_t i = 0; i < len; i++)
+		crc = table.entries[(crc ^ (unsigned char) data[i]) & 0xff] ^ (crc >> 8);
+	return crc;
+}
+
+#if defined (__x86_64__)
+
+// the running CRC, eight bytes at a time, using the SSE4.2 instruction
+__attribute__ ((target ("sse4.2")))
+static uint32_t hardwareUpdate (uint32_t crc, const char *data, size_t len) {
+
+	uint64_t crc64 = crc;
+	while (len >= 8) {
+		uint64_t word;
+		memcpy (&word, data, 8);
+		crc64 = _mm_crc32_u64 (crc64, word);
+		data += 8;
+		len -= 8;
+	}
+
+	crc = (uint32_t) crc64;
+	while (len > 0) {
+		crc = _mm_crc32_u8 (crc, *data);
+		data++;
+		len--;
+	}
+	return crc;
+}
+
+static bool checkForHardware () {
+	__builtin_cpu_init ();
+	return __builtin_cpu_supports ("sse4.2");
+}
+
+static bool useHardware = checkForHardware ();
+
+#else
+
+static bool useHardware = false;
+
+#endif
+
+static uint32_t update (uint32_t crc, const char *data, size_t len) {
+#if defined (__x86_64__)
+	if (useHardware)
+		return hardwareUpdate (crc, data, len);
+#endif
+	return softwareUpdate (crc, data, len);
+}
+
+uint32_t MyDB_PageHeader :: crc32c (const void *data, size_t len) {
+	return ~update (0xffffffff, (const char *) data, len);
+}
+
+uint32_t MyDB_PageHeader :: crc32cSoftware (const void *data, size_t len) {
+	return ~softwareUpdate (0xffffffff, (const char *) data, len);
+}
+
+bool MyDB_PageHeader :: hasHardwareCRC () {
+	return useHardware;
+}
+
+void MyDB_PageHeader :: format (void *page) {
+	MyDB_PageHeader *header = (MyDB_PageHeader *) page;
+	header->pageType = 0;
+	header->magic = PAGE_MAGIC;
+	header->numBytesUsed = sizeof (MyDB_PageHeader);
+	header->lsn = 0;
+	header->checksum = 0;
+	header->version = PAGE_FORMAT_VERSION;
+	header->numSlots = 0;
+}
+
+bool MyDB_PageHeader :: isFormatted (void *page) {
+	return ((MyDB_PageHeader *) page)->magic == PAGE_MAGIC;
+}
+
+bool MyDB_PageHeader :: isSequential (void *page) {
+	return !isFormatted (page) || ((MyDB_PageHeader *) page)->version < SLOT_DIRECTORY_VERSION;
+}
+
+size_t MyDB_PageHeader :: getSequentialStart (void *page) {
+
+	// without a header, there is just the page type, padded out to eight bytes,
+	// and the number of bytes used
+	if (isFormatted (page))
+		return sizeof (MyDB_PageHeader);
+	return 2 * sizeof (uint64_t);
+}
+
+size_t MyDB_PageHeader :: getSequentialEnd (void *page, size_t pageSize) {
+	uint64_t numBytesUsed = ((MyDB_PageHeader *) page)->numBytesUsed;
+	return numBytesUsed < pageSize ? numBytesUsed : pageSize;
+}
+
+MyDB_PageSlot *MyDB_PageHeader :: getSlot (void *page, size_t pageSize, size_t i) {
+	return ((MyDB_PageSlot *) (((char *) page) + pageSize)) - (i + 1);
+}
+
+// the checksum of the page, taking its checksum field to be zero; it covers the
+// records and the slots.  If the number of bytes used makes no sense, the whole
+// page is covered
+static uint32_t pageChecksum (void *page, size_t pageSize) {
+
+	MyDB_PageHeader header = *((MyDB_PageHeader *) page);
+	header.checksum = 0;
+
+	size_t numBytes = header.numBytesUsed;
+	size_t numSlotBytes = header.numSlots * sizeof (MyDB_PageSlot);
+	if (numBytes < sizeof (MyDB_PageHeader) || numBytes + numSlotBytes > pageSize) {
+		numBytes = pageSize;
+		numSlotBytes = 0;
+	}
+
+	uint32_t crc = update (0xffffffff, (const char *) &header, sizeof (MyDB_PageHeader));
+	crc = update (crc, ((const char *) page) + sizeof (MyDB_PageHeader), numBytes - sizeof (MyDB_PageHeader));
+	crc = update (crc, ((const char *) page) + pageSize - numSlotBytes, numSlotBytes);
+	return ~crc;
+}
+
+void MyDB_PageHeader :: stamp (void *page, size_t pageSize) {
+	if (isFormatted (page))
+		((MyDB_PageHeader *) page)->checksum = pageChecksum (page, pageSize);
+}
+
+bool MyDB_PageHeader :: verify (void *page, size_t pageSize, bool needHeader) {
+	if (!isFormatted (page))
+		return !needHeader;
+	return ((MyDB_PageHeader *) page)->checksum == pageChecksum (page, pageSize);
+}
+
+#endif
@@ -0,0 +1,178 @@
+
+#ifndef READ_AHEAD_C
+#define READ_AHEAD_C
+
+#include <algorithm>
+#include <cstring>
+#include "MyDB_ReadAhead.h"
+#include <stdlib.h>
+#include <unistd.h>
+
+MyDB_ReadAhead :: MyDB_ReadAhead (size_t pageSizeIn, size_t numBuffersIn, size_t numThreadsIn) {
+	pageSize = pageSizeIn;
+	numBuffers = numBuffersIn;
+	numThreads = numThreadsIn;
+	stopping = false;
+	nextSeqNum = 0;
+	numHits = 0;
+}
+
+MyDB_ReadAhead :: ~MyDB_ReadAhead () {
+
+	// stop the I/O threads; a thread only checks for this between reads, so
+	// once they are all gone, no entry is in the middle of being read
+	{
+		lock_guard <mutex> guard (latch);
+		stopping = true;
+	}
+	workReady.notify_all ();
+	for (auto &worker : workers)
+		worker.join ();
+
+	// and get back all of the buffers
+	while (!entries.empty ())
+		drop (entries.begin ()->second);
+
+	for (void *buffer : freeBuffers)
+		free (buffer);
+}
+
+void MyDB_ReadAhead :: request (long tableID, int fd, size_t pos) {
+
+	lock_guard <mutex> guard (latch);
+
+	// see if the page is already on its way in
+	PageKey key (tableID, pos);
+	if (entries.count (key) != 0)
+		return;
+
+	// get a staging buffer; the buffers are only allocated as they are needed,
+	// and they are aligned in case the file was opened with O_DIRECT
+	if (freeBuffers.empty () && entries.size () < numBuffers) {
+		void *buffer;
+		if (posix_memalign (&buffer, 4096, pageSize) == 0)
+			freeBuffers.push_back (buffer);
+	}
+
+	// if they are all in use, recycle the one that has been staged the longest
+	// without anyone asking for it; if they are all still being read, forget it
+	if (freeBuffers.empty ()) {
+		EntryPtr oldest = nullptr;
+		for (auto &entry : entries) {
+			if (entry.second->state == Done && (oldest == nullptr || entry.second->seqNum < oldest->seqNum))
+				oldest = entry.second;
+		}
+		if (oldest == nullptr)
+			return;
+		drop (oldest);
+	}
+
+	// start up the I/O threads the first time that they are needed
+	if (workers.empty ()) {
+		for (size_t i = 0; i < numThreads; i++)
+			workers.push_back (thread (&MyDB_ReadAhead :: work, this));
+	}
+
+	EntryPtr entry = make_shared <Entry> ();
+	entry->tableID = tableID;
+	entry->fd = fd;
+	entry->pos = pos;
+	entry->bytes = freeBuffers.back ();
+	freeBuffers.pop_back ();
+	entry->state = Queued;
+	entry->seqNum = nextSeqNum++;
+
+	entries[key] = entry;
+	todo.push_back (entry);
+	workReady.notify_one ();
+}
+
+bool MyDB_ReadAhead :: consume (long tableID, size_t pos, void *intoMe) {
+
+	unique_lock <mutex> guard (latch);
+
+	auto it = entries.find (PageKey (tableID, pos));
+	if (it == entries.end ())
+		return false;
+	EntryPtr entry = it->second;
+
+	// if no I/O thread has gotten to the page yet, it is faster to read it ourselves
+	if (entry->state == Queued) {
+		drop (entry);
+		return false;
+	}
+
+	// otherwise, wait for the read to finish, and take the bytes
+	while (entry->state == Reading)
+		readDone.wait (guard);
+
+	if (entry->state != Done)
+		return false;
+
+	memcpy (intoMe, entry->bytes, pageSize);
+	drop (entry);
+	numHits++;
+	return true;
+}
+
+void MyDB_ReadAhead :: invalidate (long tableID, size_t pos) {
+
+	lock_guard <mutex> guard (latch);
+
+	auto it = entries.find (PageKey (tableID, pos));
+	if (it != entries.end ())
+		drop (it->second);
+}
+
+size_t MyDB_ReadAhead :: getNumHits () {
+	lock_guard <mutex> guard (latch);
+	return numHits;
+}
+
+void MyDB_ReadAhead :: drop (EntryPtr dropMe) {
+
+	entries.erase (PageKey (dropMe->tableID, dropMe->pos));
+
+	// if the page is being read, the I/O thread gives the buffer back when it is done
+	if (dropMe->state != Reading)
+		freeBuffers.push_back (dropMe->bytes);
+
+	dropMe->state = Dropped;
+}
+
+void MyDB_ReadAhead :: work () {
+
+	unique_lock <mutex> guard (latch);
+	while (true) {
+
+		while (!stopping && todo.empty ())
+			workReady.wait (guard);
+
+		if (stopping)
+			return;
+
+		// skip over pages that were dropped while they were waiting
+		EntryPtr entry = todo.front ();
+		todo.pop_front ();
+		if (entry->state != Queued)
+			continue;
+
+		// do the read without holding the latch
+		entry->state = Reading;
+		guard.unlock ();
+		ssize_t numRead = pread (entry->fd, entry->bytes, pageSize, entry->pos * pageSize);
+		if (numRead < (ssize_t) pageSize)
+			memset (((char *) entry->bytes) + max (numRead, (ssize_t) 0), 0, pageSize - max (numRead, (ssize_t) 0));
+		guard.lock ();
+
+		// if someone dropped the page while it was being read, nobody wants the bytes
+		if (entry->state == Dropped)
+			freeBuffers.push_back (entry->bytes);
+		else
+			entry->state = Done;
+
+		readDone.notify_all ();
+	}
+}
+
+#endif
@@ -0,0 +1,25 @@
+
+#ifndef REPLACEMENT_POLICY_C
+#define REPLACEMENT_POLICY_C
+
+#include "ClockProPolicy.h"
+#include "LRUKPolicy.h"
+#include "LRUPolicy.h"
+#include "MyDB_ReplacementPolicy.h"
+#include "TwoQPolicy.h"
+
+MyDB_ReplacementPolicyPtr MyDB_ReplacementPolicy :: create (MyDB_PolicyType type, size_t numPages) {
+	switch (type) {
+		case LRUKReplacement:
+			return make_shared <LRUKPolicy> (numPages);
+		case TwoQReplacement:
+			return make_shared <TwoQPolicy> (numPages);
+		case ClockProReplacement:
+			return make_shared <ClockProPolicy> (numPages);
+		default:
+			return make_shared <LRUPolicy> ();
+	}
+}
+
+#endif
+
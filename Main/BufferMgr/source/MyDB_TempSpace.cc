@@ -0,0 +1,190 @@
+
+#ifndef TEMP_SPACE_C
+#define TEMP_SPACE_C
+
+#include <fcntl.h>
+#include "MyDB_TempSpace.h"
+#include <unistd.h>
+
+// the number of pages in an extent
+#define EXTENT_PAGES 64
+
+MyDB_TempSpace :: MyDB_TempSpace (vector <string> fileNamesIn, size_t pageSizeIn, function <int (string)> openMeIn) {
+	fileNames = fileNamesIn;
+	fds.resize (fileNames.size (), -1);
+	pageSize = pageSizeIn;
+	openMe = openMeIn;
+	defaultExtent = -1;
+	numLive = 0;
+}
+
+MyDB_TempSpace :: ~MyDB_TempSpace () {
+	for (size_t i = 0; i < fileNames.size (); i++) {
+		if (fds[i] != -1)
+			close (fds[i]);
+		unlink (fileNames[i].c_str ());
+	}
+}
+
+bool MyDB_TempSpace :: setFiles (vector <string> fileNamesIn) {
+	lock_guard <mutex> guard (latch);
+	if (!extents.empty () || fileNamesIn.empty ())
+		return false;
+	fileNames = fileNamesIn;
+	fds.clear ();
+	fds.resize (fileNames.size (), -1);
+	return true;
+}
+
+size_t MyDB_TempSpace :: allocate (MyDB_TempRegion *inMe) {
+
+	lock_guard <mutex> guard (latch);
+	numLive++;
+
+	// default pages re-use the lowest free slot, if there is one
+	long extent;
+	if (inMe == nullptr) {
+		if (!freeSlots.empty ()) {
+			size_t pos = freeSlots.top ();
+			freeSlots.pop ();
+			extents[pos / EXTENT_PAGES].numLive++;
+			return pos;
+		}
+
+		if (defaultExtent == -1 || extents[defaultExtent].numAllocated == EXTENT_PAGES) {
+			if (defaultExtent != -1)
+				extents[defaultExtent].retired = true;
+			defaultExtent = newExtent (DefaultExtent);
+		}
+		extent = defaultExtent;
+
+	// pages of a region go right after the last one
+	} else {
+		if (inMe->extent == -1 || extents[inMe->extent].numAllocated == EXTENT_PAGES) {
+			long full = inMe->extent;
+			inMe->extent = newExtent (RegionExtent);
+			if (full != -1) {
+				extents[full].retired = true;
+				if (extents[full].numLive == 0)
+					freeExtent (full);
+			}
+		}
+		extent = inMe->extent;
+	}
+
+	Extent &fillMe = extents[extent];
+	fillMe.numLive++;
+	return extent * EXTENT_PAGES + fillMe.numAllocated++;
+}
+
+void MyDB_TempSpace :: release (size_t pos) {
+
+	lock_guard <mutex> guard (latch);
+	numLive--;
+
+	long extent = pos / EXTENT_PAGES;
+	Extent &releaseFrom = extents[extent];
+	releaseFrom.numLive--;
+
+	if (releaseFrom.owner == DefaultExtent)
+		freeSlots.push (pos);
+	else if (releaseFrom.numLive == 0 && releaseFrom.retired)
+		freeExtent (extent);
+}
+
+void MyDB_TempSpace :: retire (long extent) {
+	lock_guard <mutex> guard (latch);
+	extents[extent].retired = true;
+	if (extents[extent].numLive == 0)
+		freeExtent (extent);
+}
+
+void MyDB_TempSpace :: locate (size_t pos, int &fd, size_t &filePos) {
+	lock_guard <mutex> guard (latch);
+	size_t extent = pos / EXTENT_PAGES;
+	fd = fdFor (extent % fileNames.size ());
+	filePos = (extent / fileNames.size ()) * EXTENT_PAGES + pos % EXTENT_PAGES;
+}
+
+size_t MyDB_TempSpace :: getNumPages () {
+	lock_guard <mutex> guard (latch);
+	return numLive;
+}
+
+size_t MyDB_TempSpace :: getNumFilePages () {
+	lock_guard <mutex> guard (latch);
+	size_t returnVal = 0;
+	for (Extent &extent : extents) {
+		if (extent.owner != FreeExtent)
+			returnVal += EXTENT_PAGES;
+	}
+	return returnVal;
+}
+
+long MyDB_TempSpace :: newExtent (int owner) {
+
+	// use the free extent that is closest to the start of the files; the list can
+	// have extents that have been truncated away or re-used since they were freed
+	long returnVal = -1;
+	while (!freeExtents.empty () && returnVal == -1) {
+		long extent = freeExtents.top ();
+		freeExtents.pop ();
+		if (extent < (long) extents.size () && extents[extent].owner == FreeExtent)
+			returnVal = extent;
+	}
+
+	if (returnVal == -1) {
+		returnVal = extents.size ();
+		extents.push_back (Extent ());
+	}
+
+	Extent &extent = extents[returnVal];
+	extent.owner = owner;
+	extent.numAllocated = 0;
+	extent.numLive = 0;
+	extent.retired = false;
+	return returnVal;
+}
+
+void MyDB_TempSpace :: freeExtent (long extent) {
+
+	extents[extent].owner = FreeExtent;
+	size_t numFiles = fileNames.size ();
+
+	// an extent in the middle of a file becomes a hole, so the disk space is given back
+	if (extent != (long) extents.size () - 1) {
+		fallocate (fdFor (extent % numFiles), FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+			(extent / numFiles) * EXTENT_PAGES * pageSize, EXTENT_PAGES * pageSize);
+		freeExtents.push (extent);
+		return;
+	}
+
+	// but if it is at the end, the files can be cut short, along with any free
+	// extents before it
+	while (!extents.empty () && extents.back ().owner == FreeExtent)
+		extents.pop_back ();
+
+	for (size_t i = 0; i < numFiles; i++) {
+		size_t numExtents = extents.size () > i ? (extents.size () - i + numFiles - 1) / numFiles : 0;
+		if (fds[i] != -1)
+			ftruncate (fds[i], numExtents * EXTENT_PAGES * pageSize);
+	}
+}
+
+int MyDB_TempSpace :: fdFor (size_t whichFile) {
+	if (fds[whichFile] == -1)
+		fds[whichFile] = openMe (fileNames[whichFile]);
+	return fds[whichFile];
+}
+
+MyDB_TempRegion :: MyDB_TempRegion (MyDB_TempSpacePtr spaceIn) {
+	space = spaceIn;
+	extent = -1;
+}
+
+MyDB_TempRegion :: ~MyDB_TempRegion () {
+	if (extent != -1)
+		space->retire (extent);
+}
+
+#endif
@@ -0,0 +1,100 @@
+
+#ifndef TWOQ_POLICY_C
+#define TWOQ_POLICY_C
+
+#include "TwoQPolicy.h"
+
+TwoQPolicy :: TwoQPolicy (size_t numPages) {
+
+	// these are the settings recommended in the 2Q paper
+	kin = numPages / 4;
+	if (kin == 0)
+		kin = 1;
+
+	kout = numPages / 2;
+	if (kout == 0)
+		kout = 1;
+
+	numKickedOut = 0;
+}
+
+void TwoQPolicy :: pageIn (MyDB_Page *page) {
+
+	page->inPolicy = true;
+
+	// if the page was recently kicked out of A1in, it is hot
+	auto it = a1out.find (keyOf (page));
+	if (it != a1out.end ()) {
+		a1out.erase (it);
+		page->policyState = InAm;
+		am.pushFront (page);
+	} else {
+		page->policyState = InA1in;
+		a1in.pushFront (page);
+	}
+}
+
+void TwoQPolicy :: unpinned (MyDB_Page *page) {
+
+	page->inPolicy = true;
+
+	// a page that was pinned when it was read in has never been in a queue
+	if (page->policyState == InAm) {
+		am.pushFront (page);
+	} else {
+		page->policyState = InA1in;
+		a1in.pushFront (page);
+	}
+}
+
+void TwoQPolicy :: touch (MyDB_Page *page) {
+	if (page->policyState == InAm)
+		am.moveToFront (page);
+}
+
+void TwoQPolicy :: remove (MyDB_Page *page) {
+	page->inPolicy = false;
+	if (page->policyState == InAm)
+		am.remove (page);
+	else
+		a1in.remove (page);
+}
+
+MyDB_Page *TwoQPolicy :: victim () {
+
+	// take from A1in if it is over its target size (or if there is nothing else)
+	if (a1in.size () > kin || am.size () == 0) {
+
+		MyDB_Page *returnVal = a1in.popBack ();
+		if (returnVal == nullptr)
+			return nullptr;
+		returnVal->inPolicy = false;
+
+		// remember the page in A1out
+		PageKey key = keyOf (returnVal);
+		a1out[key] = ++numKickedOut;
+		a1outOrder.push (make_pair (key, numKickedOut));
+
+		while (a1outOrder.size () > kout) {
+			auto oldest = a1outOrder.front ();
+			a1outOrder.pop ();
+			auto it = a1out.find (oldest.first);
+			if (it != a1out.end () && it->second == oldest.second)
+				a1out.erase (it);
+		}
+
+		return returnVal;
+	}
+
+	// otherwise, kick out the LRU page in Am
+	MyDB_Page *returnVal = am.popBack ();
+	returnVal->inPolicy = false;
+	return returnVal;
+}
+
+size_t TwoQPolicy :: size () {
+	return a1in.size () + am.size ();
+}
+
+#endif
+
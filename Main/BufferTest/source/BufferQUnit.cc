@@ -4,10 +4,16 @@
 
 #include "MyDB_BufferManager.h"
 #include "MyDB_PageHandle.h"
+#include "MyDB_PageHeader.h"
 #include "MyDB_Table.h"
 #include "QUnit.h"
 #include <cstring>
+#include <fcntl.h>
 #include <iostream>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
 #include <time.h>
 #include <unistd.h>
 #include <vector>
@@ -271,6 +277,612 @@ int main () {
 	}
 	cout << "COMPLETE" << endl << flush;
 	QUNIT_IS_TRUE(flag9);
+
+	// replacement policies under a mixed trace: random point lookups into a hot set
+	// of pages, interleaved with a big sequential scan
+	cout << "TEST 10..." << flush;
+	{
+		MyDB_PolicyType policies[] = {LRUReplacement, LRUKReplacement, TwoQReplacement, ClockProReplacement};
+		const char *names[] = {"LRU", "LRU-K", "2Q", "CLOCK-Pro"};
+		double lookupHitRate[4];
+		for (int p = 0; p < 4; p++) {
+			MyDB_BufferManager myMgr(64, 64, "tempDSFSD", policies[p]);
+			MyDB_TablePtr table3 = make_shared <MyDB_Table>("table3", "file3");
+			srand48(530);
+			size_t lookups = 0, lookupHits = 0, scanPos = 0;
+			for (int i = 0; i < 40000; i++) {
+				if (i % 2 == 0) {
+					size_t hitsBefore = myMgr.getNumHits();
+					myMgr.getPage(table3, lrand48() % 48)->getBytes();
+					lookupHits += myMgr.getNumHits() - hitsBefore;
+					lookups++;
+				} else {
+					myMgr.getPage(table3, 1000 + (scanPos++ % 5000))->getBytes();
+				}
+			}
+			lookupHitRate[p] = lookupHits / (double) lookups;
+			cout << names[p] << ": " << lookupHitRate[p] << " of lookups, " 
+				<< myMgr.getNumHits() / (double) (myMgr.getNumHits() + myMgr.getNumMisses()) << " overall...";
+		}
+		cout << "shutdown manager..." << flush;
+		QUNIT_IS_TRUE(lookupHitRate[1] > lookupHitRate[0]);
+		QUNIT_IS_TRUE(lookupHitRate[2] > lookupHitRate[0]);
+		QUNIT_IS_TRUE(lookupHitRate[3] > lookupHitRate[0]);
+	}
+	cout << "COMPLETE" << endl << flush;
+
+	// pages that were read ahead have the right contents, even when the page
+	// was changed and written back after it was read ahead
+	bool flag11 = true;
+	cout << "TEST 11..." << flush;
+	{
+		cout << "create manager..." << flush;
+		MyDB_BufferManager myMgr(64, 4, "tempDSFSD");
+		MyDB_TablePtr table4 = make_shared <MyDB_Table>("table4", "file4");
+		cout << "write pages..." << flush;
+		for (int i = 0; i < 32; i++) {
+			MyDB_PageHandle page = myMgr.getPage(table4, i);
+			memset(page->getBytes(), 'a' + i % 26, 64);
+			page->wroteBytes();
+		}
+		cout << "read ahead..." << flush;
+		myMgr.readAhead(table4, 0, 31);
+		cout << "change page..." << flush;
+		{
+			MyDB_PageHandle page = myMgr.getPage(table4, 2);
+			memset(page->getBytes(), 'Z', 64);
+			page->wroteBytes();
+			for (int i = 20; i < 24; i++)
+				myMgr.getPage(table4, i)->getBytes();
+		}
+		cout << "compare bytes..." << flush;
+		for (int i = 0; i < 32; i++) {
+			char *bytes = (char *) myMgr.getPage(table4, i)->getBytes();
+			char expected = (i == 2) ? 'Z' : 'a' + i % 26;
+			for (int j = 0; j < 64; j++)
+				if (bytes[j] != expected) flag11 = false;
+		}
+		cout << myMgr.getNumReadAheadHits() << " pages read ahead..." << flush;
+		cout << "shutdown manager..." << flush;
+	}
+	QUNIT_IS_TRUE(flag11);
+	cout << "COMPLETE" << endl << flush;
+
+	// flushing a table writes its dirty pages to disk, without waiting for
+	// them to be kicked out or for the buffer manager to go away
+	bool flag12 = true;
+	cout << "TEST 12..." << flush;
+	{
+		cout << "create manager..." << flush;
+		MyDB_BufferManager myMgr(64, 128, "tempDSFSD");
+		MyDB_TablePtr table5 = make_shared <MyDB_Table>("table5", "file5");
+		MyDB_TablePtr table6 = make_shared <MyDB_Table>("table6", "file6");
+		cout << "write pages..." << flush;
+		vector <MyDB_PageHandle> pinned;
+		for (int i = 0; i < 48; i++) {
+			MyDB_PageHandle page = (i % 5 == 0) ? myMgr.getPinnedPage(table5, i) : myMgr.getPage(table5, i);
+			memset(page->getBytes(), 'a' + i % 26, 64);
+			page->wroteBytes();
+			if (i % 5 == 0)
+				pinned.push_back(page);
+			page = myMgr.getPage(table6, i);
+			memset(page->getBytes(), 'A' + i % 26, 64);
+			page->wroteBytes();
+		}
+		cout << "flush table..." << flush;
+		myMgr.flushTable(table5);
+		cout << "compare bytes..." << flush;
+		int fd = open("file5", O_RDONLY);
+		char bytes[64];
+		for (int i = 0; i < 48; i++) {
+			pread(fd, bytes, 64, i * 64);
+			for (int j = 0; j < 64; j++)
+				if (bytes[j] != 'a' + i % 26) flag12 = false;
+		}
+		close(fd);
+		cout << "flush all..." << flush;
+		myMgr.flushAll();
+		fd = open("file6", O_RDONLY);
+		for (int i = 0; i < 48; i++) {
+			pread(fd, bytes, 64, i * 64);
+			for (int j = 0; j < 64; j++)
+				if (bytes[j] != 'A' + i % 26) flag12 = false;
+		}
+		close(fd);
+		cout << "shutdown manager..." << flush;
+	}
+	QUNIT_IS_TRUE(flag12);
+	cout << "COMPLETE" << endl << flush;
+
+	// benchmark: repeatedly scan a table that is much bigger than the buffer,
+	// first going through the OS page cache, and then using direct I/O
+	bool flag13 = true;
+	cout << "TEST 13..." << flush;
+	{
+		const char *modes[] = {"buffered", "direct"};
+		for (int mode = 0; mode < 2; mode++) {
+			MyDB_BufferManager myMgr(4096, 64, "tempDSFSD", LRUReplacement, mode == 1);
+			MyDB_TablePtr table7 = make_shared <MyDB_Table>("table7", "file7");
+			if (mode == 0) {
+				cout << "write pages..." << flush;
+				for (int i = 0; i < 2048; i++) {
+					MyDB_PageHandle page = myMgr.getPage(table7, i);
+					memset(page->getBytes(), 'a' + i % 26, 4096);
+					page->wroteBytes();
+				}
+				myMgr.flushAll();
+			}
+			clock_t start = clock();
+			struct timespec begin, end;
+			clock_gettime(CLOCK_MONOTONIC, &begin);
+			for (int scan = 0; scan < 3; scan++) {
+				for (int i = 0; i < 2048; i++) {
+					char *bytes = (char *) myMgr.getPage(table7, i)->getBytes();
+					if (bytes[0] != 'a' + i % 26 || bytes[4095] != 'a' + i % 26) flag13 = false;
+					if (mode == 1 && ((size_t) bytes) % 4096 != 0) flag13 = false;
+				}
+			}
+			clock_gettime(CLOCK_MONOTONIC, &end);
+			cout << modes[mode] << ": " << (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9 
+				<< " secs (" << (clock() - start) / (double) CLOCKS_PER_SEC << " CPU)..." << flush;
+		}
+		cout << "shutdown manager..." << flush;
+	}
+	QUNIT_IS_TRUE(flag13);
+	cout << "COMPLETE" << endl << flush;
+
+	// the stats: counters, residency, temp file growth, and the periodic dump
+	bool flag14 = true;
+	cout << "TEST 14..." << flush;
+	{
+		cout << "create manager..." << flush;
+		MyDB_BufferManager myMgr(64, 16, "tempDSFSD");
+		MyDB_TablePtr table8 = make_shared <MyDB_Table>("table8", "file8");
+		stringstream dump;
+		myMgr.dumpStatsEvery(50, dump);
+		cout << "write pages..." << flush;
+		for (int i = 0; i < 40; i++) {
+			MyDB_PageHandle page = myMgr.getPage(table8, i);
+			memset(page->getBytes(), 'a' + i % 26, 64);
+			page->wroteBytes();
+		}
+		cout << "pin pages..." << flush;
+		vector <MyDB_PageHandle> pinned;
+		for (int i = 0; i < 16; i++)
+			pinned.push_back(myMgr.getPinnedPage(table8, i));
+		if (myMgr.getPinnedPage(table8, 16) != nullptr) flag14 = false;
+		MyDB_BufferStats stats = myMgr.getStats();
+		if (stats.numMisses < 40 || stats.numMisses != myMgr.getNumMisses()) flag14 = false;
+		if (stats.numEvictions < 40 || stats.numWriteBacks < 24) flag14 = false;
+		if (stats.numPinFailures != 1) flag14 = false;
+		if (stats.numFrames != 16 || stats.numFreeFrames != 0 || stats.numPinnedPages != 16) flag14 = false;
+		if (stats.residentPages["table8"] != 16 || stats.residentPages.size() != 1) flag14 = false;
+		size_t numReads = 0, numWrites = 0;
+		for (size_t count : stats.readLatency) numReads += count;
+		for (size_t count : stats.writeLatency) numWrites += count;
+		if (numReads == 0 || numReads > stats.numMisses || numWrites == 0) flag14 = false;
+		cout << "temp pages..." << flush;
+		pinned.clear();
+		vector <MyDB_PageHandle> temps;
+		for (int i = 0; i < 3; i++) {
+			temps.push_back(myMgr.getPage());
+			memset(temps[i]->getBytes(), 'x', 64);
+		}
+		stats = myMgr.getStats();
+		if (stats.tempFilePages != 3 || stats.residentPages["(temp)"] != 3) flag14 = false;
+		cout << "wait for dump..." << flush;
+		usleep(300000);
+		myMgr.dumpStatsEvery(0, dump);
+		if (dump.str().find("pin failures") == string::npos) flag14 = false;
+		stats.print(cout);
+		cout << "shutdown manager..." << flush;
+	}
+	QUNIT_IS_TRUE(flag14);
+	cout << "COMPLETE" << endl << flush;
+
+	// back-pressure: pin quotas, waiting for a frame, and the error when none comes
+	bool flag15 = true;
+	cout << "TEST 15..." << flush;
+	{
+		cout << "create manager..." << flush;
+		MyDB_BufferManager myMgr(64, 4, "tempDSFSD");
+		MyDB_TablePtr table9 = make_shared <MyDB_Table>("table9", "file9");
+		cout << "pin quota..." << flush;
+		MyDB_PinQuotaPtr quota = make_shared <MyDB_PinQuota>(2);
+		MyDB_PageHandle first = myMgr.getPinnedPage(table9, 0, quota);
+		MyDB_PageHandle second = myMgr.getPinnedPage(quota);
+		if (first == nullptr || second == nullptr || quota->getNumPinned() != 2) flag15 = false;
+		if (myMgr.getPinnedPage(table9, 1, quota) != nullptr) flag15 = false;
+		if (myMgr.getPinnedPage(table9, 0, quota) == nullptr) flag15 = false;
+		myMgr.unpin(first);
+		second = nullptr;
+		if (quota->getNumPinned() != 0 || myMgr.getNumUnpinnedFrames() != 4) flag15 = false;
+		cout << "wait for frame..." << flush;
+		vector <MyDB_PageHandle> pinned;
+		for (int i = 0; i < 4; i++)
+			pinned.push_back(myMgr.getPinnedPage(table9, i));
+		if (myMgr.getNumUnpinnedFrames() != 0) flag15 = false;
+		thread unpinner([&] () {
+			usleep(100000);
+			myMgr.unpin(pinned[3]);
+		});
+		struct timespec begin, end;
+		clock_gettime(CLOCK_MONOTONIC, &begin);
+		MyDB_PageHandle waited = myMgr.getPinnedPage(table9, 4);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		unpinner.join();
+		if (waited == nullptr || (end.tv_sec - begin.tv_sec) * 1000 + (end.tv_nsec - begin.tv_nsec) / 1000000 < 50) flag15 = false;
+		cout << "time out..." << flush;
+		myMgr.setFrameWaitTimeout(50);
+		if (myMgr.getPinnedPage(table9, 5) != nullptr) flag15 = false;
+		bool threw = false;
+		try {
+			myMgr.getPage(table9, 6)->getBytes();
+		} catch (MyDB_BufferFullError &e) {
+			threw = true;
+		}
+		if (!threw) flag15 = false;
+		cout << "shutdown manager..." << flush;
+	}
+	QUNIT_IS_TRUE(flag15);
+	cout << "COMPLETE" << endl << flush;
+
+	// the temp space: regions laid out in extents over two directories, and the
+	// extents given back as the regions' pages go away
+	bool flag16 = true;
+	cout << "TEST 16..." << flush;
+	{
+		cout << "create manager..." << flush;
+		mkdir("tempDir1", 0777);
+		mkdir("tempDir2", 0777);
+		MyDB_BufferManager myMgr(64, 8, "tempDSFSD");
+		myMgr.useTempDirectories({"tempDir1", "tempDir2"});
+		cout << "write regions..." << flush;
+		vector <MyDB_PageHandle> pagesA, pagesB, pagesC;
+		MyDB_TempRegionPtr regionA = myMgr.makeTempRegion();
+		MyDB_TempRegionPtr regionB = myMgr.makeTempRegion();
+		for (int i = 0; i < 64; i++) {
+			pagesA.push_back(myMgr.getPage(regionA));
+			memset(pagesA[i]->getBytes(), 'a' + i % 26, 64);
+			pagesA[i]->wroteBytes();
+			pagesB.push_back(myMgr.getPage(regionB));
+			memset(pagesB[i]->getBytes(), 'A' + i % 26, 64);
+			pagesB[i]->wroteBytes();
+		}
+		struct stat fileInfo;
+		if (stat("tempDir1/tempDSFSD", &fileInfo) != 0 || fileInfo.st_size == 0) flag16 = false;
+		if (stat("tempDir2/tempDSFSD", &fileInfo) != 0 || fileInfo.st_size == 0) flag16 = false;
+		MyDB_BufferStats stats = myMgr.getStats();
+		if (stats.tempFilePages != 128 || stats.tempSpacePages != 128) flag16 = false;
+		cout << "free region..." << flush;
+		pagesA.clear();
+		regionA = nullptr;
+		if (myMgr.getStats().tempSpacePages != 64) flag16 = false;
+		cout << "reuse extent..." << flush;
+		MyDB_TempRegionPtr regionC = myMgr.makeTempRegion();
+		for (int i = 0; i < 10; i++) {
+			pagesC.push_back(myMgr.getPage(regionC));
+			memset(pagesC[i]->getBytes(), '0' + i, 64);
+			pagesC[i]->wroteBytes();
+		}
+		if (myMgr.getStats().tempSpacePages != 128) flag16 = false;
+		cout << "read back..." << flush;
+		for (int i = 0; i < 64; i++) {
+			char *bytes = (char *) pagesB[i]->getBytes();
+			if (bytes[0] != 'A' + i % 26 || bytes[63] != 'A' + i % 26) flag16 = false;
+		}
+		for (int i = 0; i < 10; i++) {
+			char *bytes = (char *) pagesC[i]->getBytes();
+			if (bytes[0] != '0' + i || bytes[63] != '0' + i) flag16 = false;
+		}
+		cout << "free all..." << flush;
+		pagesB.clear();
+		pagesC.clear();
+		regionB = nullptr;
+		regionC = nullptr;
+		stats = myMgr.getStats();
+		if (stats.tempFilePages != 0 || stats.tempSpacePages != 0) flag16 = false;
+		if (stat("tempDir1/tempDSFSD", &fileInfo) != 0 || fileInfo.st_size != 0) flag16 = false;
+		if (stat("tempDir2/tempDSFSD", &fileInfo) != 0 || fileInfo.st_size != 0) flag16 = false;
+		cout << "shutdown manager..." << flush;
+	}
+	rmdir("tempDir1");
+	rmdir("tempDir2");
+	QUNIT_IS_TRUE(flag16);
+	cout << "COMPLETE" << endl << flush;
+
+	// checksums: a page with a header that is damaged on disk is caught when it is
+	// read, but damage past the used part of a page, or to a raw page, is not
+	bool flag17 = true;
+	cout << "TEST 17..." << flush;
+	{
+		if (MyDB_PageHeader::crc32c("123456789", 9) != 0xe3069283) flag17 = false;
+		if (MyDB_PageHeader::crc32cSoftware("123456789", 9) != 0xe3069283) flag17 = false;
+		unlink("file10");
+		MyDB_TablePtr table10 = make_shared <MyDB_Table>("table10", "file10");
+		{
+			cout << "write pages..." << flush;
+			MyDB_BufferManager myMgr(1024, 8, "tempDSFSD");
+			for (int i = 0; i < 16; i++) {
+				MyDB_PageHandle page = myMgr.getPage(table10, i);
+				char *bytes = (char *) page->getBytes();
+				MyDB_PageHeader::format(bytes);
+				memset(bytes + sizeof(MyDB_PageHeader), 'a' + i, 512 - sizeof(MyDB_PageHeader));
+				((MyDB_PageHeader *) bytes)->numBytesUsed = 512;
+				page->wroteBytes();
+			}
+			MyDB_PageHandle page = myMgr.getPage(table10, 16);
+			memset(page->getBytes(), 'z', 1024);
+			page->wroteBytes();
+		}
+		cout << "damage pages..." << flush;
+		int fd = open("file10", O_WRONLY);
+		pwrite(fd, "X", 1, 5 * 1024 + 100);
+		pwrite(fd, "X", 1, 7 * 1024 + 800);
+		pwrite(fd, "X", 1, 16 * 1024 + 100);
+		close(fd);
+		cout << "read pages..." << flush;
+		MyDB_BufferManager myMgr(1024, 8, "tempDSFSD");
+		int numBad = 0;
+		for (int i = 0; i < 17; i++) {
+			try {
+				myMgr.getPage(table10, i)->getBytes();
+			} catch (MyDB_PageCorruptError &e) {
+				if (i != 5) flag17 = false;
+				numBad++;
+			}
+		}
+		if (numBad != 1 || myMgr.getStats().numChecksumFailures != 1) flag17 = false;
+		myMgr.setChecksums(false);
+		char *bytes = (char *) myMgr.getPage(table10, 5)->getBytes();
+		if (bytes[100] != 'X' || bytes[101] != 'a' + 5) flag17 = false;
+		cout << "shutdown manager..." << flush;
+	}
+	QUNIT_IS_TRUE(flag17);
+	cout << "COMPLETE" << endl << flush;
+
+	// benchmark: the cost of CRC32C, and of scanning a table that is much bigger
+	// than the buffer with and without checksums
+	bool flag18 = true;
+	cout << "TEST 18..." << flush;
+	{
+		vector <char> data(131072, 'q');
+		const char *kinds[] = {"software", "hardware"};
+		for (int kind = 0; kind < 2; kind++) {
+			if (kind == 1 && !MyDB_PageHeader::hasHardwareCRC())
+				continue;
+			struct timespec begin, end;
+			clock_gettime(CLOCK_MONOTONIC, &begin);
+			unsigned sum = 0;
+			for (int i = 0; i < 512; i++) {
+				data[i] = (char) i;
+				sum += kind == 0 ? MyDB_PageHeader::crc32cSoftware(data.data(), data.size()) :
+					MyDB_PageHeader::crc32c(data.data(), data.size());
+			}
+			clock_gettime(CLOCK_MONOTONIC, &end);
+			double secs = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+			cout << kinds[kind] << " CRC: " << 64 / secs << " MB/sec (" << sum % 10 << ")..." << flush;
+		}
+		if (MyDB_PageHeader::crc32c(data.data(), data.size()) != MyDB_PageHeader::crc32cSoftware(data.data(), data.size()))
+			flag18 = false;
+
+		const char *modes[] = {"no checksums", "checksums"};
+		MyDB_TablePtr table11 = make_shared <MyDB_Table>("table11", "file11");
+		for (int mode = 0; mode < 2; mode++) {
+			MyDB_BufferManager myMgr(4096, 64, "tempDSFSD");
+			if (mode == 0) {
+				cout << "write pages..." << flush;
+				for (int i = 0; i < 2048; i++) {
+					MyDB_PageHandle page = myMgr.getPage(table11, i);
+					char *bytes = (char *) page->getBytes();
+					MyDB_PageHeader::format(bytes);
+					memset(bytes + sizeof(MyDB_PageHeader), 'a' + i % 26, 4096 - sizeof(MyDB_PageHeader));
+					((MyDB_PageHeader *) bytes)->numBytesUsed = 4096;
+					page->wroteBytes();
+				}
+				myMgr.flushAll();
+			}
+			myMgr.setChecksums(mode == 1);
+			struct timespec begin, end;
+			clock_gettime(CLOCK_MONOTONIC, &begin);
+			for (int scan = 0; scan < 3; scan++) {
+				for (int i = 0; i < 2048; i++) {
+					char *bytes = (char *) myMgr.getPage(table11, i)->getBytes();
+					if (bytes[4095] != 'a' + i % 26) flag18 = false;
+				}
+			}
+			clock_gettime(CLOCK_MONOTONIC, &end);
+			cout << modes[mode] << ": " << (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9 
+				<< " secs..." << flush;
+			if (myMgr.getStats().numChecksumFailures != 0) flag18 = false;
+		}
+		cout << "shutdown manager..." << flush;
+	}
+	QUNIT_IS_TRUE(flag18);
+	cout << "COMPLETE" << endl << flush;
+
+	// crash in the middle of writing a table that is being logged, by having a
+	// child process exit without shutting down its buffer manager; everything that
+	// was committed has to be redone from the log, and an action that had not
+	// ended must not be.  Then check that threads that commit at the same time
+	// share their syncs of the log
+	bool flag19 = true;
+	cout << "TEST 19..." << flush;
+	{
+		unlink("file12");
+		unlink("walLog");
+		MyDB_TablePtr table12 = make_shared <MyDB_Table>("table12", "file12");
+		cout << "write pages and crash..." << flush;
+		pid_t child = fork();
+		if (child == 0) {
+			MyDB_BufferManager myMgr(1024, 8, "tempDSFSD");
+			myMgr.useLog("walLog");
+			for (int i = 0; i < 64; i++) {
+				MyDB_PageHandle page = myMgr.getPage(table12, i);
+				char *bytes = (char *) page->getBytes();
+				MyDB_PageHeader::format(bytes);
+				memset(bytes + sizeof(MyDB_PageHeader), 'a' + i % 26, 512);
+				((MyDB_PageHeader *) bytes)->numBytesUsed = 512 + sizeof(MyDB_PageHeader);
+				page->wroteBytes(0, 512 + sizeof(MyDB_PageHeader));
+			}
+			myMgr.commit();
+
+			// the pages were kicked out, so some of them had to wait for the log
+			bool ok = myMgr.getStats().numLogWaits > 0;
+
+			// this is never redone
+			myMgr.beginAction();
+			for (int i = 0; i < 2; i++) {
+				MyDB_PageHandle page = myMgr.getPage(table12, i);
+				char *bytes = (char *) page->getBytes();
+				memset(bytes + sizeof(MyDB_PageHeader), 'Z', 512);
+				page->wroteBytes(sizeof(MyDB_PageHeader), 512);
+			}
+			myMgr.commit();
+			_exit(ok ? 0 : 1);
+		}
+		int status;
+		waitpid(child, &status, 0);
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) flag19 = false;
+
+		cout << "recover..." << flush;
+		{
+			MyDB_BufferManager myMgr(1024, 8, "tempDSFSD");
+			myMgr.useLog("walLog");
+			if (myMgr.getRecoveredLastPage(table12) != 63) flag19 = false;
+			for (int i = 0; i < 64; i++) {
+				char *bytes = (char *) myMgr.getPage(table12, i)->getBytes();
+				if (bytes[sizeof(MyDB_PageHeader)] != 'a' + i % 26 || bytes[sizeof(MyDB_PageHeader) + 511] != 'a' + i % 26)
+					flag19 = false;
+			}
+			if (myMgr.getStats().numChecksumFailures != 0) flag19 = false;
+		}
+
+		cout << "group commit..." << flush;
+		{
+			MyDB_BufferManager myMgr(1024, 64, "tempDSFSD");
+			myMgr.useLog("walLog");
+			vector <thread> threads;
+			for (int t = 0; t < 4; t++) {
+				threads.push_back(thread([&myMgr, &table12, t] () {
+					for (int i = 0; i < 100; i++) {
+						MyDB_PageHandle page = myMgr.getPage(table12, t * 16 + i % 16);
+						char *bytes = (char *) page->getBytes();
+						bytes[sizeof(MyDB_PageHeader) + i] = 'A' + t;
+						page->wroteBytes(sizeof(MyDB_PageHeader) + i, 1);
+						myMgr.commit();
+					}
+				}));
+			}
+			for (thread &t : threads)
+				t.join();
+			MyDB_BufferStats stats = myMgr.getStats();
+			cout << stats.numLogGroups << " groups in " << stats.numLogSyncs << " syncs..." << flush;
+			if (stats.numLogGroups != 400 || stats.numLogSyncs >= 400) flag19 = false;
+		}
+		cout << "shutdown manager..." << flush;
+	}
+	QUNIT_IS_TRUE(flag19);
+	cout << "COMPLETE" << endl << flush;
+
+	// write back pages that cannot be written (the table is on a device that is
+	// always full); they have to stay dirty, and be tried again, rather than being
+	// treated as if they were on disk
+	bool flag20 = true;
+	cout << "TEST 20..." << flush;
+	{
+		cout << "create manager..." << flush;
+		MyDB_TablePtr table13 = make_shared <MyDB_Table>("table13", "/dev/full");
+		MyDB_BufferManager myMgr(1024, 8, "tempDSFSD");
+		cout << "write pages..." << flush;
+		vector <MyDB_PageHandle> pages;
+		for (int i = 0; i < 4; i++) {
+			pages.push_back(myMgr.getPage(table13, i));
+			memset(pages[i]->getBytes(), 'a' + i, 1024);
+			pages[i]->wroteBytes();
+		}
+		cout << "flush table..." << flush;
+		myMgr.flushTable(table13);
+		MyDB_BufferStats stats = myMgr.getStats();
+		if (stats.numWriteFailures != 4 || stats.numWriteBacks != 0) flag20 = false;
+		myMgr.flushTable(table13);
+		if (myMgr.getStats().numWriteFailures != 8) flag20 = false;
+		for (int i = 0; i < 4; i++) {
+			char *bytes = (char *) pages[i]->getBytes();
+			if (bytes[0] != 'a' + i || bytes[1023] != 'a' + i) flag20 = false;
+		}
+		cout << "kick out pages..." << flush;
+		pages.clear();
+		unlink("file14");
+		MyDB_TablePtr table14 = make_shared <MyDB_Table>("table14", "file14");
+		for (int i = 0; i < 32; i++) {
+			MyDB_PageHandle page = myMgr.getPage(table14, i);
+			memset(page->getBytes(), 'A' + i % 26, 1024);
+			page->wroteBytes();
+		}
+		for (int i = 0; i < 4; i++) {
+			char *bytes = (char *) myMgr.getPage(table13, i)->getBytes();
+			if (bytes[0] != 'a' + i || bytes[1023] != 'a' + i) flag20 = false;
+		}
+		if (myMgr.getStats().numWriteFailures <= 8) flag20 = false;
+		cout << "shutdown manager..." << flush;
+	}
+	QUNIT_IS_TRUE(flag20);
+	cout << "COMPLETE" << endl << flush;
+
+	// a page whose header is gone is taken to be a legacy page, unless the table
+	// was written in a format with headers; then it is damaged.  A page past the
+	// end of the file has never been written, so it is fine either way
+	bool flag21 = true;
+	cout << "TEST 21..." << flush;
+	{
+		unlink("file15");
+		MyDB_TablePtr table15 = make_shared <MyDB_Table>("table15", "file15");
+		{
+			cout << "write pages..." << flush;
+			MyDB_BufferManager myMgr(1024, 8, "tempDSFSD");
+			for (int i = 0; i < 4; i++) {
+				MyDB_PageHandle page = myMgr.getPage(table15, i);
+				char *bytes = (char *) page->getBytes();
+				MyDB_PageHeader::format(bytes);
+				memset(bytes + sizeof(MyDB_PageHeader), 'a' + i, 512 - sizeof(MyDB_PageHeader));
+				((MyDB_PageHeader *) bytes)->numBytesUsed = 512;
+				page->wroteBytes();
+			}
+		}
+		cout << "damage page..." << flush;
+		vector <char> zeros(sizeof(MyDB_PageHeader), 0);
+		int fd = open("file15", O_WRONLY);
+		pwrite(fd, zeros.data(), zeros.size(), 2 * 1024);
+		close(fd);
+		cout << "read pages..." << flush;
+		{
+			MyDB_BufferManager myMgr(1024, 8, "tempDSFSD");
+			try {
+				char *bytes = (char *) myMgr.getPage(table15, 2)->getBytes();
+				if (bytes[sizeof(MyDB_PageHeader)] != 'a' + 2) flag21 = false;
+			} catch (MyDB_PageCorruptError &e) {
+				flag21 = false;
+			}
+		}
+		table15->setPageFormat(PAGE_FORMAT_VERSION);
+		{
+			MyDB_BufferManager myMgr(1024, 8, "tempDSFSD");
+			int numBad = 0;
+			for (int i = 0; i < 6; i++) {
+				try {
+					myMgr.getPage(table15, i)->getBytes();
+				} catch (MyDB_PageCorruptError &e) {
+					if (i != 2) flag21 = false;
+					numBad++;
+				}
+			}
+			if (numBad != 1 || myMgr.getStats().numChecksumFailures != 1) flag21 = false;
+			cout << "shutdown manager..." << flush;
+		}
+	}
+	QUNIT_IS_TRUE(flag21);
+	cout << "COMPLETE" << endl << flush;
 }
 
 #endif
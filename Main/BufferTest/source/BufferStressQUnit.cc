@@ -0,0 +1,192 @@
+#ifndef BUFFER_STRESS_UNIT_H
+#define BUFFER_STRESS_UNIT_H
+
+#include "MyDB_BufferManager.h"
+#include "MyDB_PageHandle.h"
+#include "MyDB_Table.h"
+#include "QUnit.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+#define PAGE_SIZE 1024
+#define NUM_FRAMES 256
+#define NUM_TABLE_PAGES 2048
+#define OPS_PER_THREAD 20000
+
+// fills up the page with a pattern that depends only on the page number
+void fillPage(char *bytes, size_t pageNum) {
+	for (size_t j = 0; j < PAGE_SIZE; j++)
+		bytes[j] = 'a' + (pageNum + j) % 26;
+}
+
+// makes sure that the page has the pattern written by fillPage
+bool checkPage(char *bytes, size_t pageNum) {
+	for (size_t j = 0; j < PAGE_SIZE; j++)
+		if (bytes[j] != (char) ('a' + (pageNum + j) % 26))
+			return false;
+	return true;
+}
+
+// one worker in the stress test: pins random table pages, checks and re-writes
+// them (so that dirty pages are constantly being written back), and mixes in
+// temp pages and unpinned handles that come and go.  Each worker only writes the
+// table pages whose number is its own thread number mod numThreads, since the
+// buffer manager does not stop two threads from writing the same pinned page
+void worker(MyDB_BufferManager &myMgr, MyDB_TablePtr table, int whichThread, int numThreads, atomic<int> &errors) {
+	unsigned short seed[3] = {530, (unsigned short) whichThread, 17};
+	for (int i = 0; i < OPS_PER_THREAD; i++) {
+		size_t pageNum = (nrand48(seed) % (NUM_TABLE_PAGES / numThreads)) * numThreads + whichThread;
+		if (i % 4 == 3) {
+			MyDB_PageHandle temp = myMgr.getPinnedPage();
+			if (temp == nullptr) {
+				errors++;
+				continue;
+			}
+			char *bytes = (char *) temp->getBytes();
+			memset(bytes, 'A' + whichThread, PAGE_SIZE);
+			temp->wroteBytes();
+			for (size_t j = 0; j < PAGE_SIZE; j++)
+				if (bytes[j] != 'A' + whichThread)
+					errors++;
+		} else if (i % 4 == 2) {
+			MyDB_PageHandle page = myMgr.getPage(table, pageNum);
+			MyDB_PageHandle other = myMgr.getPage(table, pageNum);
+			if (page->getBytes() == nullptr)
+				errors++;
+		} else {
+			MyDB_PageHandle page = myMgr.getPinnedPage(table, pageNum);
+			if (page == nullptr) {
+				errors++;
+				continue;
+			}
+			char *bytes = (char *) page->getBytes();
+			if (!checkPage(bytes, pageNum))
+				errors++;
+			fillPage(bytes, pageNum);
+			page->wroteBytes();
+		}
+	}
+}
+
+// runs the workers with the given number of threads, and returns the throughput
+double runWorkers(int numThreads, atomic<int> &errors) {
+	MyDB_BufferManager myMgr(PAGE_SIZE, NUM_FRAMES, "tempDSFSD");
+	MyDB_TablePtr table = make_shared <MyDB_Table>("stressTable", "stressFile");
+	auto start = chrono::steady_clock::now();
+	vector <thread> threads;
+	for (int t = 0; t < numThreads; t++)
+		threads.push_back(thread(worker, ref(myMgr), table, t, numThreads, ref(errors)));
+	for (auto &t : threads)
+		t.join();
+	double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	return numThreads * OPS_PER_THREAD / secs;
+}
+
+// one worker in the flush test: bumps a count kept in each of its pages, and
+// checks that the page still has the count that it last wrote, so a page that
+// is read back in before its write back lands is caught
+void counter(MyDB_BufferManager &myMgr, MyDB_TablePtr table, int whichThread, int numThreads, atomic<int> &errors) {
+	unsigned short seed[3] = {77, (unsigned short) whichThread, 3};
+	vector <int> counts(NUM_TABLE_PAGES / numThreads, 0);
+	for (int i = 0; i < OPS_PER_THREAD; i++) {
+		size_t which = nrand48(seed) % counts.size();
+		MyDB_PageHandle page = myMgr.getPinnedPage(table, which * numThreads + whichThread);
+		if (page == nullptr) {
+			errors++;
+			continue;
+		}
+		int *bytes = (int *) page->getBytes();
+		if (bytes[0] != counts[which])
+			errors++;
+		bytes[0] = ++counts[which];
+		page->wroteBytes();
+	}
+}
+
+int main () {
+
+	QUnit::UnitTest qunit(cerr, QUnit::normal);
+
+	// write all of the table pages from a single thread
+	cout << "TEST 1..." << flush;
+	{
+		MyDB_BufferManager myMgr(PAGE_SIZE, NUM_FRAMES, "tempDSFSD");
+		MyDB_TablePtr table = make_shared <MyDB_Table>("stressTable", "stressFile");
+		for (size_t i = 0; i < NUM_TABLE_PAGES; i++) {
+			MyDB_PageHandle page = myMgr.getPage(table, i);
+			fillPage((char *) page->getBytes(), i);
+			page->wroteBytes();
+		}
+	}
+	cout << "COMPLETE" << endl << flush;
+	QUNIT_IS_TRUE(true);
+
+	// hammer the buffer manager from one thread and then from many threads
+	cout << "TEST 2..." << flush;
+	{
+		atomic<int> errors(0);
+		int numThreads = thread::hardware_concurrency();
+		if (numThreads < 2)
+			numThreads = 2;
+		if (numThreads > 8)
+			numThreads = 8;
+		double oneThread = runWorkers(1, errors);
+		double manyThreads = runWorkers(numThreads, errors);
+		cout << "1 thread: " << (long) oneThread << " ops/sec, " << numThreads << " threads: "
+			<< (long) manyThreads << " ops/sec..." << flush;
+		QUNIT_IS_EQUAL(errors.load(), 0);
+	}
+	cout << "COMPLETE" << endl << flush;
+
+	// and make sure that everything made it back to disk
+	cout << "TEST 3..." << flush;
+	{
+		MyDB_BufferManager myMgr(PAGE_SIZE, NUM_FRAMES, "tempDSFSD");
+		MyDB_TablePtr table = make_shared <MyDB_Table>("stressTable", "stressFile");
+		bool flag = true;
+		for (size_t i = 0; i < NUM_TABLE_PAGES; i++) {
+			MyDB_PageHandle page = myMgr.getPage(table, i);
+			if (!checkPage((char *) page->getBytes(), i))
+				flag = false;
+		}
+		QUNIT_IS_TRUE(flag);
+	}
+	cout << "COMPLETE" << endl << flush;
+
+	// write back everything over and over while the pages are being changed and
+	// kicked out, so that the writes race with both
+	cout << "TEST 4..." << flush;
+	{
+		atomic<int> errors(0);
+		atomic<bool> done(false);
+		MyDB_BufferManager myMgr(PAGE_SIZE, NUM_FRAMES / 4, "tempDSFSD");
+		MyDB_TablePtr table = make_shared <MyDB_Table>("flushTable", "flushFile");
+		for (size_t i = 0; i < NUM_TABLE_PAGES; i++) {
+			MyDB_PageHandle page = myMgr.getPage(table, i);
+			memset(page->getBytes(), 0, PAGE_SIZE);
+			page->wroteBytes();
+		}
+		thread flusher([&myMgr, &done] () {
+			while (!done)
+				myMgr.flushAll();
+		});
+		vector <thread> threads;
+		for (int t = 0; t < 4; t++)
+			threads.push_back(thread(counter, ref(myMgr), table, t, 4, ref(errors)));
+		for (auto &t : threads)
+			t.join();
+		done = true;
+		flusher.join();
+		QUNIT_IS_EQUAL(errors.load(), 0);
+	}
+	cout << "COMPLETE" << endl << flush;
+}
+
+#endif
@@ -54,6 +54,12 @@ public:
 	// saves any updates to the catalog
 	void save ();
 
+	// returns the dense integer identifier for the named table.  Tables are
+	// identified by name, so every table object with a given name gets the
+	// same identifier; identifiers are handed out as 0, 1, 2, ... in the order
+	// that table names are first seen by the process
+	static size_t getTableID (string tableName);
+
 	//table list related
 	void add_to_list(string,string);
 
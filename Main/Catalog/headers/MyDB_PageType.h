@@ -1,3 +1,9 @@
 
-// this lists all of the different page types
-enum MyDB_PageType {RegularPage, DirectoryPage};
+#ifndef PAGE_TYPE_H
+#define PAGE_TYPE_H
+
+// this lists all of the different page types; a PaxPage holds records column
+// by column (see MyDB_PaxPage.h) rather than one after another
+enum MyDB_PageType {RegularPage, DirectoryPage, PaxPage};
+
+#endif
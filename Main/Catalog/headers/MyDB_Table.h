@@ -6,6 +6,7 @@
 #include "MyDB_Catalog.h"
 #include "MyDB_Schema.h"
 #include "MyDB_Table.h"
+#include "MyDB_ZoneMap.h"
 #include <memory>
 #include <string>
 
@@ -71,11 +72,32 @@ public:
 	// the sort att
 	string &getSortAtt ();
 
-	// the file type (ex: "heap" or "bplustree")
+	// the file type (ex: "heap", "bplustree", or "pax", which is a heap whose
+	// pages keep the values of each attribute together, or "compressed", which
+	// is the same, except that the pages are compressed; see MyDB_PaxPage.h)
 	string &getFileType ();
 
+	// get the dense integer identifier for this table, as assigned by the catalog
+	size_t getID ();
+
+	// the version of the page format (see MyDB_PageHeader.h) that the pages of the
+	// table were written in; 0 if they were written before pages had a header, or
+	// not by a MyDB_TableReaderWriter.  A page of a table with a non-zero format
+	// that has no header has been damaged, rather than being an old page
+	int getPageFormat ();
+	void setPageFormat (int toMe);
+
+	// get the zone map of the table (the range of values of each attribute on
+	// each page); it is written to a file next to the table when the table is
+	// put into the catalog, and read back when the table is taken out of it
+	MyDB_ZoneMapPtr getZoneMap ();
+
 private:
 
+	// the identifier of the table; it is assigned as soon as the table has a name,
+	// so that reading it from several threads is safe (-1 until then)
+	long id;
+
 	// the name of the sort att
 	string sortAtt;
 
@@ -85,6 +107,9 @@ private:
 	// the last used page in the table
 	int last;
 
+	// the page format that the table was written in
+	int pageFormat;
+
 	// the name of the table
 	string tableName;
 
@@ -93,6 +118,11 @@ private:
 
 	// the schema for this table
 	MyDB_SchemaPtr mySchema;
+
+	// the zone map, and the file that it was written to (empty if none); the
+	// zone map is not read in until it is asked for
+	MyDB_ZoneMapPtr zoneMap;
+	string zoneFile;
 };
 
 #endif
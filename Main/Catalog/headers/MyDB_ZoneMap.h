@@ -0,0 +1,101 @@
+
+#ifndef ZONE_MAP_H
+#define ZONE_MAP_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "MyDB_AttVal.h"
+#include "MyDB_Schema.h"
+
+using namespace std;
+
+// create a smart pointer for zone maps
+class MyDB_ZoneMap;
+typedef shared_ptr <MyDB_ZoneMap> MyDB_ZoneMapPtr;
+
+// a range of values for one attribute of a table, used to filter a scan; both
+// ends are inclusive, and an end that is null is open
+struct MyDB_AttRange {
+	int whichAtt;
+	MyDB_AttValPtr low;
+	MyDB_AttValPtr high;
+};
+
+// For each page of a table, the zone map has the number of records that have
+// been put on the page, and the smallest and largest value of each attribute
+// among them.  So a scan for the records in some range of values can skip the
+// pages that cannot have any.
+//
+// The zone of a page is only known from the time the page is cleared; pages
+// that have not been cleared since the zone map was started (say, the pages of
+// a table written before zone maps existed) are always scanned.  Records that
+// are deleted from a page are not taken out of its zone, so a zone can only be
+// bigger than it has to be, never smaller.  Ints, doubles, and bools are
+// compared as numbers, and strings byte by byte.  Like the last page of the
+// table, what is on disk is only as up to date as the last time that the table
+// was put into the catalog; the first time a zone changes after the zone map is
+// written or read, the file is removed, so that pages written since then (and
+// maybe flushed) are not skipped because of it
+class MyDB_ZoneMap {
+
+public:
+
+	// creates an empty zone map for a table with the given schema
+	MyDB_ZoneMap (MyDB_SchemaPtr forMe);
+
+	// the given page has just been cleared, so it has no records
+	void clearPage (size_t whichPage);
+
+	// adds a value of the given attribute to the zone of the page; this should
+	// be called for each attribute of a record put on the page, and then
+	// addRecord called once
+	void addValue (size_t whichPage, size_t whichAtt, MyDB_AttValPtr val);
+	void addRecord (size_t whichPage);
+
+	// returns false if the zone of the page says that none of its records can
+	// have their values in all of the ranges
+	bool mightMatch (size_t whichPage, vector <MyDB_AttRange> &filter);
+
+	// the number of records put on the page, or -1 if its zone is not known
+	long getNumRecords (size_t whichPage);
+
+	// forgets all of the zones, so that every page is scanned
+	void invalidate ();
+
+	// writes the zone map to the given file, and reads it back; the load fails
+	// (and the zone map is left empty) if the file is not there or is not a
+	// zone map for a table with this many attributes.  Either way, the file is
+	// removed once the zone map changes
+	void save (string toMe);
+	bool load (string fromMe);
+
+private:
+
+	// the zone of one page
+	struct Zone {
+		bool known;
+		long numRecords;
+		vector <double> lowNum, highNum;
+		vector <string> lowStr, highStr;
+	};
+
+	// makes sure that there is a zone for the page
+	Zone &getZone (size_t whichPage);
+
+	// called before any zone changes; removes the file that the zone map was
+	// last written to or read from, if it is still there
+	void changing ();
+
+	// that file, or empty if there is none
+	string onDisk;
+
+	// for each attribute, true if it is compared as a string, and true if it is a bool
+	vector <bool> isString;
+	vector <bool> isBool;
+
+	// the zones of the pages, by page number
+	vector <Zone> zones;
+};
+
+#endif
@@ -5,6 +5,7 @@
 #include "MyDB_Catalog.h"
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <string>
 
@@ -214,6 +215,23 @@ void MyDB_Catalog :: traverse_name_list()
 	return;
 }
 
+size_t MyDB_Catalog :: getTableID (string tableName) {
+
+	// this maps each table name that we have seen to its identifier; tables
+	// may be opened by several threads at once, so the map is latched
+	static map <string, size_t> allIDs;
+	static mutex allIDsLock;
+	lock_guard <mutex> guard (allIDsLock);
+
+	auto it = allIDs.find (tableName);
+	if (it != allIDs.end ())
+		return it->second;
+
+	size_t returnVal = allIDs.size ();
+	allIDs [tableName] = returnVal;
+	return returnVal;
+}
+
 void MyDB_Catalog :: save () {
 
 	ofstream myFile (fName, ofstream::out | ofstream::trunc);
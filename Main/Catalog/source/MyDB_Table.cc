@@ -8,6 +8,8 @@ MyDB_Table :: MyDB_Table (string name, string storageLocIn) {
 	tableName = name;
 	storageLoc = storageLocIn;
 	last = -1;
+	pageFormat = 0;
+	id = MyDB_Catalog :: getTableID (tableName);
 	fileType = "heap";
 	sortAtt = "none";
 }
@@ -17,6 +19,8 @@ MyDB_Table :: MyDB_Table (string name, string storageLocIn, MyDB_SchemaPtr mySch
 	storageLoc = storageLocIn;
 	mySchema = mySchemaIn;
 	last = -1;
+	pageFormat = 0;
+	id = MyDB_Catalog :: getTableID (tableName);
 	fileType = "heap";
 	sortAtt = "none";
 }
@@ -26,6 +30,8 @@ MyDB_Table :: MyDB_Table (string name, string storageLocIn, MyDB_SchemaPtr mySch
 	storageLoc = storageLocIn;
 	mySchema = mySchemaIn;
 	last = -1;
+	pageFormat = 0;
+	id = MyDB_Catalog :: getTableID (tableName);
 	fileType = fileTypeIn;
 	sortAtt = sortAttIn;
 }
@@ -44,6 +50,29 @@ string &MyDB_Table :: getSortAtt () {
 	return sortAtt;
 }
 
+MyDB_ZoneMapPtr MyDB_Table :: getZoneMap () {
+	if (zoneMap == nullptr) {
+		zoneMap = make_shared <MyDB_ZoneMap> (mySchema);
+		if (zoneFile != "")
+			zoneMap->load (zoneFile);
+	}
+	return zoneMap;
+}
+
+int MyDB_Table :: getPageFormat () {
+	return pageFormat;
+}
+
+void MyDB_Table :: setPageFormat (int toMe) {
+	pageFormat = toMe;
+}
+
+size_t MyDB_Table :: getID () {
+	if (id == -1)
+		id = MyDB_Catalog :: getTableID (tableName);
+	return id;
+}
+
 string &MyDB_Table :: getStorageLoc () {
 	return storageLoc;
 }
@@ -67,7 +96,10 @@ map <string, MyDB_TablePtr> MyDB_Table :: getAllTables (MyDB_CatalogPtr fromMe)
 	return returnVal;
 }
 
-MyDB_Table :: MyDB_Table () {}
+MyDB_Table :: MyDB_Table () {
+	id = -1;
+	pageFormat = 0;
+}
 
 int MyDB_Table :: lastPage () {
 	return last;
@@ -81,6 +113,7 @@ bool MyDB_Table :: fromCatalog (string tableNameIn, MyDB_CatalogPtr catalog) {
 	
 	// get the storage location
 	tableName = tableNameIn;
+	id = MyDB_Catalog :: getTableID (tableName);
         if (!catalog->getString (tableName + ".fileName", storageLoc)) {
 		return false;
 	}
@@ -98,6 +131,16 @@ bool MyDB_Table :: fromCatalog (string tableNameIn, MyDB_CatalogPtr catalog) {
 	// get the sort att
 	catalog->getString (tableName + ".sortAtt", sortAtt);
 
+	// and the page format; tables put in the catalog before it was kept there
+	// may have pages without a header
+	pageFormat = 0;
+	catalog->getInt (tableName + ".pageFormat", pageFormat);
+
+	// and where the zone map is
+	zoneFile = "";
+	zoneMap = nullptr;
+	catalog->getString (tableName + ".zoneFile", zoneFile);
+
 	return true;
 }
 
@@ -131,6 +174,16 @@ void MyDB_Table :: putInCatalog (MyDB_CatalogPtr catalog) {
 	// remember the last page in the file
         catalog->putInt (tableName + ".lastPage", last);
 
+	// and the page format
+	catalog->putInt (tableName + ".pageFormat", pageFormat);
+
+	// and the zone map, if it was ever used
+	if (zoneMap != nullptr) {
+		zoneFile = storageLoc + ".zones";
+		zoneMap->save (zoneFile);
+		catalog->putString (tableName + ".zoneFile", zoneFile);
+	}
+
 	// and add the schema in 
 	mySchema->putInCatalog (tableName, catalog);	
 }
@@ -0,0 +1,224 @@
+
+#ifndef ZONE_MAP_C
+#define ZONE_MAP_C
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include "MyDB_ZoneMap.h"
+
+// marks a file as a zone map
+#define ZONE_MAP_MAGIC 0x504d5a4d
+
+// compares a string value to s, without copying it out of the value if it is a
+// string; returns < 0, 0, or > 0, like memcmp
+static int compareString (MyDB_AttValPtr val, const string &s) {
+
+	MyDB_StringAttVal *str = dynamic_cast <MyDB_StringAttVal *> (val.get ());
+	if (str == nullptr)
+		return val->toString ().compare (s);
+
+	size_t len = str->getLength ();
+	int res = memcmp (str->getChars (), s.data (), min (len, s.size ()));
+	if (res != 0)
+		return res;
+	return (len > s.size ()) - (len < s.size ());
+}
+
+MyDB_ZoneMap :: MyDB_ZoneMap (MyDB_SchemaPtr forMe) {
+	if (forMe == nullptr)
+		return;
+	for (auto &att : forMe->getAtts ()) {
+		isBool.push_back (att.second->isBool ());
+		isString.push_back (!isBool.back () && !att.second->promotableToDouble ());
+	}
+}
+
+MyDB_ZoneMap :: Zone &MyDB_ZoneMap :: getZone (size_t whichPage) {
+	if (whichPage >= zones.size ()) {
+		Zone unknown;
+		unknown.known = false;
+		unknown.numRecords = 0;
+		zones.resize (whichPage + 1, unknown);
+	}
+	return zones[whichPage];
+}
+
+void MyDB_ZoneMap :: clearPage (size_t whichPage) {
+	changing ();
+	Zone &zone = getZone (whichPage);
+	size_t numAtts = isString.size ();
+	zone.known = true;
+	zone.numRecords = 0;
+	zone.lowNum.assign (numAtts, 0);
+	zone.highNum.assign (numAtts, 0);
+	zone.lowStr.assign (numAtts, "");
+	zone.highStr.assign (numAtts, "");
+}
+
+void MyDB_ZoneMap :: addValue (size_t whichPage, size_t whichAtt, MyDB_AttValPtr val) {
+
+	Zone &zone = getZone (whichPage);
+	if (!zone.known || whichAtt >= isString.size ())
+		return;
+	changing ();
+
+	// the first record on the page sets the zone...
+	bool first = zone.numRecords == 0;
+	if (isString[whichAtt]) {
+		if (first || compareString (val, zone.lowStr[whichAtt]) < 0)
+			zone.lowStr[whichAtt] = val->toString ();
+		if (first || compareString (val, zone.highStr[whichAtt]) > 0)
+			zone.highStr[whichAtt] = val->toString ();
+
+	// ...and the others widen it
+	} else {
+		double num = isBool[whichAtt] ? val->toBool () : val->toDouble ();
+		if (first || num < zone.lowNum[whichAtt])
+			zone.lowNum[whichAtt] = num;
+		if (first || num > zone.highNum[whichAtt])
+			zone.highNum[whichAtt] = num;
+	}
+}
+
+void MyDB_ZoneMap :: addRecord (size_t whichPage) {
+	Zone &zone = getZone (whichPage);
+	if (zone.known) {
+		changing ();
+		zone.numRecords++;
+	}
+}
+
+bool MyDB_ZoneMap :: mightMatch (size_t whichPage, vector <MyDB_AttRange> &filter) {
+
+	if (whichPage >= zones.size () || !zones[whichPage].known)
+		return true;
+
+	Zone &zone = zones[whichPage];
+	if (zone.numRecords == 0)
+		return false;
+
+	for (MyDB_AttRange &range : filter) {
+		size_t i = range.whichAtt;
+		if (i >= isString.size ())
+			continue;
+
+		// the page is out if all of its values are below the range, or all above it
+		if (isString[i]) {
+			if (range.low != nullptr && compareString (range.low, zone.highStr[i]) > 0)
+				return false;
+			if (range.high != nullptr && compareString (range.high, zone.lowStr[i]) < 0)
+				return false;
+		} else {
+			if (range.low != nullptr && (isBool[i] ? range.low->toBool () : range.low->toDouble ()) > zone.highNum[i])
+				return false;
+			if (range.high != nullptr && (isBool[i] ? range.high->toBool () : range.high->toDouble ()) < zone.lowNum[i])
+				return false;
+		}
+	}
+	return true;
+}
+
+long MyDB_ZoneMap :: getNumRecords (size_t whichPage) {
+	if (whichPage >= zones.size () || !zones[whichPage].known)
+		return -1;
+	return zones[whichPage].numRecords;
+}
+
+void MyDB_ZoneMap :: invalidate () {
+	changing ();
+	zones.clear ();
+}
+
+void MyDB_ZoneMap :: changing () {
+	if (onDisk.empty ())
+		return;
+	remove (onDisk.c_str ());
+	onDisk = "";
+}
+
+// the zone map file is the magic number, the number of attributes, and the
+// number of pages, followed by the zones of the pages in order.  Each zone is
+// a flag saying if it is known, and if it is, the number of records and then
+// the low and high value of each attribute; strings are written as their
+// length and then their characters
+void MyDB_ZoneMap :: save (string toMe) {
+
+	ofstream out (toMe, ios :: binary | ios :: trunc);
+	auto putInt = [&] (uint64_t val) {out.write ((char *) &val, sizeof (val));};
+	auto putString = [&] (string &val) {putInt (val.size ()); out.write (val.data (), val.size ());};
+
+	putInt (ZONE_MAP_MAGIC);
+	putInt (isString.size ());
+	putInt (zones.size ());
+	for (Zone &zone : zones) {
+		putInt (zone.known);
+		if (!zone.known)
+			continue;
+		putInt (zone.numRecords);
+		for (size_t i = 0; i < isString.size (); i++) {
+			if (isString[i]) {
+				putString (zone.lowStr[i]);
+				putString (zone.highStr[i]);
+			} else {
+				out.write ((char *) &zone.lowNum[i], sizeof (double));
+				out.write ((char *) &zone.highNum[i], sizeof (double));
+			}
+		}
+	}
+	out.close ();
+	onDisk = toMe;
+}
+
+bool MyDB_ZoneMap :: load (string fromMe) {
+
+	zones.clear ();
+	onDisk = "";
+	ifstream in (fromMe, ios :: binary);
+	auto getInt = [&] () {uint64_t val = 0; in.read ((char *) &val, sizeof (val)); return val;};
+	auto getString = [&] (string &val) {
+		uint64_t len = getInt ();
+		if (len > (1 << 30))
+			in.setstate (ios :: failbit);
+		if (!in)
+			return false;
+		val.resize (len);
+		in.read (&val[0], len);
+		return (bool) in;
+	};
+
+	if (!in || getInt () != ZONE_MAP_MAGIC || getInt () != isString.size ())
+		return false;
+
+	size_t numPages = getInt ();
+	for (size_t page = 0; page < numPages && in; page++) {
+		if (!getInt ()) {
+			getZone (page);
+			continue;
+		}
+		clearPage (page);
+		Zone &zone = zones[page];
+		zone.numRecords = getInt ();
+		for (size_t i = 0; i < isString.size (); i++) {
+			if (isString[i]) {
+				if (!getString (zone.lowStr[i]) || !getString (zone.highStr[i]))
+					break;
+			} else {
+				in.read ((char *) &zone.lowNum[i], sizeof (double));
+				in.read ((char *) &zone.highNum[i], sizeof (double));
+			}
+		}
+	}
+
+	// a file that was cut short says nothing
+	if (!in) {
+		zones.clear ();
+		return false;
+	}
+	onDisk = fromMe;
+	return true;
+}
+
+#endif
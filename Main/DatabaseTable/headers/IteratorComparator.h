@@ -2,6 +2,7 @@
 #ifndef ITERATOR_COMP_H
 #define ITERATOR_COMP_H
 
+#include <cstdint>
 #include <fstream>
 #include <queue>
 #include "MyDB_PageReaderWriter.h"
@@ -29,6 +30,15 @@ public:
 		return !comparator ();
 	}
 
+	// the same, for iterators that are paired with the keys (see MyDB_SortKey.h) of
+	// their current records; the records are only compared if the keys are the same
+	bool operator() (const pair <uint64_t, MyDB_RecordIteratorAltPtr> &leftPair, 
+		const pair <uint64_t, MyDB_RecordIteratorAltPtr> &rightPair) const {
+		if (leftPair.first != rightPair.first)
+			return leftPair.first > rightPair.first;
+		return (*this) (leftPair.second, rightPair.second);
+	}
+
 private:
 	function <bool ()> comparator;
 	MyDB_RecordPtr lhs;
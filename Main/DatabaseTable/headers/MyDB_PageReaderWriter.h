@@ -17,24 +17,75 @@
 #include "MyDB_PageType.h"
 #include "MyDB_RecordIterator.h"
 #include "MyDB_RecordIteratorAlt.h"
+#include "MyDB_SortKey.h"
 #include "MyDB_TableReaderWriter.h"
 
+// pages written before this version of the page format (see MyDB_PageHeader)
+// hold their records in the legacy binary format, with null-terminated strings
+// rather than length-prefixed ones.  They are still read and written in that
+// format, so that the records on them are sure to fit; those from before the
+// slot directory are only read (see MyDB_PageFormatError)
+#define LENGTH_PREFIX_VERSION 3
+
 using namespace std;
 class MyDB_PageReaderWriter;
 typedef shared_ptr <MyDB_PageReaderWriter> MyDB_PageReaderWriterPtr;
 
+// thrown when the records on a page written before the slot directory (see
+// MyDB_PageHeader) are asked for by number, or the page is sorted or changed.
+// Those pages can still be scanned; the table reader/writer rewrites the pages of
+// a table that it can change when it opens it
+class MyDB_PageFormatError : public runtime_error {
+
+public:
+
+	MyDB_PageFormatError (string what) : runtime_error (what) {}
+};
+
+// thrown by sort () and sortInPlace () when the records of a compressed PAX page
+// do not fit on one page once they are sorted (they can compress a lot worse in
+// another order); the page is left as it was, and sortIntoList () can be used
+class MyDB_PageOverflowError : public runtime_error {
+
+public:
+
+	MyDB_PageOverflowError () : runtime_error ("The sorted records do not fit on one page!!") {}
+};
+
 class MyDB_PageReaderWriter {
 
 public:
 
-	// constructor for a page in the same file as the parent
+	// constructor for a page in the same file as the parent; if the parent was
+	// opened read-only, the page can only be read, and everything that would
+	// change it (clear, append, setType, deleteRecord, updateRecord, and
+	// sortInPlace) throws a MyDB_ReadOnlyError instead
 	MyDB_PageReaderWriter (MyDB_TableReaderWriter &parent, int whichPage);
 
+	// like the above, except that if pinned is true, the page is pinned in RAM for
+	// as long as this (or a copy of it) is around; throws a MyDB_BufferFullError
+	// if the buffer is so full of pinned pages that it cannot be
+	MyDB_PageReaderWriter (MyDB_TableReaderWriter &parent, int whichPage, bool pinned);
+
 	// constructor for an anonymous page
 	MyDB_PageReaderWriter (MyDB_BufferManager &parent);
 
+	// constructor for an anonymous page that is put into the given region of the
+	// temp space, right after the region's last page
+	MyDB_PageReaderWriter (MyDB_BufferManager &parent, MyDB_TempRegionPtr inMe);
+
+	// like the above, except that if pinned is true, the page is pinned in RAM
+	// until unpin () is called (or this and every copy of it are gone); throws a
+	// MyDB_BufferFullError if the buffer is so full of pinned pages that it cannot be
+	MyDB_PageReaderWriter (MyDB_BufferManager &parent, MyDB_TempRegionPtr inMe, bool pinned);
+
+	// lets the page be kicked out of RAM again, if it was pinned
+	void unpin ();
+
 	// empties out the contents of this page, so that it has no records in it
-	// the type of the page is set to MyDB_PageType :: RegularPage
+	// the type of the page is set to MyDB_PageType :: RegularPage, except for
+	// the pages of a table whose file type is "pax" or "compressed", which
+	// become empty MyDB_PageType :: PaxPage pages
 	void clear ();	
 
 	// return an itrator over this page... each time returnVal->next () is
@@ -42,6 +93,10 @@ public:
 	// by iterateIntoMe
 	MyDB_RecordIteratorPtr getIterator (MyDB_RecordPtr iterateIntoMe);
 
+	// like the above, except that on a PAX page, only the attributes in
+	// whichAtts are loaded (and looked at); on other pages, all of them are
+	MyDB_RecordIteratorPtr getIterator (MyDB_RecordPtr iterateIntoMe, vector <int> whichAtts);
+
 	// gets an instance of an alternate iterator over the page... this is an
 	// iterator that has the alternate getCurrent ()/advance () interface
 	MyDB_RecordIteratorAltPtr getIteratorAlt ();
@@ -50,9 +105,28 @@ public:
 	friend MyDB_RecordIteratorAltPtr getIteratorAlt (vector <MyDB_PageReaderWriter> &forUs);
 
 	// appends a record to this page... return false is the append fails because
-	// there is not enough space on the page; otherwise, return true
+	// there is not enough space on the page; otherwise, return true.  The space
+	// of deleted records is taken back if that is what it takes to fit the record
 	bool append (MyDB_RecordPtr appendMe);
 
+	// the records on the page are numbered in the order they were appended (or
+	// sorted into); this returns the number of them, counting deleted ones.  On
+	// a PAX page, getRecord has to skip over the records before the one asked
+	// for, and records cannot be deleted or updated
+	int getNumSlots ();
+
+	// puts the record with the given number into intoMe... returns false if
+	// there is no such record, or if it has been deleted
+	bool getRecord (int whichSlot, MyDB_RecordPtr intoMe);
+
+	// deletes the record with the given number; the other records keep their
+	// numbers.  Returns false if there is no such record
+	bool deleteRecord (int whichSlot);
+
+	// replaces the record with the given number, keeping its number... returns
+	// false if there is no such record, or if the new one does not fit
+	bool updateRecord (int whichSlot, MyDB_RecordPtr newRec);
+
 	// gets the type of this page... this is just a value from an ennumeration
 	// that is stored within the page
 	MyDB_PageType getType ();
@@ -63,11 +137,43 @@ public:
 	// sorts the contents of the page... the boolean lambda that is sent into
 	// this function must check to see if the contents of the record pointed to
 	// by lhs are less than the contens of the record pointed to by rhs... typically,
-	// this lambda would have been created via a call to buildRecordComparator
-	MyDB_PageReaderWriterPtr sort (function <bool ()> comparator, MyDB_RecordPtr lhs,  MyDB_RecordPtr rhs);
-
-	// like the above, except that the sorting is done in place, on the page
-	void sortInPlace (function <bool ()> comparator, MyDB_RecordPtr lhs,  MyDB_RecordPtr rhs);
+	// this lambda would have been created via a call to buildRecordComparator.
+	// If key is given, it must be a MyDB_SortKey over lhs for the same computation;
+	// the records are then sorted on their keys, with a radix sort if the key is
+	// exact (an int or a double), and with the comparator breaking ties if not
+	MyDB_PageReaderWriterPtr sort (function <bool ()> comparator, MyDB_RecordPtr lhs,  MyDB_RecordPtr rhs,
+		MyDB_SortKeyPtr key = nullptr);
+
+	// like the above, except that the sorting is done in place, on the page; only
+	// the slots are moved, not the records.  Deleted records are dropped, so the
+	// records are numbered in sorted order afterward
+	void sortInPlace (function <bool ()> comparator, MyDB_RecordPtr lhs,  MyDB_RecordPtr rhs,
+		MyDB_SortKeyPtr key = nullptr);
+
+	// like sort (), except that the sorted records are put on as many new pages
+	// as they take, in order, rather than on just one; only the records of a
+	// compressed PAX page can take more than one
+	vector <MyDB_PageReaderWriter> sortIntoList (function <bool ()> comparator, MyDB_RecordPtr lhs,
+		MyDB_RecordPtr rhs, MyDB_SortKeyPtr key = nullptr);
+
+	// sorts the records at the given positions, in the way that sort () does; if
+	// legacy is true, they are in the legacy binary format
+	static void sortPositions (vector <void *> &positions, bool legacy, function <bool ()> comparator,
+		MyDB_RecordPtr lhs, MyDB_RecordPtr rhs, MyDB_SortKeyPtr key);
+
+	// puts where each record on the page is, in the binary format, into positions
+	// (deleted records are left out); the records on a PAX page or a legacy page
+	// are copied into rows first, and the others are left where they are, so the
+	// page has to be pinned for as long as the positions are used
+	void getPositions (MyDB_RecordPtr likeMe, vector <char> &rows, vector <void *> &positions);
+
+	// true if the given page holds its records in the legacy binary format; so
+	// do pages without a header
+	static bool isLegacy (void *page);
+
+	// loads the record at pos, on the given page, into intoMe, using the format
+	// of the page; returns the end of the record
+	static void *loadRecord (void *page, void *pos, MyDB_RecordPtr intoMe);
 
 	// returns the page size
 	size_t getPageSize ();
@@ -77,11 +183,71 @@ public:
 
 private:
 
+	// throws a MyDB_PageFormatError if the page has no slot directory
+	void checkSlotted ();
+
+	// throws a MyDB_ReadOnlyError if the page is in a table opened read-only
+	void checkWritable ();
+
+	// the number of bytes used by the header and by records that are not deleted
+	size_t getNumBytesLive ();
+
+	// moves the records that are not deleted together, right after the header,
+	// so that the space of the deleted ones can be used again
+	void compact ();
+
+	// makes this an empty PAX page, which is compressed when it fills up if
+	// compress is true
+	void formatPax (bool compress);
+
+	// append for PAX pages
+	bool appendPax (MyDB_RecordPtr appendMe);
+
+	// widens the zone of the page in the table's zone map to take in the record;
+	// isNew is true if it was appended, rather than put in place of another
+	void addToZone (MyDB_RecordPtr addMe, bool isNew);
+
+	// encodes the minipages of a full PAX page (see MyDB_PaxCodec.h), and then
+	// splits the page up again so that a record with values of the given sizes
+	// fits; returns false, and changes nothing, if that does not free up enough
+	// of the page to be worth it (or, if force is true, if the record still
+	// does not fit)
+	bool compressPax (MyDB_RecordPtr likeMe, vector <size_t> &sizes, bool force);
+
+	// makes this an empty PAX page, and appends the records at positions (in the
+	// binary format) to it, starting at positions[from], until one does not fit;
+	// returns the number that did
+	size_t fillPax (bool compress, MyDB_RecordPtr likeMe, vector <void *> &positions, size_t from);
+
+	// splits a PAX page up into minipages again, giving the i^th one at least
+	// needed[i] bytes (see MyDB_PaxPage.h); returns false, and changes nothing,
+	// if they do not all fit
+	bool partitionPax (vector <size_t> &needed);
+
+	// copies the records on a PAX page, in the row format, into rows, and puts
+	// where each one is into positions
+	void getRows (MyDB_RecordPtr likeMe, vector <char> &rows, vector <void *> &positions);
+
 	// this is the page that we are messing with
 	MyDB_PageHandle myPage;	
 	
 	// this is our buffer manager
 	size_t pageSize;
+
+	// true if the page belongs to a PAX table, so clear () makes it a PAX page,
+	// and true if the table is compressed as well
+	bool columnar;
+	bool compressing;
+
+	// true if the page belongs to a table that was opened read-only; its bytes
+	// may then be a read-only mapping of the file
+	bool readOnly;
+
+	// the zone map of the table that the page is in, and where the page is in
+	// the table; null for pages that are not in a table, or whose table does
+	// not keep a zone map
+	MyDB_ZoneMapPtr zones;
+	size_t whichPage;
 };
 
 #endif
@@ -29,12 +29,19 @@ public:
 	bool hasNext () override;
 
 	// destructor and contructor
-	MyDB_PageRecIterator (MyDB_PageHandle myPageIn, MyDB_RecordPtr myRecIn); 
+	MyDB_PageRecIterator (MyDB_PageHandle myPageIn, MyDB_RecordPtr myRecIn, size_t pageSizeIn); 
 	~MyDB_PageRecIterator ();
 
 private:
 
-	int bytesConsumed;
+	// the first slot after the current one that has a record in it
+	int nextSlot ();
+
+	// the slot of the record that was returned last; -1 before the first one.  On
+	// a page without slots, the records up to bytesConsumed have been returned
+	int curSlot;
+	size_t bytesConsumed;
+	size_t pageSize;
 	MyDB_PageHandle myPage;
 	MyDB_RecordPtr myRec;
 	
@@ -30,13 +30,19 @@ public:
         bool advance () override;
 
 	// destructor and contructor
-	MyDB_PageRecIteratorAlt (MyDB_PageHandle myPageIn); 
+	MyDB_PageRecIteratorAlt (MyDB_PageHandle myPageIn, size_t pageSizeIn); 
 	~MyDB_PageRecIteratorAlt ();
 
 private:
 
-	int bytesConsumed;
-	int nextRecSize;
+	// the slot of the current record, and whether getCurrent () has been called on it.
+	// On a page without slots, curPos is where the current record is (zero before
+	// the first one), and nextPosition is where the one after it is
+	int curSlot;
+	size_t curPos;
+	size_t nextPosition;
+	bool gotCurrent;
+	size_t pageSize;
 	MyDB_PageHandle myPage;
 };
 
@@ -0,0 +1,38 @@
+
+#ifndef PAX_CODEC_H
+#define PAX_CODEC_H
+
+#include "MyDB_AttType.h"
+#include "MyDB_AttVal.h"
+#include "MyDB_PaxPage.h"
+#include <vector>
+
+using namespace std;
+
+// Encodes and decodes the minipages of a PAX page (see MyDB_PaxPage.h).  The
+// values of an attribute are always decoded a whole minipage at a time, in a
+// tight loop per encoding, into a list that says where the binary form (as it
+// is in a record) of each value is.  For a dictionary or a run of the same
+// value, that is the one copy of the value on the page; bit-packed ints are
+// unpacked into a buffer first.  The encoded bytes do not depend on where the
+// minipage is, so they can be moved around as the page is split up again
+class MyDB_PaxCodec {
+
+public:
+
+	// finds the values of the given attribute for all of the records on the
+	// page, and puts where they are into positions.  scratch is a value of the
+	// attribute's type, used to find the sizes of values (it is changed), and
+	// unpacked is where bit-packed ints are put; it must not be changed while
+	// positions is being used
+	static void decode (void *page, size_t whichAtt, MyDB_AttValPtr scratch,
+		vector <void *> &positions, vector <int> &unpacked);
+
+	// encodes the given values (which are in the binary form) in whichever
+	// encoding takes the fewest bytes, and puts them into encoded; returns the
+	// MyDB_PaxEncoding used.  Bit packing is only tried if isInt is true
+	static MyDB_PaxEncoding encode (vector <void *> &values, MyDB_AttValPtr scratch, bool isInt,
+		vector <char> &encoded);
+};
+
+#endif
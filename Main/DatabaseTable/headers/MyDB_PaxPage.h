@@ -0,0 +1,78 @@
+
+#ifndef PAX_PAGE_H
+#define PAX_PAGE_H
+
+#include <cstdint>
+#include "MyDB_PageHeader.h"
+
+// A PAX page holds the same records as a regular page, but column by column:
+// the space after the page header is split into one minipage per attribute,
+// and the value of the attribute for each record goes at the end of its
+// minipage, in the record binary format.  So a scan that only needs some of
+// the attributes only looks at their minipages.
+//
+// The page header is followed by the directory, and then by the entries for
+// the minipages, in attribute order.  Minipages are sized in proportion to the
+// space that their attribute needs; when one fills up, the page is split up
+// again using the sizes of the records on it so far.  The page is full when
+// the records take up all of the space.
+//
+// The pages of a "compressed" table are PAX pages that are compressed when they
+// fill up: each minipage is encoded in whichever of the encodings below takes
+// the fewest bytes for the values on it, and the records appended after that
+// go after the encoded ones, as they are, until the page fills up again (see
+// MyDB_PaxCodec.h).  A page is only compressed if that frees up a good part of
+// it; otherwise it is full.
+
+// the directory at the start of a PAX page, right after the page header
+struct MyDB_PaxDirectory {
+
+	// the number of records on the page
+	uint32_t numRecords;
+
+	// the number of minipages; zero until the first record is appended, since
+	// that is when the page is split up
+	uint32_t numAtts;
+
+	// 1 if the page is compressed when it fills up
+	uint32_t compress;
+};
+
+// the ways that the values at the start of a minipage can be encoded
+enum MyDB_PaxEncoding {
+
+	// as they are, one after another
+	PaxPlain,
+
+	// the different values, and then one byte per record saying which it is
+	PaxDictionary,
+
+	// a count, and then the value, for each run of the same value
+	PaxRunLength,
+
+	// for ints, the smallest value, and then the difference from it for each
+	// record, using as few bits as it takes
+	PaxBitPacked
+};
+
+// where a minipage is on the page, how many bytes it has room for, and how
+// many of those are used; the values of the first numEncoded records take up
+// the first encodedBytes bytes, in the given MyDB_PaxEncoding, and the rest
+// follow them as they are
+struct MyDB_MiniPage {
+	uint32_t start;
+	uint32_t capacity;
+	uint32_t used;
+	uint32_t encoding;
+	uint32_t numEncoded;
+	uint32_t encodedBytes;
+};
+
+#define PAX_DIRECTORY(page) ((MyDB_PaxDirectory *) (((char *) (page)) + sizeof (MyDB_PageHeader)))
+#define MINI_PAGE(page, i) (((MyDB_MiniPage *) (PAX_DIRECTORY (page) + 1)) + (i))
+
+// the offset on the page of the first byte after the directory and the
+// minipage entries, which is where the minipages start
+#define PAX_DATA_START(numAtts) (sizeof (MyDB_PageHeader) + sizeof (MyDB_PaxDirectory) + (numAtts) * sizeof (MyDB_MiniPage))
+
+#endif
@@ -0,0 +1,50 @@
+
+#ifndef PAX_PAGE_REC_ITER_H
+#define PAX_PAGE_REC_ITER_H
+
+#include "MyDB_PageHandle.h"
+#include "MyDB_Record.h"
+#include "MyDB_RecordIterator.h"
+#include <vector>
+
+// iterates through the records on a PAX page (see MyDB_PaxPage.h)
+class MyDB_PaxPageRecIterator : public MyDB_RecordIterator {
+
+public:
+
+	// put the contents of the next record in the file/page into the iterator record
+	// this should be called BEFORE the iterator record is first examined
+	void getNext () override;
+
+	// return true iff there is another record in the file/page
+	bool hasNext () override;
+
+	// only the attributes in whichAtts (all of them, if it is empty) are loaded
+	// into myRec; the others are not even looked at
+	MyDB_PaxPageRecIterator (MyDB_PageHandle myPageIn, MyDB_RecordPtr myRecIn, vector <int> whichAttsIn); 
+	~MyDB_PaxPageRecIterator ();
+
+private:
+
+	// the attributes to load, the values that they are loaded into, and where
+	// the value of each record is, for each of them (see MyDB_PaxCodec.h)
+	vector <int> whichAtts;
+	vector <MyDB_AttValPtr> atts;
+	vector <vector <void *>> positions;
+	vector <vector <int>> unpacked;
+
+	// the bytes of the page when positions was found; the page is not pinned,
+	// so if it is kicked out, it may be read back in somewhere else
+	void *decodedFrom;
+
+	// true if the record is a view, so the values point into the page
+	bool viewing;
+
+	// the number of records returned so far
+	size_t numDone;
+
+	MyDB_PageHandle myPage;
+	MyDB_RecordPtr myRec;
+};
+
+#endif
@@ -0,0 +1,43 @@
+
+#ifndef PAX_PAGE_REC_ITER_ALT_H
+#define PAX_PAGE_REC_ITER_ALT_H
+
+#include "MyDB_PageHandle.h"
+#include "MyDB_Record.h"
+#include "MyDB_RecordIteratorAlt.h"
+#include <vector>
+
+// the alternate iterator through the records on a PAX page (see MyDB_PaxPage.h)
+class MyDB_PaxPageRecIteratorAlt : public MyDB_RecordIteratorAlt {
+
+public:
+
+	// load the current record into the parameter
+	void getCurrent (MyDB_RecordPtr intoMe) override;
+
+	// advance to the next record... returns true if there is a next record, and 
+	// false if there are no more records to iterate over.  Not that this cannot
+	// be called until after getCurrent () has been called
+	bool advance () override;
+
+	// destructor and contructor
+	MyDB_PaxPageRecIteratorAlt (MyDB_PageHandle myPageIn); 
+	~MyDB_PaxPageRecIteratorAlt ();
+
+private:
+
+	// where the value of each record is, for each attribute (see MyDB_PaxCodec.h);
+	// found the first time that getCurrent is called, and again if the page has
+	// been kicked out and read back in somewhere else since then
+	vector <vector <void *>> positions;
+	vector <vector <int>> unpacked;
+	void *decodedFrom;
+
+	// the current record; -1 before the first one
+	long curRec;
+	bool gotCurrent;
+
+	MyDB_PageHandle myPage;
+};
+
+#endif
@@ -16,6 +16,7 @@
 #include <memory>
 #include "MyDB_BufferManager.h"
 #include "MyDB_Record.h"
+#include "MyDB_RecordView.h"
 #include "MyDB_RecordIterator.h"
 #include "MyDB_RecordIteratorAlt.h"
 #include "MyDB_Table.h"
@@ -26,6 +27,15 @@ class MyDB_PageReaderWriter;
 class MyDB_TableReaderWriter;
 typedef shared_ptr <MyDB_TableReaderWriter> MyDB_TableReaderWriterPtr;
 
+// thrown when something tries to change a table that was opened read-only;
+// the table is left as it was
+class MyDB_ReadOnlyError : public runtime_error {
+
+public:
+
+	MyDB_ReadOnlyError () : runtime_error ("Can't change a table that was opened read-only!!") {}
+};
+
 class MyDB_TableReaderWriter {
 
 public:
@@ -33,9 +43,20 @@ public:
 	// create a table reader/writer
 	MyDB_TableReaderWriter (MyDB_TablePtr forMe, MyDB_BufferManagerPtr myBuffer);
 
+	// create a table reader/writer; if readOnly is true, the table cannot be
+	// changed, and its pages are served straight out of a memory mapping of the
+	// table's file rather than being copied into the buffer.  Otherwise, a table
+	// written before the slot directory is rewritten in the current format first
+	MyDB_TableReaderWriter (MyDB_TablePtr forMe, MyDB_BufferManagerPtr myBuffer, bool readOnly);
+
 	// gets an empty record from this table
 	MyDB_RecordPtr getEmptyRecord ();
 
+	// gets an empty record view from this table; the records that an iterator
+	// loads into it are not copied out of the page, so a scan that only looks
+	// at some of the attributes of each record does not pay for the others
+	MyDB_RecordViewPtr getEmptyRecordView ();
+
 	// append a record to the table
 	virtual void append (MyDB_RecordPtr appendMe);
 
@@ -44,10 +65,22 @@ public:
 	// by iterateIntoMe
 	MyDB_RecordIteratorPtr getIterator (MyDB_RecordPtr iterateIntoMe);
 
+	// like the above, except that only the named attributes are loaded into
+	// iterateIntoMe (the others are left as they are).  On a "pax" table, this
+	// means that the pages of the other attributes are never looked at.  If one
+	// of the names is not an attribute of the table, null is returned
+	MyDB_RecordIteratorPtr getIterator (MyDB_RecordPtr iterateIntoMe, vector <string> attNames);
+
         // gets an instance of an alternate iterator over the table... this is an
         // iterator that has the alternate getCurrent ()/advance () interface
         MyDB_RecordIteratorAltPtr getIteratorAlt ();
 
+	// gets an instance of an alternate iterator over the table that skips the
+	// pages that the table's zone map says cannot have a record whose values
+	// are in all of the ranges in filter.  The records on the other pages are
+	// all returned, so the caller still has to check them
+	MyDB_RecordIteratorAltPtr getIteratorAlt (vector <MyDB_AttRange> filter);
+
 	// gets an instance of an alternate iterator over the page; this iterator
 	// works on a range of pages in the file, and iterates from lowPage through
 	// highPage inclusive
@@ -68,6 +101,10 @@ public:
 	// get the number of pages in the file
 	int getNumPages ();
 
+	// asks that pages lowPage through highPage be read into the buffer in the
+	// background, because someone is about to get to them
+	void readAhead (int lowPage, int highPage);
+
 	// get access to the buffer manager	
 	MyDB_BufferManagerPtr getBufferMgr ();
 	
@@ -75,9 +112,23 @@ private:
 
 	friend class MyDB_PageReaderWriter;
 	friend class MyDB_BPlusTreeReaderWriter;
+	friend class MyDB_TableRecIteratorAlt;
 	MyDB_TablePtr getTable ();
+
+	// throws a MyDB_ReadOnlyError if the table was opened read-only
+	void checkWritable ();
+
+	// rewrites a table whose pages were written before the slot directory (see
+	// MyDB_PageHeader) in the current format; throws a MyDB_PageFormatError, and
+	// changes nothing, if it has pages other than regular ones (a B+-tree does)
+	void migrate ();
+
+	bool readOnly;
 	MyDB_TablePtr forMe;
 	MyDB_BufferManagerPtr myBuffer;
+
+	// the zone map that the pages of the table keep up to date; null if they don't
+	MyDB_ZoneMapPtr zones;
 	shared_ptr <MyDB_PageReaderWriter> arrayAccessBuffer;
 	shared_ptr <MyDB_PageReaderWriter> lastPage;
 	
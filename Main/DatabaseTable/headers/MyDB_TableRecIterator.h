@@ -29,19 +29,25 @@ public:
 	// return true iff there is another record in the file/page
 	bool hasNext () override;
 
-	// destructor and contructor
+	// destructor and contructor; only the attributes in whichAtts are loaded
+	// from PAX pages (all of them, if it is empty)
 	MyDB_TableRecIterator (MyDB_TableReaderWriter &myParent, MyDB_TablePtr myTableIn,
-        	MyDB_RecordPtr myRecIn);
+        	MyDB_RecordPtr myRecIn, vector <int> whichAtts = vector <int> ());
 	~MyDB_TableRecIterator ();
 
 private:
 
+	// asks the buffer manager to start reading the pages that we will get to soon
+	void readAhead ();
+
 	MyDB_RecordIteratorPtr myIter;
 	int curPage;
+	int readAheadTo;
 	
 	MyDB_TableReaderWriter &myParent;
 	MyDB_TablePtr myTable;
         MyDB_RecordPtr myRec;
+	vector <int> whichAtts;
 
 };
 
@@ -35,13 +35,29 @@ public:
 	~MyDB_TableRecIteratorAlt ();
 	MyDB_TableRecIteratorAlt (MyDB_TableReaderWriter &myParent, MyDB_TablePtr myTableIn, int lowPage, int highPage);
 
+	// this one skips the pages that the zone map says have no records in all of
+	// the ranges in filter
+	MyDB_TableRecIteratorAlt (MyDB_TableReaderWriter &myParent, MyDB_TablePtr myTableIn, vector <MyDB_AttRange> filter);
+
 private:
 
+	// asks the buffer manager to start reading the pages that we will get to soon
+	void readAhead ();
+
+	// true if the page is skipped by the filter
+	bool skip (int whichPage);
+
 	MyDB_RecordIteratorAltPtr myIter;
 	int curPage;
 	int highPage;	
+	int readAheadTo;
 	MyDB_TableReaderWriter &myParent;
 	MyDB_TablePtr myTable;
+
+	// the filter, and the zone map that it is checked against (null if there
+	// is no filter, or the table does not have a zone map)
+	vector <MyDB_AttRange> filter;
+	MyDB_ZoneMapPtr zones;
 };
 
 #endif
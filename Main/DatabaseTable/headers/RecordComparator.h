@@ -4,6 +4,7 @@
 #define REC_COMPARATOR_H
 
 #include "MyDB_Record.h"
+#include <cstdint>
 #include <iostream>
 using namespace std;
 
@@ -11,23 +12,40 @@ class RecordComparator {
 
 public:
 
-	RecordComparator (function <bool ()> comparatorIn, MyDB_RecordPtr lhsIn,  MyDB_RecordPtr rhsIn) {
+	// if legacy is true, the records are in the legacy binary format (see
+	// MyDB_Record.fromLegacyBinary ())
+	RecordComparator (function <bool ()> comparatorIn, MyDB_RecordPtr lhsIn,  MyDB_RecordPtr rhsIn, bool legacyIn = false) {
 		comparator = comparatorIn;
 		lhs = lhsIn;
 		rhs = rhsIn;
+		legacy = legacyIn;
 	}
 
 	bool operator () (void *lhsPtr, void *rhsPtr) {
-		lhs->fromBinary (lhsPtr);
-		rhs->fromBinary (rhsPtr);
+		if (legacy) {
+			lhs->fromLegacyBinary (lhsPtr);
+			rhs->fromLegacyBinary (rhsPtr);
+		} else {
+			lhs->view (lhsPtr);
+			rhs->view (rhsPtr);
+		}
 		return comparator ();	
 	}
 
+	// compares two records that are paired with their keys (see MyDB_SortKey.h);
+	// the records themselves are only compared if the keys are the same
+	bool operator () (const pair <uint64_t, void *> &lhsPair, const pair <uint64_t, void *> &rhsPair) {
+		if (lhsPair.first != rhsPair.first)
+			return lhsPair.first < rhsPair.first;
+		return (*this) (lhsPair.second, rhsPair.second);
+	}
+
 private:
 
 	function <bool ()> comparator;
 	MyDB_RecordPtr lhs;
 	MyDB_RecordPtr rhs;
+	bool legacy;
 
 };
 
@@ -3,15 +3,27 @@
 #define SORTING_H
 
 #include "MyDB_PageReaderWriter.h"
+#include "MyDB_SortKey.h"
 #include "MyDB_TableRecIterator.h"
 #include "MyDB_TableRecIteratorAlt.h"
 #include "MyDB_TableReaderWriter.h"
 
 // performs a TPMMS of the table sortMe.  The results are written to sortIntoMe.  The run 
 // size for the first phase of the TPMMS is given by runSize.  Comarisons are performed 
-// using comparator, lhs, rhs
+// using comparator, lhs, rhs.  If key is given, it must be a MyDB_SortKey over lhs for the
+// same computation as the comparator; records are then compared on their keys, and the
+// comparator is only used to break ties
 void sort (int runSize, MyDB_TableReaderWriter &sortMe, MyDB_TableReaderWriter &sortIntoMe,
-        function <bool ()> comparator, MyDB_RecordPtr lhs, MyDB_RecordPtr rhs);
+        function <bool ()> comparator, MyDB_RecordPtr lhs, MyDB_RecordPtr rhs, MyDB_SortKeyPtr key = nullptr);
+
+// like the above, except that the runs are made by numThreads threads at once (the calling
+// thread is one of them).  A comparator cannot be shared by threads, so each one builds its
+// own comparator and key, out of the computation orderBy (encoded as for buildRecordComparator).
+// The runs that the threads are working on all have to fit in the unpinned part of the buffer
+// at once (along with a page per thread to write them out through), so runSize is cut down if
+// it has to be
+void sort (int runSize, int numThreads, MyDB_TableReaderWriter &sortMe, MyDB_TableReaderWriter &sortIntoMe,
+        string orderBy);
 
 // helper function.  Gets two iterators, leftIter and rightIter.  It is assumed that these are iterators over
 // sorted lists of records.  This function then merges all of those records into a list of anonymous pages,
@@ -23,8 +35,16 @@ vector <MyDB_PageReaderWriter> mergeIntoList (MyDB_BufferManagerPtr parent, MyDB
 // accepts a list of iterators called mergeUs.  It is assumed that these are all iterators over sorted lists
 // of records.  This function then merges all of those records and appends them to the file sortIntoMe.  If
 // all of the iterators are over sorted lists of records, then all of the recrods appended onto the end of
-// sortIntoMe will be sorted.  Comparisons are performed using comparator, lhs, rhs
+// sortIntoMe will be sorted.  Comparisons are performed using comparator, lhs, rhs, and key (if
+// it is given), as in sort ()
 void mergeIntoFile (MyDB_TableReaderWriter &sortIntoMe, vector <MyDB_RecordIteratorAltPtr> &mergeUs,
-        function <bool ()> comparator, MyDB_RecordPtr lhs, MyDB_RecordPtr rhs);
+        function <bool ()> comparator, MyDB_RecordPtr lhs, MyDB_RecordPtr rhs, MyDB_SortKeyPtr key = nullptr);
+
+// the same as the above, except that the merge is done with a priority queue of the iterators,
+// which takes about twice as many comparisons per record (each of which has to load both records
+// out of their runs again) as the loser tree that mergeIntoFile uses; this is kept so that the
+// two can be compared
+void mergeIntoFileWithHeap (MyDB_TableReaderWriter &sortIntoMe, vector <MyDB_RecordIteratorAltPtr> &mergeUs,
+        function <bool ()> comparator, MyDB_RecordPtr lhs, MyDB_RecordPtr rhs, MyDB_SortKeyPtr key = nullptr);
 
 #endif
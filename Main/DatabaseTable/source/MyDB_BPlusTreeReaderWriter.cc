@@ -2,8 +2,11 @@
 #ifndef BPLUS_C
 #define BPLUS_C
 
+#include <algorithm>
+#include <cstring>
 #include "MyDB_INRecord.h"
 #include "MyDB_BPlusTreeReaderWriter.h"
+#include "MyDB_PageHeader.h"
 #include "MyDB_PageReaderWriter.h"
 #include "MyDB_PageListIteratorSelfSortingAlt.h"
 #include "RecordComparator.h"
@@ -11,12 +14,45 @@
 MyDB_BPlusTreeReaderWriter :: MyDB_BPlusTreeReaderWriter (string orderOnAttName, MyDB_TablePtr forMe, 
 	MyDB_BufferManagerPtr myBuffer) : MyDB_TableReaderWriter (forMe, myBuffer) {
 
+	// the directory pages do not hold records of the table, and records move
+	// between pages when they split, so there is no zone map
+	zones = nullptr;
+	forMe->getZoneMap ()->invalidate ();
+
 	// find the ordering attribute
 	auto res = forMe->getSchema ()->getAttByName (orderOnAttName);
 
 	// remember information about the ordering attribute
 	orderingAttType = res.second;
 	whichAttIsOrdering = res.first;
+
+	// if the tree already has data in it (say, because it was just recovered
+	// from the log), the root is the one directory page that no other directory
+	// page points to
+	rootLocation = 0;
+	if (getNumPages () > 1) {
+		vector <bool> pointedTo (getNumPages (), false);
+		vector <int> directoryPages;
+		MyDB_INRecordPtr otherRec = getINRecord ();
+		for (int i = 0; i < getNumPages (); i++) {
+			MyDB_PageReaderWriter page = (*this)[i];
+			if (page.getType () != MyDB_PageType :: DirectoryPage)
+				continue;
+
+			directoryPages.push_back (i);
+			MyDB_RecordIteratorAltPtr temp = page.getIteratorAlt ();
+			while (temp->advance ()) {
+				temp->getCurrent (otherRec);
+				if (otherRec->getPtr () >= 0 && otherRec->getPtr () < getNumPages ())
+					pointedTo[otherRec->getPtr ()] = true;
+			}
+		}
+
+		for (int i : directoryPages) {
+			if (!pointedTo[i])
+				rootLocation = i;
+		}
+	}
 }
 
 MyDB_RecordIteratorAltPtr MyDB_BPlusTreeReaderWriter :: getSortedRangeIteratorAlt (MyDB_AttValPtr low, MyDB_AttValPtr high) {
@@ -131,6 +167,10 @@ bool MyDB_BPlusTreeReaderWriter :: discoverPages (int whichPage, vector <MyDB_Pa
 
 void MyDB_BPlusTreeReaderWriter :: append (MyDB_RecordPtr appendMe) {
 
+	// all of the pages changed by the insert (including any splits) are logged
+	// together, so that a crash never leaves a split half done
+	MyDB_ActionGuard action (*getBufferMgr ());
+
 	// this file has never had any data in it, because the smallest B+-Tree has two pages
 	if (getNumPages () <= 1) {
 		
@@ -182,7 +222,8 @@ void MyDB_BPlusTreeReaderWriter :: append (MyDB_RecordPtr appendMe) {
 	}
 }
 
-#define NUM_BYTES_USED *((size_t *) (((char *) temp) + sizeof (size_t)))
+#define NUM_SLOTS (((MyDB_PageHeader *) temp)->numSlots)
+#define SLOT(i) (MyDB_PageHeader :: getSlot (temp, splitMe.getPageSize (), i))
 
 MyDB_RecordPtr MyDB_BPlusTreeReaderWriter :: split (MyDB_PageReaderWriter splitMe, MyDB_RecordPtr andMe) {
 	
@@ -215,21 +256,22 @@ MyDB_RecordPtr MyDB_BPlusTreeReaderWriter :: split (MyDB_PageReaderWriter splitM
 	vector <void *> positions;
 
 	// compute where all of the records are located
-	int bytesConsumed = sizeof (size_t) * 2;
-	while (bytesConsumed != NUM_BYTES_USED) {
-		void *pos = bytesConsumed + (char *) temp;
-		positions.push_back (pos);
-		void *nextPos = lhs->fromBinary (pos);
-		bytesConsumed += ((char *) nextPos) - ((char *) pos);
+	for (int i = 0; i < NUM_SLOTS; i++) {
+		if (SLOT (i)->offset != 0)
+			positions.push_back (SLOT (i)->offset + (char *) temp);
 	}
 	
-	// and get a postition for the last guy
-	void *spaceForLastGuy = malloc (andMe->getBinarySize ());
-	andMe->toBinary (spaceForLastGuy);
+	// and get a postition for the last guy, written in the same format as the rest
+	bool legacy = MyDB_PageReaderWriter :: isLegacy (temp);
+	void *spaceForLastGuy = malloc (legacy ? andMe->getLegacyBinarySize () : andMe->getBinarySize ());
+	if (legacy)
+		andMe->toLegacyBinary (spaceForLastGuy);
+	else
+		andMe->toBinary (spaceForLastGuy);
 	positions.push_back (spaceForLastGuy);
 
 	// now sort
-	RecordComparator myComparator (comparator, lhs, rhs);
+	RecordComparator myComparator (comparator, lhs, rhs, legacy);
 	std::sort (positions.begin (), positions.end (), myComparator);
 
 	// get the record to return
@@ -247,7 +289,7 @@ MyDB_RecordPtr MyDB_BPlusTreeReaderWriter :: split (MyDB_PageReaderWriter splitM
 	for (void *pos : positions) {
 
 		// low data goes into the new page
-		lhs->fromBinary (pos);
+		MyDB_PageReaderWriter :: loadRecord (temp, pos, lhs);
 		if (counter < positions.size () / 2) 
 			newPage.append (lhs);
 
@@ -14,33 +14,111 @@
 #define PAGE_RW_C
 
 #include <algorithm>
+#include <cstring>
+#include "MyDB_PageHeader.h"
 #include "MyDB_PageReaderWriter.h"
 #include "MyDB_PageRecIterator.h"
 #include "MyDB_PageRecIteratorAlt.h"
 #include "MyDB_PageListIteratorAlt.h"
+#include "MyDB_PaxCodec.h"
+#include "MyDB_PaxPage.h"
+#include "MyDB_PaxPageRecIterator.h"
+#include "MyDB_PaxPageRecIteratorAlt.h"
 #include "RecordComparator.h"
 
 #define PAGE_TYPE *((MyDB_PageType *) ((char *) myPage->getBytes ()))
-#define NUM_BYTES_USED *((size_t *) (((char *) myPage->getBytes ()) + sizeof (size_t)))
-#define NUM_BYTES_LEFT (pageSize - NUM_BYTES_USED)
+#define NUM_BYTES_USED (((MyDB_PageHeader *) myPage->getBytes ())->numBytesUsed)
+#define NUM_SLOTS (((MyDB_PageHeader *) myPage->getBytes ())->numSlots)
+#define SLOT(i) (MyDB_PageHeader :: getSlot (myPage->getBytes (), pageSize, i))
+#define NUM_BYTES_LEFT (pageSize - NUM_BYTES_USED - NUM_SLOTS * sizeof (MyDB_PageSlot))
+#define LEGACY (isLegacy (myPage->getBytes ()))
+
+// a full page that is to be compressed is only compressed if that frees up at
+// least this fraction of it; otherwise, it is left full
+#define PAX_MIN_COMPRESSION_GAIN (1.0 / 16)
 
 MyDB_PageReaderWriter :: MyDB_PageReaderWriter (MyDB_TableReaderWriter &parent, int whichPage) {
 
 	// get the actual page
 	myPage = parent.getBufferMgr ()->getPage (parent.getTable (), whichPage);
 	pageSize = parent.getBufferMgr ()->getPageSize ();
+	compressing = parent.getTable ()->getFileType () == "compressed";
+	columnar = compressing || parent.getTable ()->getFileType () == "pax";
+	zones = parent.zones;
+	readOnly = parent.readOnly;
+	this->whichPage = whichPage;
+}
+
+MyDB_PageReaderWriter :: MyDB_PageReaderWriter (MyDB_TableReaderWriter &parent, int whichPage, bool pinned) :
+	MyDB_PageReaderWriter (parent, whichPage) {
+
+	if (pinned) {
+		myPage = parent.getBufferMgr ()->getPinnedPage (parent.getTable (), whichPage);
+		if (myPage == nullptr)
+			throw MyDB_BufferFullError ();
+	}
 }
 
 MyDB_PageReaderWriter :: MyDB_PageReaderWriter (MyDB_BufferManager &parent) {
 	myPage = parent.getPage ();	
 	pageSize = parent.getPageSize ();
+	columnar = compressing = readOnly = false;
+	whichPage = 0;
 	clear ();
 }
 
+MyDB_PageReaderWriter :: MyDB_PageReaderWriter (MyDB_BufferManager &parent, MyDB_TempRegionPtr inMe) {
+	myPage = parent.getPage (inMe);
+	pageSize = parent.getPageSize ();
+	columnar = compressing = readOnly = false;
+	whichPage = 0;
+	clear ();
+}
+
+MyDB_PageReaderWriter :: MyDB_PageReaderWriter (MyDB_BufferManager &parent, MyDB_TempRegionPtr inMe, bool pinned) {
+	myPage = pinned ? parent.getPinnedPage (inMe, nullptr) : parent.getPage (inMe);
+	if (myPage == nullptr)
+		throw MyDB_BufferFullError ();
+	pageSize = parent.getPageSize ();
+	columnar = compressing = readOnly = false;
+	whichPage = 0;
+	clear ();
+}
+
+void MyDB_PageReaderWriter :: unpin () {
+	myPage->getParent ().unpin (myPage);
+}
+
 void MyDB_PageReaderWriter :: clear () {
-	NUM_BYTES_USED = 2 * sizeof (size_t);
+	checkWritable ();
+	MyDB_PageHeader :: format (myPage->getBytes ());
 	PAGE_TYPE = MyDB_PageType :: RegularPage;
-	myPage->wroteBytes ();	
+	myPage->wroteBytes (0, sizeof (MyDB_PageHeader));
+	if (columnar)
+		formatPax (compressing);
+	if (zones != nullptr)
+		zones->clearPage (whichPage);
+}
+
+void MyDB_PageReaderWriter :: addToZone (MyDB_RecordPtr addMe, bool isNew) {
+	if (zones == nullptr)
+		return;
+	size_t numAtts = addMe->getSchema ()->getAtts ().size ();
+	for (size_t i = 0; i < numAtts; i++)
+		zones->addValue (whichPage, i, addMe->getAtt (i));
+	if (isNew)
+		zones->addRecord (whichPage);
+}
+
+void MyDB_PageReaderWriter :: formatPax (bool compress) {
+
+	// the minipages are all over the page, so all of it counts as used
+	PAGE_TYPE = MyDB_PageType :: PaxPage;
+	NUM_BYTES_USED = pageSize;
+	PAX_DIRECTORY (myPage->getBytes ())->numRecords = 0;
+	PAX_DIRECTORY (myPage->getBytes ())->numAtts = 0;
+	PAX_DIRECTORY (myPage->getBytes ())->compress = compress;
+	myPage->wroteBytes (0, sizeof (MyDB_PageHeader) + sizeof (MyDB_PaxDirectory));
 }
 
 MyDB_PageType MyDB_PageReaderWriter :: getType () {
@@ -52,97 +130,568 @@ MyDB_RecordIteratorAltPtr getIteratorAlt (vector <MyDB_PageReaderWriter> &forUs)
 }
 
 MyDB_RecordIteratorPtr MyDB_PageReaderWriter :: getIterator (MyDB_RecordPtr iterateIntoMe) {
-	return make_shared <MyDB_PageRecIterator> (myPage, iterateIntoMe);
+	return getIterator (iterateIntoMe, vector <int> ());
+}
+
+MyDB_RecordIteratorPtr MyDB_PageReaderWriter :: getIterator (MyDB_RecordPtr iterateIntoMe, vector <int> whichAtts) {
+	if (PAGE_TYPE == MyDB_PageType :: PaxPage)
+		return make_shared <MyDB_PaxPageRecIterator> (myPage, iterateIntoMe, whichAtts);
+	return make_shared <MyDB_PageRecIterator> (myPage, iterateIntoMe, pageSize);
 }
 
 MyDB_RecordIteratorAltPtr MyDB_PageReaderWriter :: getIteratorAlt () {
-	return make_shared <MyDB_PageRecIteratorAlt> (myPage);
+	if (PAGE_TYPE == MyDB_PageType :: PaxPage)
+		return make_shared <MyDB_PaxPageRecIteratorAlt> (myPage);
+	return make_shared <MyDB_PageRecIteratorAlt> (myPage, pageSize);
 }
 
 void MyDB_PageReaderWriter :: setType (MyDB_PageType toMe) {
+	checkWritable ();
 	PAGE_TYPE = toMe;
-	myPage->wroteBytes ();	
+	myPage->wroteBytes (0, sizeof (MyDB_PageHeader));
 }
 
 bool MyDB_PageReaderWriter :: append (MyDB_RecordPtr appendMe) {
 	
-	size_t recSize = appendMe->getBinarySize ();
-	if (recSize > NUM_BYTES_LEFT)
+	checkWritable ();
+	if (PAGE_TYPE == MyDB_PageType :: PaxPage)
+		return appendPax (appendMe);
+
+	checkSlotted ();
+	bool legacy = LEGACY;
+	size_t recSize = legacy ? appendMe->getLegacyBinarySize () : appendMe->getBinarySize ();
+	if (NUM_SLOTS == MAX_PAGE_SLOTS)
 		return false;
 
-	// write at the end
-	void *address = myPage->getBytes ();
-	appendMe->toBinary (NUM_BYTES_USED + (char *) address);
+	// if the record only fits once the space of deleted records is taken back,
+	// take it back first
+	if (recSize + sizeof (MyDB_PageSlot) > NUM_BYTES_LEFT) {
+		if (recSize + sizeof (MyDB_PageSlot) > NUM_BYTES_LEFT + NUM_BYTES_USED - getNumBytesLive ())
+			return false;
+		compact ();
+	}
+
+	// write at the end, and put a new slot before the last one; the record and
+	// the slot are logged before the header that makes them part of the page, so
+	// if only those make it into the log, the page is just as it was
+	size_t offset = NUM_BYTES_USED;
+	if (legacy)
+		appendMe->toLegacyBinary (offset + (char *) myPage->getBytes ());
+	else
+		appendMe->toBinary (offset + (char *) myPage->getBytes ());
+	myPage->wroteBytes (offset, recSize);
+
+	int whichSlot = NUM_SLOTS;
+	SLOT (whichSlot)->offset = offset;
+	SLOT (whichSlot)->length = recSize;
+	myPage->wroteBytes (pageSize - (whichSlot + 1) * sizeof (MyDB_PageSlot), sizeof (MyDB_PageSlot));
+
 	NUM_BYTES_USED += recSize;
-	myPage->wroteBytes ();
+	NUM_SLOTS++;
+	myPage->wroteBytes (0, sizeof (MyDB_PageHeader));
+	addToZone (appendMe, true);
 	return true;
 }
 
-void MyDB_PageReaderWriter :: 
-	sortInPlace (function <bool ()> comparator, MyDB_RecordPtr lhs,  MyDB_RecordPtr rhs) {
+bool MyDB_PageReaderWriter :: appendPax (MyDB_RecordPtr appendMe) {
+
+	size_t numAtts = appendMe->getSchema ()->getAtts ().size ();
+
+	// the first record decides how the page is split up into minipages
+	if (PAX_DIRECTORY (myPage->getBytes ())->numAtts == 0) {
+		if (PAX_DATA_START (numAtts) > pageSize)
+			return false;
+		PAX_DIRECTORY (myPage->getBytes ())->numAtts = numAtts;
+		for (size_t i = 0; i < numAtts; i++) {
+			MyDB_MiniPage *mini = MINI_PAGE (myPage->getBytes (), i);
+			mini->start = PAX_DATA_START (numAtts);
+			mini->capacity = mini->used = 0;
+			mini->encoding = PaxPlain;
+			mini->numEncoded = mini->encodedBytes = 0;
+		}
+	}
+
+	// see if every value fits at the end of its minipage; if not, split the page
+	// up again, with what is on it so far (and this record) as the guide
+	vector <size_t> sizes (numAtts), needed (numAtts);
+	bool fits = true;
+	for (size_t i = 0; i < numAtts; i++) {
+		MyDB_MiniPage *mini = MINI_PAGE (myPage->getBytes (), i);
+		sizes[i] = appendMe->getAtt (i)->getBinarySize ();
+		needed[i] = mini->used + sizes[i];
+		if (needed[i] > mini->capacity)
+			fits = false;
+	}
+	if (!fits && !partitionPax (needed) &&
+		!(PAX_DIRECTORY (myPage->getBytes ())->compress && compressPax (appendMe, sizes, false)))
+		return false;
+
+	// write the values; they are logged before the directory that makes them part
+	// of the page, so if only they make it into the log, the page is as it was
+	char *bytes = (char *) myPage->getBytes ();
+	for (size_t i = 0; i < numAtts; i++) {
+		MyDB_MiniPage *mini = MINI_PAGE (bytes, i);
+		appendMe->getAtt (i)->toBinary (bytes + mini->start + mini->used);
+		myPage->wroteBytes (mini->start + mini->used, sizes[i]);
+		mini->used += sizes[i];
+	}
+	PAX_DIRECTORY (bytes)->numRecords++;
+	myPage->wroteBytes (sizeof (MyDB_PageHeader), PAX_DATA_START (numAtts) - sizeof (MyDB_PageHeader));
+	addToZone (appendMe, true);
+	return true;
+}
 
+bool MyDB_PageReaderWriter :: partitionPax (vector <size_t> &needed) {
+
+	char *bytes = (char *) myPage->getBytes ();
+	size_t numAtts = PAX_DIRECTORY (bytes)->numAtts;
+	size_t total = 0;
+	for (size_t bytesNeeded : needed)
+		total += bytesNeeded;
+	if (PAX_DATA_START (numAtts) + total > pageSize)
+		return false;
+
+	// the whole page is rewritten, so the changes are logged together
+	MyDB_ActionGuard action (myPage->getParent ());
+
+	// each minipage gets what it needs, plus a share of the space left over in
+	// proportion to that
+	size_t spare = pageSize - PAX_DATA_START (numAtts) - total;
 	void *temp = malloc (pageSize);
-	memcpy (temp, myPage->getBytes (), pageSize);
+	memcpy (temp, bytes, pageSize);
+	size_t start = PAX_DATA_START (numAtts);
+	for (size_t i = 0; i < numAtts; i++) {
+		MyDB_MiniPage *mini = MINI_PAGE (bytes, i);
+		memcpy (bytes + start, ((char *) temp) + mini->start, mini->used);
+		mini->start = start;
+		mini->capacity = needed[i] + (total == 0 ? spare / numAtts : spare * needed[i] / total);
+		start += mini->capacity;
+	}
+	free (temp);
 
-	// first, read in the positions of all of the records
-	vector <void *> positions;
-	
-	// this basically iterates through all of the records on the page
-	int bytesConsumed = sizeof (size_t) * 2;
-	while (bytesConsumed != NUM_BYTES_USED) {
-		void *pos = bytesConsumed + (char *) temp;
-		positions.push_back (pos);
-		void *nextPos = lhs->fromBinary (pos);
-		bytesConsumed += ((char *) nextPos) - ((char *) pos);
+	myPage->wroteBytes (0, pageSize);
+	return true;
+}
+
+bool MyDB_PageReaderWriter :: compressPax (MyDB_RecordPtr likeMe, vector <size_t> &sizes, bool force) {
+
+	char *bytes = (char *) myPage->getBytes ();
+	size_t numAtts = PAX_DIRECTORY (bytes)->numAtts;
+	auto &atts = likeMe->getSchema ()->getAtts ();
+
+	// encode each minipage, as it is now...
+	vector <vector <char>> encoded (numAtts);
+	vector <MyDB_PaxEncoding> encodings (numAtts);
+	size_t usedNow = 0, usedAfter = 0;
+	for (size_t i = 0; i < numAtts; i++) {
+		vector <void *> positions;
+		vector <int> unpacked;
+		MyDB_AttValPtr scratch = atts[i].second->createAtt ();
+		MyDB_PaxCodec :: decode (bytes, i, scratch, positions, unpacked);
+		encodings[i] = MyDB_PaxCodec :: encode (positions, scratch, atts[i].second->promotableToInt (), encoded[i]);
+		usedNow += MINI_PAGE (bytes, i)->used + sizes[i];
+		usedAfter += encoded[i].size () + sizes[i];
 	}
 
-	// and now we sort the vector of positions, using the record contents to build a comparator
-	RecordComparator myComparator (comparator, lhs, rhs);
-	std::sort (positions.begin (), positions.end (), myComparator);
+	// ...and see if it is worth it
+	if (PAX_DATA_START (numAtts) + usedAfter > pageSize ||
+		(!force && usedAfter + PAX_MIN_COMPRESSION_GAIN * pageSize > usedNow))
+		return false;
 
-	// and write the guys back
-	NUM_BYTES_USED = 2 * sizeof (size_t);
-	myPage->wroteBytes ();	
-	for (void *pos : positions) {
-		lhs->fromBinary (pos);
-		append (lhs);
+	// if it is, put the encoded minipages one after another, and then split the
+	// page up again so that this record fits; values that are left as they are
+	// count as not being encoded
+	MyDB_ActionGuard action (myPage->getParent ());
+	size_t start = PAX_DATA_START (numAtts);
+	vector <size_t> needed (numAtts);
+	for (size_t i = 0; i < numAtts; i++) {
+		MyDB_MiniPage *mini = MINI_PAGE (bytes, i);
+		mini->start = start;
+		mini->capacity = mini->used = encoded[i].size ();
+		mini->encoding = encodings[i];
+		mini->numEncoded = encodings[i] == PaxPlain ? 0 : PAX_DIRECTORY (bytes)->numRecords;
+		mini->encodedBytes = encodings[i] == PaxPlain ? 0 : encoded[i].size ();
+		memcpy (bytes + start, encoded[i].data (), encoded[i].size ());
+		start += encoded[i].size ();
+		needed[i] = mini->used + sizes[i];
+	}
+	myPage->wroteBytes (0, pageSize);
+	return partitionPax (needed);
+}
+
+size_t MyDB_PageReaderWriter :: fillPax (bool compress, MyDB_RecordPtr likeMe, vector <void *> &positions, size_t from) {
+
+	formatPax (compress);
+	size_t numAtts = likeMe->getSchema ()->getAtts ().size ();
+	vector <size_t> sizes (numAtts);
+	size_t i = from;
+	for (; i < positions.size (); i++) {
+		likeMe->fromBinary (positions[i]);
+		if (append (likeMe))
+			continue;
+
+		// the records may not compress as well in this order as they did before,
+		// so the page is compressed however little that frees up
+		if (!compress)
+			break;
+		for (size_t j = 0; j < numAtts; j++)
+			sizes[j] = likeMe->getAtt (j)->getBinarySize ();
+		if (!compressPax (likeMe, sizes, true) || !append (likeMe))
+			break;
+	}
+	return i - from;
+}
+
+void MyDB_PageReaderWriter :: getRows (MyDB_RecordPtr likeMe, vector <char> &rows, vector <void *> &positions) {
+
+	// copy each record out in the row format...
+	vector <size_t> offsets;
+	MyDB_RecordIteratorPtr myIter = getIterator (likeMe);
+	while (myIter->hasNext ()) {
+		myIter->getNext ();
+		offsets.push_back (rows.size ());
+		rows.resize (rows.size () + likeMe->getBinarySize ());
+		likeMe->toBinary (&rows[offsets.back ()]);
+	}
+
+	// ...and only then find them, since the vector moves as it grows
+	for (size_t offset : offsets)
+		positions.push_back (&rows[offset]);
+}
+
+void MyDB_PageReaderWriter :: getPositions (MyDB_RecordPtr likeMe, vector <char> &rows, vector <void *> &positions) {
+
+	// the records on a legacy page are copied out in the current format, just
+	// like those on a PAX page
+	if (PAGE_TYPE == MyDB_PageType :: PaxPage || LEGACY) {
+		getRows (likeMe, rows, positions);
+		return;
+	}
+
+	for (int i = 0; i < NUM_SLOTS; i++) {
+		if (SLOT (i)->offset != 0)
+			positions.push_back (SLOT (i)->offset + (char *) myPage->getBytes ());
+	}
+}
+
+int MyDB_PageReaderWriter :: getNumSlots () {
+	if (PAGE_TYPE == MyDB_PageType :: PaxPage)
+		return PAX_DIRECTORY (myPage->getBytes ())->numRecords;
+	checkSlotted ();
+	return NUM_SLOTS;
+}
+
+bool MyDB_PageReaderWriter :: getRecord (int whichSlot, MyDB_RecordPtr intoMe) {
+
+	// on a PAX page, the minipages are decoded to find it
+	if (PAGE_TYPE == MyDB_PageType :: PaxPage) {
+		char *bytes = (char *) myPage->getBytes ();
+		if (whichSlot < 0 || whichSlot >= (int) PAX_DIRECTORY (bytes)->numRecords)
+			return false;
+		for (size_t i = 0; i < PAX_DIRECTORY (bytes)->numAtts; i++) {
+			vector <void *> positions;
+			vector <int> unpacked;
+			MyDB_PaxCodec :: decode (bytes, i, intoMe->getSchema ()->getAtts ()[i].second->createAtt (),
+				positions, unpacked);
+			intoMe->getAtt (i)->fromBinary (positions[whichSlot]);
+		}
+		return true;
 	}
 
+	checkSlotted ();
+	if (whichSlot < 0 || whichSlot >= NUM_SLOTS || SLOT (whichSlot)->offset == 0)
+		return false;
+	loadRecord (myPage->getBytes (), SLOT (whichSlot)->offset + (char *) myPage->getBytes (), intoMe);
+	return true;
+}
+
+bool MyDB_PageReaderWriter :: isLegacy (void *page) {
+	return !MyDB_PageHeader :: isFormatted (page) || ((MyDB_PageHeader *) page)->version < LENGTH_PREFIX_VERSION;
+}
+
+void MyDB_PageReaderWriter :: checkSlotted () {
+	if (MyDB_PageHeader :: isSequential (myPage->getBytes ()))
+		throw MyDB_PageFormatError ("Can't find the records on a page written before the slot directory!!");
+}
+
+void MyDB_PageReaderWriter :: checkWritable () {
+	if (readOnly)
+		throw MyDB_ReadOnlyError ();
+}
+
+void *MyDB_PageReaderWriter :: loadRecord (void *page, void *pos, MyDB_RecordPtr intoMe) {
+	if (isLegacy (page))
+		return intoMe->fromLegacyBinary (pos);
+	return intoMe->fromBinary (pos);
+}
+
+bool MyDB_PageReaderWriter :: deleteRecord (int whichSlot) {
+	checkWritable ();
+	if (PAGE_TYPE == MyDB_PageType :: PaxPage)
+		return false;
+	checkSlotted ();
+	if (whichSlot < 0 || whichSlot >= NUM_SLOTS || SLOT (whichSlot)->offset == 0)
+		return false;
+	SLOT (whichSlot)->offset = 0;
+	myPage->wroteBytes (pageSize - (whichSlot + 1) * sizeof (MyDB_PageSlot), sizeof (MyDB_PageSlot));
+	return true;
+}
+
+bool MyDB_PageReaderWriter :: updateRecord (int whichSlot, MyDB_RecordPtr newRec) {
+
+	checkWritable ();
+	if (PAGE_TYPE == MyDB_PageType :: PaxPage)
+		return false;
+	checkSlotted ();
+	if (whichSlot < 0 || whichSlot >= NUM_SLOTS || SLOT (whichSlot)->offset == 0)
+		return false;
+
+	size_t slotPos = pageSize - (whichSlot + 1) * sizeof (MyDB_PageSlot);
+	bool legacy = LEGACY;
+	size_t recSize = legacy ? newRec->getLegacyBinarySize () : newRec->getBinarySize ();
+	MyDB_ActionGuard action (myPage->getParent ());
+
+	// a record that is no bigger than the old one goes right where it was
+	if (recSize <= SLOT (whichSlot)->length) {
+		if (legacy)
+			newRec->toLegacyBinary (SLOT (whichSlot)->offset + (char *) myPage->getBytes ());
+		else
+			newRec->toBinary (SLOT (whichSlot)->offset + (char *) myPage->getBytes ());
+		myPage->wroteBytes (SLOT (whichSlot)->offset, recSize);
+		SLOT (whichSlot)->length = recSize;
+		myPage->wroteBytes (slotPos, sizeof (MyDB_PageSlot));
+		addToZone (newRec, false);
+		return true;
+	}
+
+	// otherwise, it goes at the end, once the space of the old one (and of any
+	// deleted records) is taken back, if need be
+	if (recSize > NUM_BYTES_LEFT) {
+		if (recSize > NUM_BYTES_LEFT + NUM_BYTES_USED - getNumBytesLive () + SLOT (whichSlot)->length)
+			return false;
+		SLOT (whichSlot)->offset = 0;
+		compact ();
+	}
+
+	size_t offset = NUM_BYTES_USED;
+	if (legacy)
+		newRec->toLegacyBinary (offset + (char *) myPage->getBytes ());
+	else
+		newRec->toBinary (offset + (char *) myPage->getBytes ());
+	myPage->wroteBytes (offset, recSize);
+	SLOT (whichSlot)->offset = offset;
+	SLOT (whichSlot)->length = recSize;
+	myPage->wroteBytes (slotPos, sizeof (MyDB_PageSlot));
+	NUM_BYTES_USED += recSize;
+	myPage->wroteBytes (0, sizeof (MyDB_PageHeader));
+	addToZone (newRec, false);
+	return true;
+}
+
+size_t MyDB_PageReaderWriter :: getNumBytesLive () {
+	char *bytes = (char *) myPage->getBytes ();
+	size_t returnVal = sizeof (MyDB_PageHeader);
+	for (int i = 0; i < NUM_SLOTS; i++) {
+		MyDB_PageSlot *slot = MyDB_PageHeader :: getSlot (bytes, pageSize, i);
+		if (slot->offset != 0)
+			returnVal += slot->length;
+	}
+	return returnVal;
+}
+
+void MyDB_PageReaderWriter :: compact () {
+
+	checkWritable ();
+
+	// the whole page is rewritten, so the changes are logged together
+	MyDB_ActionGuard action (myPage->getParent ());
+
+	char *bytes = (char *) myPage->getBytes ();
+	void *temp = malloc (pageSize);
+	memcpy (temp, bytes, pageSize);
+
+	// copy the records back one after another, in slot order; the slots stay
+	// where they are, so no record changes its number
+	size_t used = sizeof (MyDB_PageHeader);
+	for (int i = 0; i < NUM_SLOTS; i++) {
+		MyDB_PageSlot *slot = MyDB_PageHeader :: getSlot (bytes, pageSize, i);
+		if (slot->offset == 0)
+			continue;
+		memcpy (bytes + used, ((char *) temp) + slot->offset, slot->length);
+		slot->offset = used;
+		used += slot->length;
+	}
 	free (temp);
+
+	NUM_BYTES_USED = used;
+	myPage->wroteBytes (0, used);
+	myPage->wroteBytes (pageSize - NUM_SLOTS * sizeof (MyDB_PageSlot), NUM_SLOTS * sizeof (MyDB_PageSlot));
+}
+
+void MyDB_PageReaderWriter :: sortPositions (vector <void *> &positions, bool legacy, function <bool ()> comparator,
+	MyDB_RecordPtr lhs, MyDB_RecordPtr rhs, MyDB_SortKeyPtr key) {
+
+	RecordComparator myComparator (comparator, lhs, rhs, legacy);
+	if (key == nullptr) {
+		std::sort (positions.begin (), positions.end (), myComparator);
+		return;
+	}
+
+	// pair each record with its key...
+	vector <pair <uint64_t, void *>> keyed;
+	keyed.reserve (positions.size ());
+	for (void *pos : positions) {
+		if (legacy)
+			lhs->fromLegacyBinary (pos);
+		else
+			lhs->view (pos);
+		keyed.push_back (make_pair (key->getKey (), pos));
+	}
+
+	// ...and sort on the keys; the records only have to be looked at again to break ties,
+	// and there are none that matter if the key is exact
+	if (key->isExact ())
+		MyDB_SortKey :: radixSort (keyed);
+	else
+		std::sort (keyed.begin (), keyed.end (), myComparator);
+
+	for (size_t i = 0; i < keyed.size (); i++)
+		positions[i] = keyed[i].second;
+}
+
+void MyDB_PageReaderWriter :: 
+	sortInPlace (function <bool ()> comparator, MyDB_RecordPtr lhs,  MyDB_RecordPtr rhs, MyDB_SortKeyPtr key) {
+
+	checkWritable ();
+
+	// the slots are rewritten, and the header changes, so they are logged together
+	MyDB_ActionGuard action (myPage->getParent ());
+
+	// a PAX page is sorted by taking the records out in the row format, and
+	// putting them back in sorted order (see sortIntoList ())
+	if (PAGE_TYPE == MyDB_PageType :: PaxPage) {
+		// the sorted records are put on a page of their own first, since they
+		// may not all fit; the page then has the same records as before, so its
+		// zone does not change
+		vector <MyDB_PageReaderWriter> sorted = sortIntoList (comparator, lhs, rhs, key);
+		if (sorted.size () > 1)
+			throw MyDB_PageOverflowError ();
+		memcpy (myPage->getBytes (), sorted[0].getBytes (), pageSize);
+		myPage->wroteBytes (0, pageSize);
+		return;
+	}
+
+	// get the slots that have records in them
+	checkSlotted ();
+	char *bytes = (char *) myPage->getBytes ();
+	vector <MyDB_PageSlot> slots;
+	for (int i = 0; i < NUM_SLOTS; i++) {
+		MyDB_PageSlot *slot = MyDB_PageHeader :: getSlot (bytes, pageSize, i);
+		if (slot->offset != 0)
+			slots.push_back (*slot);
+	}
+
+	// sort them on the contents of the records that they point to; the records
+	// themselves stay where they are, and the slots are found again by where the
+	// records are
+	vector <void *> positions;
+	for (MyDB_PageSlot &slot : slots)
+		positions.push_back (bytes + slot.offset);
+	sortPositions (positions, isLegacy (bytes), comparator, lhs, rhs, key);
+	auto before = [] (const MyDB_PageSlot &lhsSlot, const MyDB_PageSlot &rhsSlot) {
+		return lhsSlot.offset < rhsSlot.offset;
+	};
+	vector <MyDB_PageSlot> byOffset (slots);
+	std::sort (byOffset.begin (), byOffset.end (), before);
+	for (size_t i = 0; i < positions.size (); i++) {
+		MyDB_PageSlot find;
+		find.offset = ((char *) positions[i]) - bytes;
+		slots[i] = *lower_bound (byOffset.begin (), byOffset.end (), find, before);
+	}
+
+	// and write the slots back, leaving out any deleted ones
+	for (size_t i = 0; i < slots.size (); i++)
+		*MyDB_PageHeader :: getSlot (bytes, pageSize, i) = slots[i];
+	NUM_SLOTS = slots.size ();
+	myPage->wroteBytes (pageSize - slots.size () * sizeof (MyDB_PageSlot), slots.size () * sizeof (MyDB_PageSlot));
+	myPage->wroteBytes (0, sizeof (MyDB_PageHeader));
 }
 
 MyDB_PageReaderWriterPtr MyDB_PageReaderWriter :: 
-	sort (function <bool ()> comparator, MyDB_RecordPtr lhs,  MyDB_RecordPtr rhs) {
+	sort (function <bool ()> comparator, MyDB_RecordPtr lhs,  MyDB_RecordPtr rhs, MyDB_SortKeyPtr key) {
+
+	if (PAGE_TYPE == MyDB_PageType :: PaxPage) {
+		vector <MyDB_PageReaderWriter> sorted = sortIntoList (comparator, lhs, rhs, key);
+		if (sorted.size () > 1)
+			throw MyDB_PageOverflowError ();
+		return make_shared <MyDB_PageReaderWriter> (sorted[0]);
+	}
 
-	// first, read in the positions of all of the records
+	// first, get the positions of all of the records
+	checkSlotted ();
 	vector <void *> positions;
-	
-	// this basically iterates through all of the records on the page
-	int bytesConsumed = sizeof (size_t) * 2;
-	while (bytesConsumed != NUM_BYTES_USED) {
-		void *pos = bytesConsumed + (char *) myPage->getBytes ();
-		positions.push_back (pos);
-		void *nextPos = lhs->fromBinary (pos);
-		bytesConsumed += ((char *) nextPos) - ((char *) pos);
+	for (int i = 0; i < NUM_SLOTS; i++) {
+		if (SLOT (i)->offset != 0)
+			positions.push_back (SLOT (i)->offset + (char *) myPage->getBytes ());
 	}
 
 	// and now we sort the vector of positions, using the record contents to build a comparator
-	RecordComparator myComparator (comparator, lhs, rhs);
-	std::sort (positions.begin (), positions.end (), myComparator);
+	bool legacy = LEGACY;
+	sortPositions (positions, legacy, comparator, lhs, rhs, key);
 
 	// and now create the page to return
 	MyDB_PageReaderWriterPtr returnVal = make_shared <MyDB_PageReaderWriter> (myPage->getParent ());
 	returnVal->clear ();
+
+	// the sorted page is written in the same format as this one, so that the
+	// records are sure to fit
+	if (legacy)
+		((MyDB_PageHeader *) returnVal->getBytes ())->version = ((MyDB_PageHeader *) myPage->getBytes ())->version;
 	
 	// loop through all of the sorted records and write them out
 	for (void *pos : positions) {
-		lhs->fromBinary (pos);
+		if (legacy)
+			lhs->fromLegacyBinary (pos);
+		else
+			lhs->fromBinary (pos);
 		returnVal->append (lhs);
 	}
 
 	return returnVal;
 }
 
+vector <MyDB_PageReaderWriter> MyDB_PageReaderWriter :: 
+	sortIntoList (function <bool ()> comparator, MyDB_RecordPtr lhs,  MyDB_RecordPtr rhs, MyDB_SortKeyPtr key) {
+
+	vector <MyDB_PageReaderWriter> returnVal;
+	if (PAGE_TYPE != MyDB_PageType :: PaxPage) {
+		returnVal.push_back (*sort (comparator, lhs, rhs, key));
+		return returnVal;
+	}
+
+	// copy the records out in the row format, and sort them...
+	vector <char> rows;
+	vector <void *> positions;
+	getRows (lhs, rows, positions);
+	sortPositions (positions, false, comparator, lhs, rhs, key);
+
+	// ...and then fill up as many pages as it takes; like the pages of a run,
+	// they get a region of the temp space to themselves
+	MyDB_TempRegionPtr region = myPage->getParent ().makeTempRegion ();
+	bool compress = PAX_DIRECTORY (myPage->getBytes ())->compress;
+	size_t done = 0;
+	do {
+		MyDB_PageReaderWriter sorted (myPage->getParent (), region);
+		size_t numFit = sorted.fillPax (compress, lhs, positions, done);
+		if (numFit == 0 && done < positions.size ())
+			throw MyDB_PageOverflowError ();
+		done += numFit;
+		returnVal.push_back (sorted);
+	} while (done < positions.size ());
+
+	return returnVal;
+}
+
 size_t MyDB_PageReaderWriter :: getPageSize () {
 	return pageSize;
 }
@@ -13,25 +13,51 @@
 #ifndef PAGE_REC_ITER_C
 #define PAGE_REC_ITER_C
 
+#include <algorithm>
+#include "MyDB_PageHeader.h"
+#include "MyDB_PageReaderWriter.h"
 #include "MyDB_PageRecIterator.h"
 #include "MyDB_PageType.h"
 
-#define NUM_BYTES_USED *((size_t *) (((char *) myPage->getBytes ()) + sizeof (size_t)))
+#define NUM_SLOTS (((MyDB_PageHeader *) myPage->getBytes ())->numSlots)
+#define SLOT(i) (MyDB_PageHeader :: getSlot (myPage->getBytes (), pageSize, i))
+#define SEQUENTIAL (MyDB_PageHeader :: isSequential (myPage->getBytes ()))
 
 void MyDB_PageRecIterator :: getNext () {
-	void *pos = bytesConsumed + (char *) myPage->getBytes ();
- 	void *nextPos = myRec->fromBinary (pos);
-	bytesConsumed += ((char *) nextPos) - ((char *) pos);	
+
+	// a page from before the slot directory is read one record after another
+	if (SEQUENTIAL) {
+		char *bytes = (char *) myPage->getBytes ();
+		bytesConsumed = max (bytesConsumed, MyDB_PageHeader :: getSequentialStart (bytes));
+		void *nextPos = MyDB_PageReaderWriter :: loadRecord (bytes, bytes + bytesConsumed, myRec);
+		bytesConsumed = ((char *) nextPos) - bytes;
+		return;
+	}
+
+	curSlot = nextSlot ();
+	MyDB_PageReaderWriter :: loadRecord (myPage->getBytes (), SLOT (curSlot)->offset + (char *) myPage->getBytes (), myRec);
 }
 
 bool MyDB_PageRecIterator :: hasNext () {
-	return bytesConsumed != NUM_BYTES_USED;
+	if (SEQUENTIAL)
+		return max (bytesConsumed, MyDB_PageHeader :: getSequentialStart (myPage->getBytes ())) <
+			MyDB_PageHeader :: getSequentialEnd (myPage->getBytes (), pageSize);
+	return nextSlot () < NUM_SLOTS;
+}
+
+int MyDB_PageRecIterator :: nextSlot () {
+	int returnVal = curSlot + 1;
+	while (returnVal < NUM_SLOTS && SLOT (returnVal)->offset == 0)
+		returnVal++;
+	return returnVal;
 }
 
-MyDB_PageRecIterator :: MyDB_PageRecIterator (MyDB_PageHandle myPageIn, MyDB_RecordPtr myRecIn) {
-	bytesConsumed = sizeof (size_t) * 2;
+MyDB_PageRecIterator :: MyDB_PageRecIterator (MyDB_PageHandle myPageIn, MyDB_RecordPtr myRecIn, size_t pageSizeIn) {
+	curSlot = -1;
+	bytesConsumed = 0;
 	myPage = myPageIn;
 	myRec = myRecIn;
+	pageSize = pageSizeIn;
 }
 
 MyDB_PageRecIterator :: ~MyDB_PageRecIterator () {}
@@ -13,31 +13,52 @@
 #ifndef PAGE_REC_ITER_ALT_C
 #define PAGE_REC_ITER_ALT_C
 
+#include "MyDB_PageHeader.h"
+#include "MyDB_PageReaderWriter.h"
 #include "MyDB_PageRecIteratorAlt.h"
 #include "MyDB_PageType.h"
 
-#define NUM_BYTES_USED *((size_t *) (((char *) myPage->getBytes ()) + sizeof (size_t)))
+#define NUM_SLOTS (((MyDB_PageHeader *) myPage->getBytes ())->numSlots)
+#define SLOT(i) (MyDB_PageHeader :: getSlot (myPage->getBytes (), pageSize, i))
+#define SEQUENTIAL (MyDB_PageHeader :: isSequential (myPage->getBytes ()))
 
 void MyDB_PageRecIteratorAlt :: getCurrent (MyDB_RecordPtr intoMe) {
-	void *pos = bytesConsumed + (char *) myPage->getBytes ();
- 	void *nextPos = intoMe->fromBinary (pos);
-	nextRecSize = ((char *) nextPos) - ((char *) pos);	
+	if (SEQUENTIAL) {
+		char *bytes = (char *) myPage->getBytes ();
+		void *nextPos = MyDB_PageReaderWriter :: loadRecord (bytes, bytes + curPos, intoMe);
+		nextPosition = ((char *) nextPos) - bytes;
+	} else {
+		MyDB_PageReaderWriter :: loadRecord (myPage->getBytes (), SLOT (curSlot)->offset + (char *) myPage->getBytes (), intoMe);
+	}
+	gotCurrent = true;
 }
 
 bool MyDB_PageRecIteratorAlt :: advance () {
-	if (nextRecSize == -1) {
+	if (!gotCurrent) {
 		cout << "You can't call advance without calling getCurrent!!\n";
 		exit (1);
 	}
-	bytesConsumed += nextRecSize;
-	nextRecSize = -1;
-	return bytesConsumed != NUM_BYTES_USED;
+	gotCurrent = false;
+
+	// a page from before the slot directory is read one record after another
+	if (SEQUENTIAL) {
+		curPos = curPos == 0 ? MyDB_PageHeader :: getSequentialStart (myPage->getBytes ()) : nextPosition;
+		return curPos < MyDB_PageHeader :: getSequentialEnd (myPage->getBytes (), pageSize);
+	}
+
+	// skip over any deleted records
+	curSlot++;
+	while (curSlot < NUM_SLOTS && SLOT (curSlot)->offset == 0)
+		curSlot++;
+	return curSlot < NUM_SLOTS;
 }
 
-MyDB_PageRecIteratorAlt :: MyDB_PageRecIteratorAlt (MyDB_PageHandle myPageIn) {
-	bytesConsumed = sizeof (size_t) * 2;
+MyDB_PageRecIteratorAlt :: MyDB_PageRecIteratorAlt (MyDB_PageHandle myPageIn, size_t pageSizeIn) {
+	curSlot = -1;
+	curPos = nextPosition = 0;
 	myPage = myPageIn;
-	nextRecSize = 0;
+	pageSize = pageSizeIn;
+	gotCurrent = true;
 }
 
 MyDB_PageRecIteratorAlt :: ~MyDB_PageRecIteratorAlt () {}
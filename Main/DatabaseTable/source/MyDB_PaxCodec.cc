@@ -0,0 +1,205 @@
+
+#ifndef PAX_CODEC_C
+#define PAX_CODEC_C
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include "MyDB_PaxCodec.h"
+
+// the most values that a dictionary can have, since a record says which one it
+// has with a byte
+#define PAX_MAX_DICTIONARY 256
+
+// bit-packed values are read eight bytes at a time, so this many bytes of zeros
+// follow them
+#define PAX_PACKING_SLOP 8
+
+void MyDB_PaxCodec :: decode (void *page, size_t whichAtt, MyDB_AttValPtr scratch,
+	vector <void *> &positions, vector <int> &unpacked) {
+
+	MyDB_MiniPage *mini = MINI_PAGE (page, whichAtt);
+	size_t numRecs = PAX_DIRECTORY (page)->numRecords;
+	size_t numEncoded = mini->numEncoded;
+	char *data = ((char *) page) + mini->start;
+	positions.resize (numRecs);
+
+	if (mini->encoding == PaxDictionary) {
+
+		// find the values in the dictionary, and then look up each record's
+		uint32_t numValues;
+		memcpy (&numValues, data, sizeof (numValues));
+		void *values[PAX_MAX_DICTIONARY];
+		char *pos = data + sizeof (numValues);
+		for (uint32_t i = 0; i < numValues; i++) {
+			values[i] = pos;
+			pos = (char *) scratch->viewBinary (pos);
+		}
+		uint8_t *codes = (uint8_t *) pos;
+		for (size_t i = 0; i < numEncoded; i++)
+			positions[i] = values[codes[i]];
+
+	} else if (mini->encoding == PaxRunLength) {
+
+		uint32_t numRuns;
+		memcpy (&numRuns, data, sizeof (numRuns));
+		char *pos = data + sizeof (numRuns);
+		size_t done = 0;
+		for (uint32_t i = 0; i < numRuns; i++) {
+			uint32_t runLength;
+			memcpy (&runLength, pos, sizeof (runLength));
+			pos += sizeof (runLength);
+			for (uint32_t j = 0; j < runLength; j++)
+				positions[done++] = pos;
+			pos = (char *) scratch->viewBinary (pos);
+		}
+
+	} else if (mini->encoding == PaxBitPacked) {
+
+		// each value is the bits at a fixed place, so there is nothing to do
+		// but shift and mask
+		int32_t base;
+		uint32_t numBits;
+		memcpy (&base, data, sizeof (base));
+		memcpy (&numBits, data + sizeof (base), sizeof (numBits));
+		unsigned char *packed = (unsigned char *) data + sizeof (base) + sizeof (numBits);
+		uint64_t mask = (((uint64_t) 1) << numBits) - 1;
+		unpacked.resize (numEncoded);
+		int *out = unpacked.data ();
+		for (size_t i = 0; i < numEncoded; i++) {
+			uint64_t bit = i * numBits;
+			uint64_t word;
+			memcpy (&word, packed + (bit >> 3), sizeof (word));
+			out[i] = (int) ((uint32_t) base + (uint32_t) ((word >> (bit & 7)) & mask));
+		}
+		for (size_t i = 0; i < numEncoded; i++)
+			positions[i] = out + i;
+	}
+
+	// the values after the encoded ones are as they are
+	char *pos = data + mini->encodedBytes;
+	for (size_t i = numEncoded; i < numRecs; i++) {
+		positions[i] = pos;
+		pos = (char *) scratch->viewBinary (pos);
+	}
+}
+
+MyDB_PaxEncoding MyDB_PaxCodec :: encode (vector <void *> &values, MyDB_AttValPtr scratch, bool isInt,
+	vector <char> &encoded) {
+
+	size_t numValues = values.size ();
+	vector <size_t> sizes (numValues);
+	for (size_t i = 0; i < numValues; i++)
+		sizes[i] = ((char *) scratch->viewBinary (values[i])) - (char *) values[i];
+
+	auto sameAsLast = [&] (size_t i) {
+		return i > 0 && sizes[i] == sizes[i - 1] && memcmp (values[i], values[i - 1], sizes[i]) == 0;
+	};
+
+	// figure out how many bytes each encoding takes...
+	size_t plainBytes = 0, runBytes = sizeof (uint32_t), dictBytes = sizeof (uint32_t) + numValues;
+	map <string, uint8_t> dictionary;
+	vector <void *> dictValues;
+	for (size_t i = 0; i < numValues; i++) {
+		plainBytes += sizes[i];
+		if (!sameAsLast (i))
+			runBytes += sizeof (uint32_t) + sizes[i];
+		if (dictValues.size () <= PAX_MAX_DICTIONARY) {
+			string value ((char *) values[i], sizes[i]);
+			if (dictionary.count (value) == 0) {
+				dictionary[value] = dictValues.size ();
+				dictValues.push_back (values[i]);
+				dictBytes += sizes[i];
+			}
+		}
+	}
+
+	int32_t low = 0, high = 0;
+	uint32_t numBits = 0;
+	size_t packedBytes = plainBytes + 1;
+	if (isInt && numValues > 0) {
+		memcpy (&low, values[0], sizeof (low));
+		high = low;
+		for (size_t i = 1; i < numValues; i++) {
+			int32_t val;
+			memcpy (&val, values[i], sizeof (val));
+			low = min (low, val);
+			high = max (high, val);
+		}
+		uint64_t range = (uint64_t) ((int64_t) high - (int64_t) low);
+		while ((range >> numBits) != 0)
+			numBits++;
+		packedBytes = sizeof (low) + sizeof (numBits) + (numValues * numBits + 7) / 8 + PAX_PACKING_SLOP;
+	}
+
+	// ...and use the smallest
+	MyDB_PaxEncoding encoding = PaxPlain;
+	size_t best = plainBytes;
+	if (runBytes < best) {
+		encoding = PaxRunLength;
+		best = runBytes;
+	}
+	if (dictValues.size () <= PAX_MAX_DICTIONARY && dictBytes < best) {
+		encoding = PaxDictionary;
+		best = dictBytes;
+	}
+	if (packedBytes < best) {
+		encoding = PaxBitPacked;
+		best = packedBytes;
+	}
+
+	encoded.clear ();
+	encoded.reserve (best);
+	auto put = [&] (const void *bytes, size_t len) {
+		encoded.insert (encoded.end (), (const char *) bytes, ((const char *) bytes) + len);
+	};
+
+	if (encoding == PaxPlain) {
+		for (size_t i = 0; i < numValues; i++)
+			put (values[i], sizes[i]);
+
+	} else if (encoding == PaxRunLength) {
+		uint32_t numRuns = 0;
+		put (&numRuns, sizeof (numRuns));
+		size_t runStart = 0;
+		for (size_t i = 1; i <= numValues; i++) {
+			if (i < numValues && sameAsLast (i))
+				continue;
+			uint32_t runLength = i - runStart;
+			put (&runLength, sizeof (runLength));
+			put (values[runStart], sizes[runStart]);
+			runStart = i;
+			numRuns++;
+		}
+		memcpy (encoded.data (), &numRuns, sizeof (numRuns));
+
+	} else if (encoding == PaxDictionary) {
+		uint32_t numEntries = dictValues.size ();
+		put (&numEntries, sizeof (numEntries));
+		for (void *value : dictValues)
+			put (value, ((char *) scratch->viewBinary (value)) - (char *) value);
+		for (size_t i = 0; i < numValues; i++)
+			encoded.push_back (dictionary[string ((char *) values[i], sizes[i])]);
+
+	} else {
+		put (&low, sizeof (low));
+		put (&numBits, sizeof (numBits));
+		size_t packedStart = encoded.size ();
+		encoded.resize (best, 0);
+		unsigned char *packed = (unsigned char *) &encoded[packedStart];
+		for (size_t i = 0; i < numValues; i++) {
+			int32_t val;
+			memcpy (&val, values[i], sizeof (val));
+			uint64_t bit = i * numBits;
+			uint64_t word;
+			memcpy (&word, packed + (bit >> 3), sizeof (word));
+			word |= ((uint64_t) ((uint32_t) val - (uint32_t) low)) << (bit & 7);
+			memcpy (packed + (bit >> 3), &word, sizeof (word));
+		}
+	}
+
+	return encoding;
+}
+
+#endif
@@ -0,0 +1,58 @@
+
+#ifndef PAX_PAGE_REC_ITER_C
+#define PAX_PAGE_REC_ITER_C
+
+#include "MyDB_PaxCodec.h"
+#include "MyDB_PaxPage.h"
+#include "MyDB_PaxPageRecIterator.h"
+#include "MyDB_RecordView.h"
+
+void MyDB_PaxPageRecIterator :: getNext () {
+
+	// the minipages are decoded when the first record is asked for, and again
+	// whenever the page has moved since then
+	void *bytes = myPage->getBytes ();
+	if (bytes != decodedFrom) {
+		positions.resize (whichAtts.size ());
+		unpacked.resize (whichAtts.size ());
+		for (size_t i = 0; i < whichAtts.size (); i++) {
+			MyDB_AttValPtr scratch = myRec->getSchema ()->getAtts ()[whichAtts[i]].second->createAtt ();
+			MyDB_PaxCodec :: decode (bytes, whichAtts[i], scratch, positions[i], unpacked[i]);
+		}
+		decodedFrom = bytes;
+	}
+
+	for (size_t i = 0; i < whichAtts.size (); i++) {
+		if (viewing)
+			atts[i]->viewBinary (positions[i][numDone]);
+		else
+			atts[i]->fromBinary (positions[i][numDone]);
+	}
+	numDone++;
+}
+
+bool MyDB_PaxPageRecIterator :: hasNext () {
+	return numDone < PAX_DIRECTORY (myPage->getBytes ())->numRecords;
+}
+
+MyDB_PaxPageRecIterator :: MyDB_PaxPageRecIterator (MyDB_PageHandle myPageIn, MyDB_RecordPtr myRecIn, 
+	vector <int> whichAttsIn) {
+
+	myPage = myPageIn;
+	myRec = myRecIn;
+	whichAtts = whichAttsIn;
+	if (whichAtts.empty ()) {
+		for (int i = 0; i < (int) myRec->getSchema ()->getAtts ().size (); i++)
+			whichAtts.push_back (i);
+	}
+
+	for (int i : whichAtts)
+		atts.push_back (myRec->getAtt (i));
+	viewing = dynamic_pointer_cast <MyDB_RecordView> (myRec) != nullptr;
+	numDone = 0;
+	decodedFrom = nullptr;
+}
+
+MyDB_PaxPageRecIterator :: ~MyDB_PaxPageRecIterator () {}
+
+#endif
@@ -0,0 +1,50 @@
+
+#ifndef PAX_PAGE_REC_ITER_ALT_C
+#define PAX_PAGE_REC_ITER_ALT_C
+
+#include <iostream>
+#include "MyDB_PaxCodec.h"
+#include "MyDB_PaxPage.h"
+#include "MyDB_PaxPageRecIteratorAlt.h"
+
+void MyDB_PaxPageRecIteratorAlt :: getCurrent (MyDB_RecordPtr intoMe) {
+
+	// the minipages are decoded when the first record is asked for, and again
+	// whenever the page has moved since then
+	char *bytes = (char *) myPage->getBytes ();
+	size_t numAtts = PAX_DIRECTORY (bytes)->numAtts;
+	if (bytes != decodedFrom) {
+		positions.resize (numAtts);
+		unpacked.resize (numAtts);
+		for (size_t i = 0; i < numAtts; i++) {
+			MyDB_AttValPtr scratch = intoMe->getSchema ()->getAtts ()[i].second->createAtt ();
+			MyDB_PaxCodec :: decode (bytes, i, scratch, positions[i], unpacked[i]);
+		}
+		decodedFrom = bytes;
+	}
+
+	for (size_t i = 0; i < numAtts; i++)
+		intoMe->getAtt (i)->fromBinary (positions[i][curRec]);
+	gotCurrent = true;
+}
+
+bool MyDB_PaxPageRecIteratorAlt :: advance () {
+	if (!gotCurrent) {
+		cout << "You can't call advance without calling getCurrent!!\n";
+		exit (1);
+	}
+	gotCurrent = false;
+	curRec++;
+	return curRec < (long) PAX_DIRECTORY (myPage->getBytes ())->numRecords;
+}
+
+MyDB_PaxPageRecIteratorAlt :: MyDB_PaxPageRecIteratorAlt (MyDB_PageHandle myPageIn) {
+	curRec = -1;
+	myPage = myPageIn;
+	gotCurrent = true;
+	decodedFrom = nullptr;
+}
+
+MyDB_PaxPageRecIteratorAlt :: ~MyDB_PaxPageRecIteratorAlt () {}
+
+#endif
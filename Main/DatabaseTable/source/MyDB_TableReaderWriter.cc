@@ -14,7 +14,9 @@
 #define TABLE_RW_C
 
 #include <fstream>
+#include <iostream>
 #include <queue>
+#include "MyDB_PageHeader.h"
 #include "MyDB_PageReaderWriter.h"
 #include "MyDB_TableRecIterator.h"
 #include "MyDB_TableRecIteratorAlt.h"
@@ -23,11 +25,45 @@
 
 using namespace std;
 
-MyDB_TableReaderWriter :: MyDB_TableReaderWriter (MyDB_TablePtr forMeIn, MyDB_BufferManagerPtr myBufferIn) {
+MyDB_TableReaderWriter :: MyDB_TableReaderWriter (MyDB_TablePtr forMeIn, MyDB_BufferManagerPtr myBufferIn) :
+	MyDB_TableReaderWriter (forMeIn, myBufferIn, false) {}
+
+MyDB_TableReaderWriter :: MyDB_TableReaderWriter (MyDB_TablePtr forMeIn, MyDB_BufferManagerPtr myBufferIn, 
+	bool readOnlyIn) {
 	forMe = forMeIn;
 	myBuffer = myBufferIn;
+	readOnly = readOnlyIn;
+
+	if (readOnly)
+		myBuffer->mapReadOnly (forMe);
+
+	// redoing the log may have added pages that the catalog does not know about,
+	// and changed the ones it does, so then the zone map cannot be trusted
+	zones = forMe->getZoneMap ();
+	long recovered = myBuffer->getRecoveredLastPage (forMe);
+	if (recovered > forMe->lastPage ())
+		forMe->setLastPage (recovered);
+	if (recovered != -1)
+		zones->invalidate ();
+
+	// a table written before the slot directory is rewritten in the current format
+	if (!readOnly && forMe->lastPage () >= 0 &&
+		MyDB_PageHeader :: isSequential (MyDB_PageReaderWriter (*this, 0).getBytes ()))
+		migrate ();
+
+	// so now every page of the table has a header; if the catalog does not know
+	// that yet (see MyDB_Table :: getPageFormat), the first page says which format
+	if (!readOnly && forMe->getPageFormat () == 0) {
+		if (forMe->lastPage () == -1)
+			forMe->setPageFormat (PAGE_FORMAT_VERSION);
+		else
+			forMe->setPageFormat (((MyDB_PageHeader *) MyDB_PageReaderWriter (*this, 0).getBytes ())->version);
+	}
 
-	if (forMe->lastPage () == -1) {
+	// a read-only table is not given a first page; it just has no pages
+	if (forMe->lastPage () == -1 && readOnly) {
+		lastPage = nullptr;
+	} else if (forMe->lastPage () == -1) {
 		forMe->setLastPage (0);
 		lastPage = make_shared <MyDB_PageReaderWriter> (*this, forMe->lastPage ());
 		lastPage->clear ();
@@ -36,6 +72,47 @@ MyDB_TableReaderWriter :: MyDB_TableReaderWriter (MyDB_TablePtr forMeIn, MyDB_Bu
 	}
 }
 
+void MyDB_TableReaderWriter :: migrate () {
+
+	// the directory pages of a B+-tree point at other pages by number, so the
+	// records cannot just be moved around
+	for (int i = 0; i <= forMe->lastPage (); i++) {
+		if (MyDB_PageReaderWriter (*this, i).getType () != MyDB_PageType :: RegularPage)
+			throw MyDB_PageFormatError ("Can't rewrite " + forMe->getName () + 
+				" in the current page format; it has pages that are not regular pages!!");
+	}
+
+	// copy the records out, onto pages in a region of the temp space...
+	MyDB_TempRegionPtr region = myBuffer->makeTempRegion ();
+	vector <MyDB_PageReaderWriter> copies;
+	MyDB_PageReaderWriter copy (*myBuffer, region);
+	MyDB_RecordPtr temp = getEmptyRecord ();
+	for (int i = 0; i <= forMe->lastPage (); i++) {
+		MyDB_RecordIteratorPtr myIter = MyDB_PageReaderWriter (*this, i).getIterator (temp);
+		while (myIter->hasNext ()) {
+			myIter->getNext ();
+			if (!copy.append (temp)) {
+				copies.push_back (copy);
+				copy = MyDB_PageReaderWriter (*myBuffer, region);
+				copy.append (temp);
+			}
+		}
+	}
+	copies.push_back (copy);
+
+	// ...and then write them back
+	forMe->setLastPage (0);
+	lastPage = make_shared <MyDB_PageReaderWriter> (*this, forMe->lastPage ());
+	lastPage->clear ();
+	for (MyDB_PageReaderWriter &page : copies) {
+		MyDB_RecordIteratorPtr myIter = page.getIterator (temp);
+		while (myIter->hasNext ()) {
+			myIter->getNext ();
+			append (temp);
+		}
+	}
+}
+
 MyDB_BufferManagerPtr MyDB_TableReaderWriter :: getBufferMgr () {
 	return myBuffer;
 }
@@ -48,10 +125,20 @@ int MyDB_TableReaderWriter :: getNumPages () {
 	return forMe->lastPage () + 1;
 }
 
+void MyDB_TableReaderWriter :: readAhead (int lowPage, int highPage) {
+	myBuffer->readAhead (forMe, lowPage, highPage);
+}
+
+void MyDB_TableReaderWriter :: checkWritable () {
+	if (readOnly)
+		throw MyDB_ReadOnlyError ();
+}
+
 MyDB_PageReaderWriter &MyDB_TableReaderWriter :: operator [] (size_t i) {
 	
-	// see if we are going off of the end of the file... if so, then clear those pages
-	while (i > forMe->lastPage ()) {
+	// see if we are going off of the end of the file... if so, then clear those pages;
+	// a read-only table is not extended, and the pages past its end read as empty
+	while (!readOnly && (long) i > forMe->lastPage ()) {
 		forMe->setLastPage (forMe->lastPage () + 1);
 		lastPage = make_shared <MyDB_PageReaderWriter> (*this, forMe->lastPage ());
 		lastPage->clear ();	
@@ -68,13 +155,22 @@ MyDB_RecordPtr MyDB_TableReaderWriter :: getEmptyRecord () {
 	return make_shared <MyDB_Record> (forMe->getSchema ());
 }
 
+MyDB_RecordViewPtr MyDB_TableReaderWriter :: getEmptyRecordView () {
+	return make_shared <MyDB_RecordView> (forMe->getSchema ());
+}
+
 MyDB_PageReaderWriter &MyDB_TableReaderWriter :: last () {
-	arrayAccessBuffer = make_shared <MyDB_PageReaderWriter> (*this, forMe->lastPage ());
+	arrayAccessBuffer = make_shared <MyDB_PageReaderWriter> (*this, max (forMe->lastPage (), 0));
 	return *arrayAccessBuffer;
 }
 
 void MyDB_TableReaderWriter :: append (MyDB_RecordPtr appendMe) {
 
+	checkWritable ();
+
+	// if the record goes onto a new page, the new page is logged along with it
+	MyDB_ActionGuard action (*myBuffer);
+
 	// try to append the record on the current page...
 	if (!lastPage->append (appendMe)) {
 
@@ -88,8 +184,11 @@ void MyDB_TableReaderWriter :: append (MyDB_RecordPtr appendMe) {
 
 void MyDB_TableReaderWriter :: loadFromTextFile (string fName) {
 
+	checkWritable ();
+
 	// empty out the database file
 	forMe->setLastPage (0);
+	forMe->setPageFormat (PAGE_FORMAT_VERSION);
 	lastPage = make_shared <MyDB_PageReaderWriter> (*this, forMe->lastPage ());
 	lastPage->clear ();
 
@@ -114,10 +213,27 @@ MyDB_RecordIteratorPtr MyDB_TableReaderWriter :: getIterator (MyDB_RecordPtr ite
 	return make_shared <MyDB_TableRecIterator> (*this, forMe, iterateIntoMe);
 }
 
+MyDB_RecordIteratorPtr MyDB_TableReaderWriter :: getIterator (MyDB_RecordPtr iterateIntoMe, vector <string> attNames) {
+	vector <int> whichAtts;
+	for (string &name : attNames) {
+		int which = forMe->getSchema ()->getAttByName (name).first;
+		if (which < 0) {
+			cout << "Could not find attribute " << name << "\n";
+			return nullptr;
+		}
+		whichAtts.push_back (which);
+	}
+	return make_shared <MyDB_TableRecIterator> (*this, forMe, iterateIntoMe, whichAtts);
+}
+
 MyDB_RecordIteratorAltPtr MyDB_TableReaderWriter :: getIteratorAlt () {
 	return make_shared <MyDB_TableRecIteratorAlt> (*this, forMe);
 }
 
+MyDB_RecordIteratorAltPtr MyDB_TableReaderWriter :: getIteratorAlt (vector <MyDB_AttRange> filter) {
+	return make_shared <MyDB_TableRecIteratorAlt> (*this, forMe, filter);
+}
+
 MyDB_RecordIteratorAltPtr MyDB_TableReaderWriter :: getIteratorAlt (int lowPage, int highPage) {
 	return make_shared <MyDB_TableRecIteratorAlt> (*this, forMe, lowPage, highPage);
 }
@@ -13,6 +13,7 @@
 #ifndef TABLE_REC_ITER_C
 #define TABLE_REC_ITER_C
 
+#include <algorithm>
 #include "MyDB_PageReaderWriter.h"
 #include "MyDB_TableRecIterator.h"
 
@@ -21,23 +22,35 @@ void MyDB_TableRecIterator :: getNext () {
 }
 
 bool MyDB_TableRecIterator :: hasNext () {
-	if (myParent[curPage].getType () == MyDB_PageType :: RegularPage && myIter->hasNext ())
+	if (myParent[curPage].getType () != MyDB_PageType :: DirectoryPage && myIter->hasNext ())
 		return true;
 
-	if (curPage == myTable->lastPage ())
+	if (curPage >= myTable->lastPage ())
 		return false;
 
 	curPage++;
-	myIter = myParent[curPage].getIterator (myRec);
+	readAhead ();
+	myIter = myParent[curPage].getIterator (myRec, whichAtts);
 	return hasNext ();
 }
 
+void MyDB_TableRecIterator :: readAhead () {
+	int upTo = min (curPage + (int) myParent.getBufferMgr ()->getReadAheadPages (), myTable->lastPage ());
+	if (upTo > readAheadTo) {
+		myParent.getBufferMgr ()->readAhead (myTable, max (readAheadTo + 1, curPage + 1), upTo);
+		readAheadTo = upTo;
+	}
+}
+
 MyDB_TableRecIterator :: MyDB_TableRecIterator (MyDB_TableReaderWriter &myParent, MyDB_TablePtr myTableIn,
-	MyDB_RecordPtr myRecIn) : myParent (myParent) {
+	MyDB_RecordPtr myRecIn, vector <int> whichAttsIn) : myParent (myParent) {
 	myTable = myTableIn;
 	myRec = myRecIn;
+	whichAtts = whichAttsIn;
 	curPage = 0;
-	myIter = myParent[curPage].getIterator (myRec);		
+	readAheadTo = curPage;
+	readAhead ();
+	myIter = myParent[curPage].getIterator (myRec, whichAtts);
 }
 
 MyDB_TableRecIterator :: ~MyDB_TableRecIterator () {}
@@ -13,6 +13,7 @@
 #ifndef TABLE_REC_ITER_ALT_C
 #define TABLE_REC_ITER_ALT_C
 
+#include <algorithm>
 #include "MyDB_PageReaderWriter.h"
 #include "MyDB_TableRecIteratorAlt.h"
 
@@ -22,23 +23,66 @@ void MyDB_TableRecIteratorAlt :: getCurrent (MyDB_RecordPtr intoMe) {
 
 bool MyDB_TableRecIteratorAlt :: advance () {
 
-	if (myParent[curPage].getType () == MyDB_PageType :: RegularPage && myIter->advance ())
+	if (myIter != nullptr && myParent[curPage].getType () != MyDB_PageType :: DirectoryPage && myIter->advance ())
 		return true;
 
-	if (curPage == myTable->lastPage () || curPage == highPage)
-		return false;
+	do {
+		if (curPage >= myTable->lastPage () || curPage == highPage)
+			return false;
+		curPage++;
+	} while (skip (curPage));
 
-	curPage++;
+	readAhead ();
 	myIter = myParent[curPage].getIteratorAlt ();
 	return advance ();
 }
 
+void MyDB_TableRecIteratorAlt :: readAhead () {
+	int lastPage = min (highPage, myTable->lastPage ());
+	int upTo = min (curPage + (int) myParent.getBufferMgr ()->getReadAheadPages (), lastPage);
+	if (upTo > readAheadTo) {
+
+		// the pages that are skipped are not read
+		int from = max (readAheadTo + 1, curPage + 1);
+		for (int i = from; i <= upTo; i++) {
+			if (skip (i)) {
+				if (i > from)
+					myParent.getBufferMgr ()->readAhead (myTable, from, i - 1);
+				from = i + 1;
+			}
+		}
+		if (from <= upTo)
+			myParent.getBufferMgr ()->readAhead (myTable, from, upTo);
+		readAheadTo = upTo;
+	}
+}
+
+bool MyDB_TableRecIteratorAlt :: skip (int whichPage) {
+	return zones != nullptr && !zones->mightMatch (whichPage, filter);
+}
+
+MyDB_TableRecIteratorAlt :: MyDB_TableRecIteratorAlt (MyDB_TableReaderWriter &myParent, MyDB_TablePtr myTableIn,
+	vector <MyDB_AttRange> filterIn) :
+	myParent (myParent) {
+	myTable = myTableIn;
+	filter = filterIn;
+	zones = myParent.zones;
+	curPage = 0;
+	highPage = 1999999999;
+	readAheadTo = curPage;
+	readAhead ();
+	if (!skip (curPage))
+		myIter = myParent[curPage].getIteratorAlt ();
+}
+
 MyDB_TableRecIteratorAlt :: MyDB_TableRecIteratorAlt (MyDB_TableReaderWriter &myParent, MyDB_TablePtr myTableIn,
 	int lowPage, int highPageIn) :
 	myParent (myParent) {
 	myTable = myTableIn;
 	curPage = lowPage;
 	highPage = highPageIn;
+	readAheadTo = curPage;
+	readAhead ();
 	myIter = myParent[curPage].getIteratorAlt ();		
 }
 
@@ -47,6 +91,8 @@ MyDB_TableRecIteratorAlt :: MyDB_TableRecIteratorAlt (MyDB_TableReaderWriter &my
 	myTable = myTableIn;
 	curPage = 0;
 	highPage = 1999999999;
+	readAheadTo = curPage;
+	readAhead ();
 	myIter = myParent[curPage].getIteratorAlt ();		
 }
 
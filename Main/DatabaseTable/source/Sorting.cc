@@ -2,7 +2,12 @@
 #ifndef SORT_C
 #define SORT_C
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
 #include <queue>
+#include <thread>
 #include "MyDB_PageReaderWriter.h"
 #include "MyDB_TableRecIterator.h"
 #include "MyDB_TableRecIteratorAlt.h"
@@ -13,16 +18,99 @@
 using namespace std;
 
 void mergeIntoFile (MyDB_TableReaderWriter &sortIntoMe, vector <MyDB_RecordIteratorAltPtr> &mergeUs, 
-	function <bool ()> comparator, MyDB_RecordPtr lhs, MyDB_RecordPtr rhs) {
+	function <bool ()> comparator, MyDB_RecordPtr lhs, MyDB_RecordPtr rhs, MyDB_SortKeyPtr key) {
 
-	// create the comparator and the priority queue
+	// the record at the head of each run is kept in the binary format, so that it is only
+	// taken out of its run once, and then viewed (which is cheap) for each comparison
+	size_t numRuns = mergeUs.size ();
+	if (numRuns == 0)
+		return;
+	// (along with its key, if there is one)
+	vector <vector <char>> heads (numRuns);
+	vector <uint64_t> keys (numRuns, 0);
+	vector <bool> done (numRuns, false);
+	bool exact = key != nullptr && key->isExact ();
+	auto loadHead = [&] (size_t which) {
+		if (!mergeUs[which]->advance ()) {
+			done[which] = true;
+			return;
+		}
+		mergeUs[which]->getCurrent (lhs);
+		heads[which].resize (lhs->getBinarySize ());
+		lhs->toBinary (heads[which].data ());
+		if (key != nullptr)
+			keys[which] = key->getKey ();
+	};
+
+	// true if the head of run a comes before the head of run b; a run that is done comes
+	// after everyone.  The records are only compared if their keys do not decide it
+	auto before = [&] (size_t a, size_t b) {
+		if (done[a])
+			return false;
+		if (done[b])
+			return true;
+		if (keys[a] != keys[b] || exact)
+			return keys[a] < keys[b];
+		lhs->view (heads[a].data ());
+		rhs->view (heads[b].data ());
+		return comparator ();
+	};
+
+	// the loser tree: run i is the leaf numRuns + i, the children of node n are 2n and
+	// 2n + 1, and each of the nodes 1 through numRuns - 1 has the run that lost the match
+	// played there.  So the runs that the winner has to play again, once its head is
+	// replaced, are the ones on the path from its leaf to the root
+	vector <size_t> losers (numRuns);
+	vector <size_t> winners (2 * numRuns);
+	for (size_t i = 0; i < numRuns; i++) {
+		loadHead (i);
+		winners[numRuns + i] = i;
+	}
+	for (size_t node = numRuns - 1; node >= 1; node--) {
+		size_t left = winners[2 * node], right = winners[2 * node + 1];
+		bool leftWins = before (left, right);
+		winners[node] = leftWins ? left : right;
+		losers[node] = leftWins ? right : left;
+	}
+	size_t winner = winners[1];
+
+	// and write everyone out
+	while (!done[winner]) {
+
+		// write the dude to the output
+		lhs->fromBinary (heads[winner].data ());
+		sortIntoMe.append (lhs);
+
+		// get the next one from its run, and play it up the tree
+		loadHead (winner);
+		for (size_t node = (numRuns + winner) / 2; node >= 1; node /= 2) {
+			if (before (losers[node], winner))
+				swap (losers[node], winner);
+		}
+	}
+}
+
+void mergeIntoFileWithHeap (MyDB_TableReaderWriter &sortIntoMe, vector <MyDB_RecordIteratorAltPtr> &mergeUs, 
+	function <bool ()> comparator, MyDB_RecordPtr lhs, MyDB_RecordPtr rhs, MyDB_SortKeyPtr key) {
+
+	// create the comparator and the priority queue; each iterator is paired with the key
+	// of its current record (or 0 if there is no key, so that the records always decide)
+	typedef pair <uint64_t, MyDB_RecordIteratorAltPtr> KeyedIter;
 	IteratorComparator temp (comparator, lhs, rhs);
-	priority_queue <MyDB_RecordIteratorAltPtr, vector <MyDB_RecordIteratorAltPtr>, IteratorComparator> pq (temp);
+	priority_queue <KeyedIter, vector <KeyedIter>, IteratorComparator> pq (temp);
+	auto push = [&] (MyDB_RecordIteratorAltPtr m) {
+		uint64_t myKey = 0;
+		if (key != nullptr) {
+			m->getCurrent (lhs);
+			myKey = key->getKey ();
+		}
+		pq.push (make_pair (myKey, m));
+	};
 
 	// load up the set
 	for (MyDB_RecordIteratorAltPtr m : mergeUs) {
 		if (m->advance ()) {
-			pq.push (m);
+			push (m);
 		}
 	}
 
@@ -31,7 +119,7 @@ void mergeIntoFile (MyDB_TableReaderWriter &sortIntoMe, vector <MyDB_RecordItera
 	while (pq.size () != 0) {
 
 		// write the dude to the output
-		auto myIter = pq.top ();
+		auto myIter = pq.top ().second;
 		myIter->getCurrent (lhs);
 		sortIntoMe.append (lhs);
 		counter++;
@@ -41,20 +129,20 @@ void mergeIntoFile (MyDB_TableReaderWriter &sortIntoMe, vector <MyDB_RecordItera
 
 		// re-insert
 		if (myIter->advance ()) {
-			pq.push (myIter);
+			push (myIter);
 		}
 	}
 }
 
 void appendRecord (MyDB_PageReaderWriter &curPage, vector <MyDB_PageReaderWriter> &returnVal, 
-	MyDB_RecordPtr appendMe, MyDB_BufferManagerPtr parent) {
+	MyDB_RecordPtr appendMe, MyDB_BufferManagerPtr parent, MyDB_TempRegionPtr region) {
 
 	// try to append to the current page
 	if (!curPage.append (appendMe)) {
 
 		// if we cannot, then add a new one to the output vector
 		returnVal.push_back (curPage);
-		MyDB_PageReaderWriter temp (*parent);
+		MyDB_PageReaderWriter temp (*parent, region);
 		temp.append (appendMe);
 		curPage = temp;
 	}
@@ -63,20 +151,23 @@ void appendRecord (MyDB_PageReaderWriter &curPage, vector <MyDB_PageReaderWriter
 vector <MyDB_PageReaderWriter> mergeIntoList (MyDB_BufferManagerPtr parent, MyDB_RecordIteratorAltPtr leftIter, 
 	MyDB_RecordIteratorAltPtr rightIter, function <bool ()> comparator, MyDB_RecordPtr lhs, MyDB_RecordPtr rhs) {
 	
+	// the merged run gets a region of the temp space to itself, so that it is laid
+	// out sequentially on disk, no matter what else is spilling at the same time
+	MyDB_TempRegionPtr region = parent->makeTempRegion ();
 	vector <MyDB_PageReaderWriter> returnVal;
-	MyDB_PageReaderWriter curPage (*parent);
+	MyDB_PageReaderWriter curPage (*parent, region);
 	bool lhsLoaded = false, rhsLoaded = false;
 
 	// if one of the runs is empty, get outta here
 	if (!leftIter->advance ()) {
 		while (rightIter->advance ()) {
 			rightIter->getCurrent (rhs);
-			appendRecord (curPage, returnVal, rhs, parent);
+			appendRecord (curPage, returnVal, rhs, parent, region);
 		}
 	} else if (!rightIter->advance ()) {
 		while (leftIter->advance ()) {
 			leftIter->getCurrent (lhs);
-			appendRecord (curPage, returnVal, lhs, parent);
+			appendRecord (curPage, returnVal, lhs, parent, region);
 		}
 	} else {
 		while (true) {
@@ -96,28 +187,28 @@ vector <MyDB_PageReaderWriter> mergeIntoList (MyDB_BufferManagerPtr parent, MyDB
 	
 			// see if the lhs is less
 			if (comparator ()) {
-				appendRecord (curPage, returnVal, lhs, parent);
+				appendRecord (curPage, returnVal, lhs, parent, region);
 				lhsLoaded = false;
 
 				// deal with the case where we have to append all of the right records to the output
 				if (!leftIter->advance ()) {
-					appendRecord (curPage, returnVal, rhs, parent);
+					appendRecord (curPage, returnVal, rhs, parent, region);
 					while (rightIter->advance ()) {
 						rightIter->getCurrent (rhs);
-						appendRecord (curPage, returnVal, rhs, parent);
+						appendRecord (curPage, returnVal, rhs, parent, region);
 					}
 					break;
 				}
 			} else {
-				appendRecord (curPage, returnVal, rhs, parent);
+				appendRecord (curPage, returnVal, rhs, parent, region);
 				rhsLoaded = false;
 
 				// deal with the ase where we have to append all of the right records to the output
 				if (!rightIter->advance ()) {
-					appendRecord (curPage, returnVal, lhs, parent);
+					appendRecord (curPage, returnVal, lhs, parent, region);
 					while (leftIter->advance ()) {
 						leftIter->getCurrent (lhs);
-						appendRecord (curPage, returnVal, lhs, parent);
+						appendRecord (curPage, returnVal, lhs, parent, region);
 					}
 					break;
 				}
@@ -132,72 +223,174 @@ vector <MyDB_PageReaderWriter> mergeIntoList (MyDB_BufferManagerPtr parent, MyDB
 	return returnVal;
 }
 	
-void sort (int runSize, MyDB_TableReaderWriter &sortMe, MyDB_TableReaderWriter &sortIntoMe, 
-	function <bool ()> comparator, MyDB_RecordPtr lhs, MyDB_RecordPtr rhs) {
+// sorts the records on pages low through high of sortMe into a single run, made of anonymous
+// pages in a region of the temp space of its own, which is returned.  The pages are all pinned
+// at once, so that the records can be sorted where they are, in one go, and then written out
+// once, through one more pinned page; so a run can have no more pages than fit in the unpinned
+// part of the buffer, less one
+static vector <MyDB_PageReaderWriter> makeRun (MyDB_TableReaderWriter &sortMe, int low, int high,
+	function <bool ()> comparator, MyDB_RecordPtr lhs, MyDB_RecordPtr rhs, MyDB_SortKeyPtr key) {
+
+	// find all of the records; the rows copied off of the pages that need it are kept
+	// in a list per page, so that they don't move as more are added
+	vector <MyDB_PageReaderWriter> pages;
+	vector <vector <char>> rows (high - low + 1);
+	vector <void *> positions;
+	for (int i = low; i <= high; i++) {
+		pages.push_back (MyDB_PageReaderWriter (sortMe, i, true));
+		pages.back ().getPositions (lhs, rows[i - low], positions);
+	}
 
-	// this is the list of all of the pages in the file
-	vector <vector<MyDB_PageReaderWriter>> allPages;
+	// sort them
+	MyDB_PageReaderWriter :: sortPositions (positions, false, comparator, lhs, rhs, key);
 
-	// this is the pages making up the current run
-	vector <vector<MyDB_PageReaderWriter>> pagesToSort;
+	// and write them out.  Other threads may be making runs at the same time, and
+	// they can kick out any page that is not pinned, even while we are writing to
+	// it; so the page that is being filled stays pinned until it is full
+	MyDB_BufferManagerPtr parent = sortMe.getBufferMgr ();
+	MyDB_TempRegionPtr region = parent->makeTempRegion ();
+	vector <MyDB_PageReaderWriter> returnVal;
+	MyDB_PageReaderWriter curPage (*parent, region, true);
+	for (void *pos : positions) {
+		lhs->fromBinary (pos);
+		if (!curPage.append (lhs)) {
+			curPage.unpin ();
+			returnVal.push_back (curPage);
+			curPage = MyDB_PageReaderWriter (*parent, region, true);
+			curPage.append (lhs);
+		}
+	}
+	curPage.unpin ();
+	returnVal.push_back (curPage);
+	return returnVal;
+}
+
+// like makeRun, except that if the buffer fills up with pinned pages while the run is
+// being made, it is thrown away, and the two halves are made as runs of their own (and
+// so on); there is not much we can do if a run of one page does not fit
+static void makeRuns (MyDB_TableReaderWriter &sortMe, int low, int high, vector <vector <MyDB_PageReaderWriter>> &runs,
+	function <bool ()> comparator, MyDB_RecordPtr lhs, MyDB_RecordPtr rhs, MyDB_SortKeyPtr key) {
+
+	try {
+		runs.push_back (makeRun (sortMe, low, high, comparator, lhs, rhs, key));
+	} catch (MyDB_BufferFullError &e) {
+		if (low == high)
+			throw;
+		int mid = low + (high - low) / 2;
+		makeRuns (sortMe, low, mid, runs, comparator, lhs, rhs, key);
+		makeRuns (sortMe, mid + 1, high, runs, comparator, lhs, rhs, key);
+	}
+}
+	
+void sort (int runSize, MyDB_TableReaderWriter &sortMe, MyDB_TableReaderWriter &sortIntoMe, 
+	function <bool ()> comparator, MyDB_RecordPtr lhs, MyDB_RecordPtr rhs, MyDB_SortKeyPtr key) {
 
 	// this is the list of all of the iterators, with one for each run
 	vector <MyDB_RecordIteratorAltPtr> runIters;
 	
-	int mySize = 0;
+	// process the file a run at a time
+	int numPages = sortMe.getNumPages ();
+	for (int runStart = 0; runStart < numPages; ) {
 
-	// process the file 
-	for (int i = 0; i < sortMe.getNumPages (); i++) {
+		// a run has to fit in the part of the buffer that other people have not pinned,
+		// along with the page that it is written out through
+		int numFree = sortMe.getBufferMgr ()->getNumUnpinnedFrames ();
+		if (runSize > numFree - 1)
+			runSize = max (numFree - 1, 1);
+		int runEnd = min (runStart + runSize, numPages) - 1;
 
-		// add this next page
-		vector <MyDB_PageReaderWriter> run;
-		run.push_back (*(sortMe[i].sort (comparator, lhs, rhs)));
-		pagesToSort.push_back (run);
+		// if the buffer fills up with pinned pages while we are working on this run, throw
+		// it away, and start it over at half the size; there is not much we can do if a
+		// run of one page does not fit
+		try {
+			vector <MyDB_PageReaderWriter> run = makeRun (sortMe, runStart, runEnd, comparator, lhs, rhs, key);
+			runIters.push_back (getIteratorAlt (run));
+			runStart = runEnd + 1;
+		} catch (MyDB_BufferFullError &e) {
+			if (runSize == 1)
+				throw;
+			runSize /= 2;
+		}
+	}
+	
+	// and now, we are ready to merge everything
+	mergeIntoFile (sortIntoMe, runIters, comparator, lhs, rhs, key);
+}
 
-		// if we are not done reading this run, go on to the next one
-		if (pagesToSort.size () != runSize && i != sortMe.getNumPages () - 1)
-			continue;
+void sort (int runSize, int numThreads, MyDB_TableReaderWriter &sortMe, MyDB_TableReaderWriter &sortIntoMe,
+	string orderBy) {
 
-		// while we don't have a single sorted list
-		while (pagesToSort.size () > 1) {
-			
-			// the new version of the pages to sort vector
-			vector <vector<MyDB_PageReaderWriter>> newPagesToSort;
-	
-			// repeatedly merge the last two pages
-			while (pagesToSort.size () > 0) {
-	
-				// if there is one run, then just add it
-				if (pagesToSort.size () == 1) {
-					newPagesToSort.push_back (pagesToSort.back ());
-					pagesToSort.pop_back ();
-					continue;
-				}
-	
-				// get the next two runs
-				vector<MyDB_PageReaderWriter> runOne = pagesToSort.back ();
-				pagesToSort.pop_back ();
-				vector<MyDB_PageReaderWriter> runTwo = pagesToSort.back ();
-				pagesToSort.pop_back ();
-		
-				// merge them
-				newPagesToSort.push_back (mergeIntoList (sortMe.getBufferMgr (), getIteratorAlt (runOne), 
-					getIteratorAlt (runTwo), comparator, lhs, rhs));
+	// every worker has a run's worth of pages in the buffer at once, plus the page
+	// that it is writing the run out through, so together they have to fit in the
+	// part of the buffer that other people have not pinned
+	numThreads = max (numThreads, 1);
+	int numFree = sortMe.getBufferMgr ()->getNumUnpinnedFrames ();
+	runSize = max (min (runSize, (numFree - numThreads) / numThreads), 1);
+
+	// cut the file up into runs
+	int numPages = sortMe.getNumPages ();
+	vector <pair <int, int>> runBounds;
+	for (int low = 0; low < numPages; low += runSize)
+		runBounds.push_back (make_pair (low, min (low + runSize, numPages) - 1));
+
+	// the sorted runs made out of each range of pages (there is more than one if the
+	// range did not fit in the buffer)
+	vector <vector <vector <MyDB_PageReaderWriter>>> runs (runBounds.size ());
+
+	// the workers take the ranges in order.  Before one starts on a range, it asks for the
+	// range that will be taken after the ones the other workers are on to be read in the
+	// background, so that the reading is done while the workers are sorting
+	atomic <size_t> nextRun (0);
+	mutex errorLatch;
+	exception_ptr error;
+	auto work = [&] () {
+
+		// the comparator writes into the records it is built on, so each worker needs its own
+		MyDB_RecordPtr lhs = sortMe.getEmptyRecord ();
+		MyDB_RecordPtr rhs = sortMe.getEmptyRecord ();
+		function <bool ()> comparator = buildRecordComparator (lhs, rhs, orderBy);
+		MyDB_SortKeyPtr key = make_shared <MyDB_SortKey> (lhs, orderBy);
+
+		for (size_t which = nextRun++; which < runBounds.size (); which = nextRun++) {
+			size_t ahead = which + numThreads;
+			if (ahead < runBounds.size ())
+				sortMe.readAhead (runBounds[ahead].first, runBounds[ahead].second);
+			try {
+				makeRuns (sortMe, runBounds[which].first, runBounds[which].second, runs[which], 
+					comparator, lhs, rhs, key);
+
+			// if a worker cannot go on, then no one does, and the error goes to the caller
+			} catch (...) {
+				lock_guard <mutex> lock (errorLatch);
+				if (error == nullptr)
+					error = current_exception ();
+				nextRun = runBounds.size ();
+				return;
 			}
-	
-			pagesToSort = newPagesToSort;
 		}
+	};
 
-		// now we have a single list, so create an iterator for it
-		mySize += pagesToSort[0].size ();
-		runIters.push_back (getIteratorAlt (pagesToSort[0]));
+	// get the first round of ranges coming in, and start everyone up
+	for (size_t i = 0; i < runBounds.size () && i < (size_t) numThreads; i++)
+		sortMe.readAhead (runBounds[i].first, runBounds[i].second);
+	vector <thread> workers;
+	for (int i = 1; i < numThreads; i++)
+		workers.push_back (thread (work));
+	work ();
+	for (thread &t : workers)
+		t.join ();
+	if (error != nullptr)
+		rethrow_exception (error);
 
-		// and start over on the next run
-		pagesToSort.clear ();
-	}
-	
 	// and now, we are ready to merge everything
-	mergeIntoFile (sortIntoMe, runIters, comparator, lhs, rhs);
+	vector <MyDB_RecordIteratorAltPtr> runIters;
+	for (auto &range : runs)
+		for (auto &run : range)
+			runIters.push_back (getIteratorAlt (run));
+	MyDB_RecordPtr lhs = sortMe.getEmptyRecord ();
+	MyDB_RecordPtr rhs = sortMe.getEmptyRecord ();
+	function <bool ()> comparator = buildRecordComparator (lhs, rhs, orderBy);
+	mergeIntoFile (sortIntoMe, runIters, comparator, lhs, rhs, make_shared <MyDB_SortKey> (lhs, orderBy));
 }
 
 #endif
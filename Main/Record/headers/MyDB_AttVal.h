@@ -23,6 +23,18 @@ public:
 	virtual void *toBinary (void *toHere) = 0;
 	virtual size_t getBinarySize () = 0;
 	virtual ~MyDB_AttVal ();
+
+	// like fromBinary, except that the value may point at the bytes instead of
+	// copying them, in which case it is only good for as long as the bytes are;
+	// values that are cheap to read (ints, doubles, bools) just read them
+	virtual void *viewBinary (void *fromHere);
+
+	// the same as fromBinary, toBinary and getBinarySize, but for the legacy
+	// binary format, where strings are null-terminated rather than prefixed
+	// with their length; the other types are the same in both
+	virtual void *fromLegacyBinary (void *fromHere);
+	virtual void *toLegacyBinary (void *toHere);
+	virtual size_t getLegacyBinarySize ();
 	
 };
 
@@ -87,15 +99,29 @@ public:
 	bool toBool () override;
 	void fromString (string &fromMe) override;
 	void *fromBinary (void *fromHere) override;
+	void *viewBinary (void *fromHere) override;
 	void *toBinary (void *toHere) override;
 	size_t getBinarySize () override;
+	void *fromLegacyBinary (void *fromHere) override;
+	void *toLegacyBinary (void *toHere) override;
+	size_t getLegacyBinarySize () override;
 	void set (string val);
 	MyDB_StringAttVal ();
 	~MyDB_StringAttVal ();
 
+	// the characters of the string, without making a copy; they are not
+	// null-terminated, so there are getLength () of them
+	const char *getChars ();
+	size_t getLength ();
+
 private:
 
 	string value;
+
+	// if not null, the value is the viewLen characters here (put there by
+	// viewBinary), rather than what is in value
+	const char *view;
+	size_t viewLen;
 };
 
 class MyDB_BoolAttVal;
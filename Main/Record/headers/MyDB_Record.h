@@ -49,7 +49,23 @@ public:
 	// 	loc = myRec.fromBinary (loc);
 	// }
 	// 	
-	void *fromBinary (void *startPos);
+	virtual void *fromBinary (void *startPos);
+
+	// like fromBinary, except that the record becomes a view of the bytes: ints
+	// and doubles are read, but strings are not copied, they point right at the
+	// bytes.  So the record is only good for as long as the bytes stay where
+	// they are; for a record on a page, that is as long as the page is pinned,
+	// or until the buffer manager is asked for another page.  Loading the record
+	// in any other way (or setting an attribute) replaces the view
+	void *view (void *startPos);
+
+	// the same as getBinarySize, toBinary and fromBinary, but for the legacy
+	// binary format, where strings are null-terminated rather than prefixed with
+	// their length; this is how pages written before the length prefixes (see
+	// MyDB_PageReaderWriter) hold their records
+	size_t getLegacyBinarySize ();
+	void *toLegacyBinary (void *toHere);
+	void *fromLegacyBinary (void *startPos);
 
 	// parse the contents of this record from the given string
 	void fromString (string fromMe);
@@ -131,6 +147,9 @@ private:
 	// this is a subtype
 	friend class MyDB_INRecord;
 
+	// compiles computations, and needs to know their types
+	friend class MyDB_SortKey;
+
 	MyDB_SchemaPtr mySchema;
 	vector <MyDB_AttValPtr> values;	
 	vector <MyDB_AttValPtr> scratch;
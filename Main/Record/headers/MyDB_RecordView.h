@@ -0,0 +1,26 @@
+
+#ifndef RECORD_VIEW_H
+#define RECORD_VIEW_H
+
+#include "MyDB_Record.h"
+
+// create a smart pointer for record views
+class MyDB_RecordView;
+typedef shared_ptr <MyDB_RecordView> MyDB_RecordViewPtr;
+
+// a record that is always a view (see MyDB_Record.view ()) of the bytes that it
+// is loaded from, rather than a copy.  It can be handed to anything that loads
+// records using fromBinary, such as the page and table iterators; the record is
+// then only good until the iterator moves on, or until some other page is used
+class MyDB_RecordView : public MyDB_Record  {
+
+public:
+
+	MyDB_RecordView (MyDB_SchemaPtr mySchema) : MyDB_Record (mySchema) {}
+
+	void *fromBinary (void *startPos) override {
+		return view (startPos);
+	}
+};
+
+#endif
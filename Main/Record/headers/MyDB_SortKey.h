@@ -0,0 +1,58 @@
+
+#ifndef SORT_KEY_H
+#define SORT_KEY_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "MyDB_Record.h"
+
+using namespace std;
+
+// create a smart pointer for sort keys
+class MyDB_SortKey;
+typedef shared_ptr <MyDB_SortKey> MyDB_SortKeyPtr;
+
+// A normalized sort key for a computation over a record: the first eight bytes
+// of a form of the computation's value that sorts byte by byte the same way as
+// the values do, packed into a number (the first byte is the high one), so that
+// comparing two keys is a single compare.  Ints have their sign bit flipped,
+// doubles have their sign bit flipped if they are positive and all of their
+// bits if they are negative, and strings (and anything else that is compared as
+// a string) are cut off, or padded with zeros, to eight bytes.
+//
+// If the key of one record is less than the key of another, the first record
+// comes before the second in the order given by buildRecordComparator for the
+// same computation.  Records with the same key may still be different, so ties
+// have to be broken with the comparator, unless isExact () says otherwise
+class MyDB_SortKey {
+
+public:
+
+	// builds a key for the computation (encoded as for compileComputation) over
+	// the given record
+	MyDB_SortKey (MyDB_RecordPtr overMe, string computation);
+
+	// returns the key of whatever is loaded into the record
+	uint64_t getKey ();
+
+	// true if two records with the same key are always the same as far as the
+	// computation is concerned, which is the case for ints and doubles
+	bool isExact ();
+
+	// sorts records paired with their keys on the keys alone, with an LSD radix
+	// sort, a byte at a time; records with the same key stay in the same order.
+	// This is only the order of the comparator if the keys are exact
+	static void radixSort (vector <pair <uint64_t, void *>> &sortMe);
+
+private:
+
+	enum KeyType {IntKey, DoubleKey, StringKey};
+
+	func computation;
+	KeyType type;
+};
+
+#endif
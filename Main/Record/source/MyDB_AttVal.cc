@@ -11,6 +11,52 @@ using namespace std;
 
 MyDB_AttVal :: ~MyDB_AttVal () {}
 
+void *MyDB_AttVal :: viewBinary (void *fromHere) {
+	return fromBinary (fromHere);
+}
+
+void *MyDB_AttVal :: fromLegacyBinary (void *fromHere) {
+	return fromBinary (fromHere);
+}
+
+void *MyDB_AttVal :: toLegacyBinary (void *toHere) {
+	return toBinary (toHere);
+}
+
+size_t MyDB_AttVal :: getLegacyBinarySize () {
+	return getBinarySize ();
+}
+
+// strings are written as their length, seven bits per byte with the high bit
+// set on every byte but the last, followed by the characters
+static size_t lengthSize (size_t len) {
+	size_t returnVal = 1;
+	while (len >= 0x80) {
+		len >>= 7;
+		returnVal++;
+	}
+	return returnVal;
+}
+
+static char *writeLength (char *toHere, size_t len) {
+	while (len >= 0x80) {
+		*(toHere++) = (char) (len | 0x80);
+		len >>= 7;
+	}
+	*(toHere++) = (char) len;
+	return toHere;
+}
+
+static char *readLength (char *fromHere, size_t &len) {
+	len = 0;
+	for (int shift = 0; ; shift += 7) {
+		unsigned char next = *(fromHere++);
+		len |= ((size_t) (next & 0x7f)) << shift;
+		if (next < 0x80)
+			return fromHere;
+	}
+}
+
 int MyDB_IntAttVal :: toInt () {
 	return value;
 }
@@ -109,6 +155,7 @@ int MyDB_StringAttVal :: toInt () {
 
 void MyDB_StringAttVal :: fromString (string &fromMe) {
         value = fromMe;
+        view = nullptr;
 }
 
 double MyDB_StringAttVal :: toDouble () {
@@ -117,35 +164,80 @@ double MyDB_StringAttVal :: toDouble () {
 }
 
 string MyDB_StringAttVal :: toString () {
+        if (view != nullptr)
+                return string (view, viewLen);
         return value;
 }
 
+const char *MyDB_StringAttVal :: getChars () {
+        if (view != nullptr)
+                return view;
+        return value.data ();
+}
+
+size_t MyDB_StringAttVal :: getLength () {
+        if (view != nullptr)
+                return viewLen;
+        return value.size ();
+}
+
 bool MyDB_StringAttVal :: toBool () {
         cout << "Oops!  Can't convert int to bool";
         exit (1);
 }
 
 void *MyDB_StringAttVal :: fromBinary (void *fromHere) {
+        size_t len;
+        char *chars = readLength ((char *) fromHere, len);
+        value.assign (chars, len);
+        view = nullptr;
+        return chars + len;
+}
+
+void *MyDB_StringAttVal :: viewBinary (void *fromHere) {
+        view = readLength ((char *) fromHere, viewLen);
+        return ((char *) view) + viewLen;
+}
+
+void *MyDB_StringAttVal :: toBinary (void* toHere) {
+        size_t len = getLength ();
+        char *chars = writeLength ((char *) toHere, len);
+        memcpy (chars, getChars (), len);
+        return chars + len;
+}
+
+void *MyDB_StringAttVal :: fromLegacyBinary (void *fromHere) {
         string temp ((char *) fromHere);
         value = temp;
+        view = nullptr;
         return ((char *) fromHere) + strlen ((char *) fromHere) + 1;
 }
 
-void *MyDB_StringAttVal :: toBinary (void* toHere) {
-        memcpy ((char *) toHere, value.c_str (), strlen (value.c_str ()) + 1);
-        return ((char *) toHere) + strlen (value.c_str ()) + 1;
+void *MyDB_StringAttVal :: toLegacyBinary (void* toHere) {
+        size_t len = getLength ();
+        memcpy ((char *) toHere, getChars (), len);
+        ((char *) toHere)[len] = 0;
+        return ((char *) toHere) + len + 1;
+}
+
+size_t MyDB_StringAttVal :: getLegacyBinarySize () {
+        return getLength () + 1;
 }
 
 void MyDB_StringAttVal :: set (string val) {
         value = val;
+        view = nullptr;
 }
 
 MyDB_StringAttVal :: MyDB_StringAttVal () {
         value = "";
+        view = nullptr;
+        viewLen = 0;
 }
 
 size_t MyDB_StringAttVal :: getBinarySize () {
-        return strlen (value.c_str ()) + 1;
+        size_t len = getLength ();
+        return lengthSize (len) + len;
 }
 
 int MyDB_BoolAttVal :: toInt () {
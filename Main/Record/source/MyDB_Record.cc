@@ -2,6 +2,7 @@
 #ifndef RECORD_CC
 #define RECORD_CC
 
+#include <algorithm>
 #include "MyDB_Record.h"
 #include "MyDB_Schema.h"
 #include <iostream>
@@ -366,7 +367,7 @@ pair <func, MyDB_AttTypePtr> MyDB_Record :: compileHelper(char * &vals) {
 			for (; vals[cnt] != ']'; cnt++);
 
 			// copy the string over
-			char name[cnt];
+			char name[cnt + 1];
 			for (cnt = 0; vals[cnt] != ']'; cnt++) {
 				name[cnt] = vals[cnt];
 			}	
@@ -535,6 +536,23 @@ pair <func, MyDB_AttTypePtr> MyDB_Record :: divide (pair <func, MyDB_AttTypePtr>
 	}
 }
 
+// true if both sides really are strings (and not, say, ints promoted to
+// strings), in which case they can be compared without copying them
+static bool bothStrings (pair <func, MyDB_AttTypePtr> &lhs, pair <func, MyDB_AttTypePtr> &rhs) {
+	return dynamic_pointer_cast <MyDB_StringAttType> (lhs.second) != nullptr &&
+		dynamic_pointer_cast <MyDB_StringAttType> (rhs.second) != nullptr;
+}
+
+static int compareStrings (MyDB_AttValPtr lhsIn, MyDB_AttValPtr rhsIn) {
+	MyDB_StringAttVal *lhs = (MyDB_StringAttVal *) lhsIn.get ();
+	MyDB_StringAttVal *rhs = (MyDB_StringAttVal *) rhsIn.get ();
+	size_t lhsLen = lhs->getLength (), rhsLen = rhs->getLength ();
+	int res = memcmp (lhs->getChars (), rhs->getChars (), min (lhsLen, rhsLen));
+	if (res != 0)
+		return res;
+	return (lhsLen > rhsLen) - (lhsLen < rhsLen);
+}
+
 pair <func, MyDB_AttTypePtr> MyDB_Record :: gt (pair <func, MyDB_AttTypePtr> lhs, pair <func, MyDB_AttTypePtr> rhs) {
 
 	// if both sides can be cast upwards to be ints, then do so
@@ -560,6 +578,11 @@ pair <func, MyDB_AttTypePtr> MyDB_Record :: gt (pair <func, MyDB_AttTypePtr> lhs
 		MyDB_BoolAttValPtr temp = make_shared <MyDB_BoolAttVal> ();
 		scratch.push_back (temp);
 
+		// strings are compared right where they are
+		if (bothStrings (lhs, rhs))
+			return make_pair ([temp, lhs, rhs] {temp->set (compareStrings (lhs.first (), rhs.first ()) > 0); return temp;},
+				make_shared <MyDB_BoolAttType> ());
+
 		// returns a lambda that computes the result
 		return make_pair ([temp, lhs, rhs] {temp->set (lhs.first ()->toString () > rhs.first ()->toString ()); return temp;},
 			make_shared <MyDB_BoolAttType> ());
@@ -595,6 +618,11 @@ pair <func, MyDB_AttTypePtr> MyDB_Record :: lt (pair <func, MyDB_AttTypePtr> lhs
 		MyDB_BoolAttValPtr temp = make_shared <MyDB_BoolAttVal> ();
 		scratch.push_back (temp);
 
+		// strings are compared right where they are
+		if (bothStrings (lhs, rhs))
+			return make_pair ([temp, lhs, rhs] {temp->set (compareStrings (lhs.first (), rhs.first ()) < 0); return temp;},
+				make_shared <MyDB_BoolAttType> ());
+
 		// returns a lambda that computes the result
 		return make_pair ([temp, lhs, rhs] {temp->set (lhs.first ()->toString () < rhs.first ()->toString ()); return temp;},
 			make_shared <MyDB_BoolAttType> ());
@@ -638,6 +666,11 @@ pair <func, MyDB_AttTypePtr> MyDB_Record :: eq (pair <func, MyDB_AttTypePtr> lhs
 		MyDB_BoolAttValPtr temp = make_shared <MyDB_BoolAttVal> ();
 		scratch.push_back (temp);
 
+		// strings are compared right where they are
+		if (bothStrings (lhs, rhs))
+			return make_pair ([temp, lhs, rhs] {temp->set (compareStrings (lhs.first (), rhs.first ()) == 0); return temp;},
+				make_shared <MyDB_BoolAttType> ());
+
 		// returns a lambda that computes the result
 		return make_pair ([temp, lhs, rhs] {temp->set (lhs.first ()->toString () == rhs.first ()->toString ()); return temp;},
 			make_shared <MyDB_BoolAttType> ());
@@ -681,6 +714,11 @@ pair <func, MyDB_AttTypePtr> MyDB_Record :: neq (pair <func, MyDB_AttTypePtr> lh
 		MyDB_BoolAttValPtr temp = make_shared <MyDB_BoolAttVal> ();
 		scratch.push_back (temp);
 
+		// strings are compared right where they are
+		if (bothStrings (lhs, rhs))
+			return make_pair ([temp, lhs, rhs] {temp->set (compareStrings (lhs.first (), rhs.first ()) != 0); return temp;},
+				make_shared <MyDB_BoolAttType> ());
+
 		// returns a lambda that computes the result
 		return make_pair ([temp, lhs, rhs] {temp->set (lhs.first ()->toString () != rhs.first ()->toString ()); return temp;},
 			make_shared <MyDB_BoolAttType> ());
@@ -765,6 +803,35 @@ void *MyDB_Record :: fromBinary (void *fromHere) {
 	return fromHere;
 }
 
+void *MyDB_Record :: view (void *fromHere) {
+	for (MyDB_AttValPtr &temp : values) {
+		fromHere = temp->viewBinary (fromHere);
+	}		
+	return fromHere;
+}
+
+size_t MyDB_Record :: getLegacyBinarySize () {
+	size_t total = 0;
+	for (MyDB_AttValPtr &temp : values) {
+		total += temp->getLegacyBinarySize ();
+	}	
+	return total;
+}
+
+void *MyDB_Record :: toLegacyBinary (void *toHere) {
+	for (MyDB_AttValPtr &temp : values) {
+		toHere = temp->toLegacyBinary (toHere);
+	}		
+	return toHere;
+}
+
+void *MyDB_Record :: fromLegacyBinary (void *fromHere) {
+	for (MyDB_AttValPtr &temp : values) {
+		fromHere = temp->fromLegacyBinary (fromHere);
+	}		
+	return fromHere;
+}
+
 void MyDB_Record :: fromString (string res) {	
 	int i = 0;
         for (int pos = 0; pos < (int) res.size (); pos = (int) res.find ("|", pos + 1) + 1) {
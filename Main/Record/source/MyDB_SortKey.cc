@@ -0,0 +1,99 @@
+
+#ifndef SORT_KEY_C
+#define SORT_KEY_C
+
+#include <cstring>
+#include "MyDB_SortKey.h"
+
+MyDB_SortKey :: MyDB_SortKey (MyDB_RecordPtr overMe, string computationIn) {
+
+	// the key is made the same way that the values are compared by the comparator
+	char *str = (char *) computationIn.c_str ();
+	pair <func, MyDB_AttTypePtr> res = overMe->compileHelper (str);
+	computation = res.first;
+	if (res.second->promotableToInt ())
+		type = IntKey;
+	else if (res.second->promotableToDouble ())
+		type = DoubleKey;
+	else
+		type = StringKey;
+}
+
+uint64_t MyDB_SortKey :: getKey () {
+
+	MyDB_AttValPtr val = computation ();
+	if (type == IntKey)
+		return ((uint64_t) (int64_t) val->toInt ()) ^ (((uint64_t) 1) << 63);
+
+	if (type == DoubleKey) {
+
+		// 0 and -0 are the same, so they have to have the same key
+		double num = val->toDouble ();
+		if (num == 0)
+			num = 0;
+		uint64_t bits;
+		memcpy (&bits, &num, sizeof (bits));
+		if (bits >> 63)
+			return ~bits;
+		return bits | (((uint64_t) 1) << 63);
+	}
+
+	// strings are looked at where they are, if they can be
+	MyDB_StringAttVal *str = dynamic_cast <MyDB_StringAttVal *> (val.get ());
+	string copy;
+	const char *chars;
+	size_t len;
+	if (str != nullptr) {
+		chars = str->getChars ();
+		len = str->getLength ();
+	} else {
+		copy = val->toString ();
+		chars = copy.data ();
+		len = copy.size ();
+	}
+
+	uint64_t key = 0;
+	for (size_t i = 0; i < sizeof (key); i++) {
+		key <<= 8;
+		if (i < len)
+			key |= (unsigned char) chars[i];
+	}
+	return key;
+}
+
+bool MyDB_SortKey :: isExact () {
+	return type != StringKey;
+}
+
+void MyDB_SortKey :: radixSort (vector <pair <uint64_t, void *>> &sortMe) {
+
+	size_t n = sortMe.size ();
+	if (n < 2)
+		return;
+	vector <pair <uint64_t, void *>> temp (n);
+	for (int shift = 0; shift < 64; shift += 8) {
+
+		// count how many keys have each value of this byte
+		size_t counts[256] = {0};
+		for (auto &rec : sortMe)
+			counts[(rec.first >> shift) & 0xff]++;
+
+		// if every key has the same one (say, the high bytes of small ints), the pass
+		// would not change anything
+		if (counts[(sortMe[0].first >> shift) & 0xff] == n)
+			continue;
+
+		// find where the keys with each value go, and put them there
+		size_t start = 0;
+		for (size_t i = 0; i < 256; i++) {
+			size_t count = counts[i];
+			counts[i] = start;
+			start += count;
+		}
+		for (auto &rec : sortMe)
+			temp[counts[(rec.first >> shift) & 0xff]++] = rec;
+		sortMe.swap (temp);
+	}
+}
+
+#endif
@@ -6,14 +6,21 @@
 #include "MyDB_BufferManager.h"
 #include "MyDB_Catalog.h"  
 #include "MyDB_Page.h"
+#include "MyDB_PageHeader.h"
 #include "MyDB_PageReaderWriter.h"
+#include "MyDB_PaxPage.h"
 #include "MyDB_Record.h"
 #include "MyDB_Table.h"
 #include "MyDB_TableReaderWriter.h"
 #include "MyDB_Schema.h"
+#include "MyDB_SortKey.h"
 #include "QUnit.h"
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <time.h>
 #include <unistd.h>
 #include <vector>
@@ -53,7 +60,7 @@ void initialize() {
 int main(int argc, char *argv[]) {
 	int start = 1;
 	if (argc > 1 && argv[1][0] >= '0' && argv[1][0] <= '9') {
-		start = argv[1][0] - '0';
+		start = atoi(argv[1]);
 	}
 	cout << "start from test " << start << endl << flush;
 
@@ -418,6 +425,1025 @@ int main(int argc, char *argv[]) {
 		QUNIT_IS_EQUAL(counter, 10000);
 	}
 	FALLTHROUGH_INTENDED;
+	case 10:
+	{
+		// a read-only table, served out of a memory mapping, has the same records
+		cout << "TEST 10..." << flush;
+		bool result = true;
+		{
+			cout << "create manager..." << flush;
+			MyDB_CatalogPtr myCatalog = make_shared <MyDB_Catalog>("catFile");
+			map <string, MyDB_TablePtr> allTables = MyDB_Table::getAllTables(myCatalog);
+			vector <string> expected;
+			{
+				MyDB_BufferManagerPtr myMgr = make_shared <MyDB_BufferManager>(1024, 16, "tempFile");
+				MyDB_TableReaderWriter supplierTable(allTables["supplier"], myMgr);
+				MyDB_RecordPtr temp = supplierTable.getEmptyRecord();
+				MyDB_RecordIteratorPtr myIter = supplierTable.getIterator(temp);
+				while (myIter->hasNext()) {
+					myIter->getNext();
+					stringstream ss;
+					ss << temp;
+					expected.push_back(ss.str());
+				}
+			}
+
+			cout << "create read-only TableReaderWriter..." << flush;
+			MyDB_BufferManagerPtr myMgr = make_shared <MyDB_BufferManager>(1024, 16, "tempFile");
+			MyDB_TableReaderWriter supplierTable(allTables["supplier"], myMgr, true);
+			MyDB_RecordPtr temp = supplierTable.getEmptyRecord();
+
+			cout << "compare records..." << flush;
+			size_t counter = 0;
+			MyDB_RecordIteratorPtr myIter = supplierTable.getIterator(temp);
+			while (myIter->hasNext()) {
+				myIter->getNext();
+				stringstream ss;
+				ss << temp;
+				if (counter >= expected.size() || ss.str() != expected[counter]) result = false;
+				counter++;
+			}
+			if (counter != expected.size()) result = false;
+			cout << counter << " records, " << myMgr->getNumMisses() << " misses..." << flush;
+			if (myMgr->getNumMisses() != 0) result = false;
+
+			cout << "append..." << flush;
+			try {
+				supplierTable.append(temp);
+				result = false;
+			} catch (MyDB_ReadOnlyError &e) {}
+			if (supplierTable.getNumPages() != allTables["supplier"]->lastPage() + 1) result = false;
+
+			// the pages of a read-only table are just as read-only as the table
+			MyDB_RecordPtr temp2 = supplierTable.getEmptyRecord();
+			function <bool ()> byName = buildRecordComparator(temp, temp2, "[name]");
+			vector <pair <string, function <void (MyDB_PageReaderWriter &)>>> writes {
+				{"clear", [&] (MyDB_PageReaderWriter &page) { page.clear(); }},
+				{"append", [&] (MyDB_PageReaderWriter &page) { page.append(temp); }},
+				{"setType", [&] (MyDB_PageReaderWriter &page) { page.setType(MyDB_PageType::DirectoryPage); }},
+				{"deleteRecord", [&] (MyDB_PageReaderWriter &page) { page.deleteRecord(0); }},
+				{"updateRecord", [&] (MyDB_PageReaderWriter &page) { page.updateRecord(0, temp); }},
+				{"sortInPlace", [&] (MyDB_PageReaderWriter &page) { page.sortInPlace(byName, temp, temp2); }}};
+			for (auto &write : writes) {
+				cout << write.first << "..." << flush;
+				try {
+					write.second(supplierTable[0]);
+					result = false;
+				} catch (MyDB_ReadOnlyError &e) {}
+			}
+			counter = 0;
+			myIter = supplierTable[0].getIterator(temp);
+			while (myIter->hasNext()) {
+				myIter->getNext();
+				stringstream ss;
+				ss << temp;
+				if (counter >= expected.size() || ss.str() != expected[counter]) result = false;
+				counter++;
+			}
+			if (counter == 0 || supplierTable[0].getType() != MyDB_PageType::RegularPage) result = false;
+
+			cout << "empty table..." << flush;
+			unlink("emptyro.bin");
+			MyDB_TableReaderWriter emptyTable(make_shared <MyDB_Table>("emptyro", "emptyro.bin",
+				allTables["supplier"]->getSchema()), myMgr, true);
+			if (emptyTable.getNumPages() != 0) result = false;
+			myIter = emptyTable.getIterator(temp);
+			if (myIter->hasNext()) result = false;
+
+			cout << "shutdown manager..." << flush;
+		}
+		if (result) cout << "CORRECT" << endl << flush;
+		else cout << "***FAIL***" << endl << flush;
+		QUNIT_IS_TRUE(result);
+	}
+	FALLTHROUGH_INTENDED;
+	case 11:
+	{
+		// records on a page can be found by number, deleted, updated in place or
+		// moved, and sorted by moving the slots
+		cout << "TEST 11..." << flush;
+		initialize();
+		bool result = true;
+		{
+			cout << "create manager..." << flush;
+			MyDB_CatalogPtr myCatalog = make_shared <MyDB_Catalog>("catFile");
+			map <string, MyDB_TablePtr> allTables = MyDB_Table::getAllTables(myCatalog);
+			MyDB_BufferManagerPtr myMgr = make_shared <MyDB_BufferManager>(1024, 16, "tempFile");
+			MyDB_TableReaderWriter supplierTable(allTables["supplier"], myMgr);
+			MyDB_RecordPtr temp = supplierTable.getEmptyRecord();
+			auto asString = [&] (MyDB_RecordPtr rec) {
+				stringstream ss;
+				ss << rec;
+				return ss.str();
+			};
+
+			cout << "fill page..." << flush;
+			MyDB_PageReaderWriter page(*myMgr);
+			page.clear();
+			vector <string> expected;
+			MyDB_RecordIteratorPtr myIter = supplierTable.getIterator(temp);
+			while (myIter->hasNext()) {
+				myIter->getNext();
+				if (!page.append(temp)) break;
+				expected.push_back(asString(temp));
+			}
+			if (page.getNumSlots() != (int) expected.size() || expected.size() < 5) result = false;
+
+			cout << "get by number..." << flush;
+			for (int i = (int) expected.size() - 1; i >= 0; i--) {
+				if (!page.getRecord(i, temp) || asString(temp) != expected[i]) result = false;
+			}
+			if (page.getRecord((int) expected.size(), temp)) result = false;
+
+			cout << "delete..." << flush;
+			for (int i = 1; i <= 3; i++) {
+				if (!page.deleteRecord(i)) result = false;
+			}
+			if (page.deleteRecord(2) || page.getRecord(2, temp)) result = false;
+			if (!page.getRecord(4, temp) || asString(temp) != expected[4]) result = false;
+
+			cout << "append after delete..." << flush;
+			temp->fromString(expected[1]);
+			if (!page.append(temp)) result = false;
+			expected.push_back(expected[1]);
+			expected[1] = expected[2] = expected[3] = "";
+
+			cout << "update..." << flush;
+			temp->fromString(expected[0]);
+			string comment = temp->getAtt(6)->toString();
+			comment += comment;
+			temp->getAtt(6)->fromString(comment);
+			if (!page.updateRecord(0, temp)) result = false;
+			expected[0] = asString(temp);
+			temp->fromString(expected[4]);
+			comment = "short";
+			temp->getAtt(6)->fromString(comment);
+			if (!page.updateRecord(4, temp)) result = false;
+			expected[4] = asString(temp);
+			comment = string(2000, 'x');
+			temp->getAtt(6)->fromString(comment);
+			if (page.updateRecord(4, temp) || page.updateRecord(2, temp)) result = false;
+
+			int counter = 0;
+			for (int i = 0; i < page.getNumSlots(); i++) {
+				if (page.getRecord(i, temp) != (expected[i] != "")) result = false;
+				else if (expected[i] != "" && asString(temp) != expected[i]) result = false;
+				else if (expected[i] != "") counter++;
+			}
+
+			cout << "sort..." << flush;
+			MyDB_RecordPtr temp2 = supplierTable.getEmptyRecord();
+			page.sortInPlace(buildRecordComparator(temp, temp2, "[comment]"), temp, temp2);
+			if (page.getNumSlots() != counter) result = false;
+			string last;
+			myIter = page.getIterator(temp);
+			while (myIter->hasNext()) {
+				myIter->getNext();
+				string comment = temp->getAtt(6)->toString();
+				if (comment < last) result = false;
+				last = comment;
+				counter--;
+			}
+			if (counter != 0) result = false;
+
+			cout << "shutdown manager..." << flush;
+		}
+		if (result) cout << "CORRECT" << endl << flush;
+		else cout << "***FAIL***" << endl << flush;
+		QUNIT_IS_TRUE(result);
+	}
+	FALLTHROUGH_INTENDED;
+	case 12:
+	{
+		// a scan through record views sees the same records as one that copies
+		// them, and computations and comparators work over the views
+		cout << "TEST 12..." << flush;
+		initialize();
+		bool result = true;
+		{
+			cout << "create manager..." << flush;
+			MyDB_CatalogPtr myCatalog = make_shared <MyDB_Catalog>("catFile");
+			map <string, MyDB_TablePtr> allTables = MyDB_Table::getAllTables(myCatalog);
+			MyDB_BufferManagerPtr myMgr = make_shared <MyDB_BufferManager>(1024, 16, "tempFile");
+			MyDB_TableReaderWriter supplierTable(allTables["supplier"], myMgr);
+			MyDB_RecordPtr temp = supplierTable.getEmptyRecord();
+			MyDB_RecordViewPtr view = supplierTable.getEmptyRecordView();
+			func nameMatches = view->compileComputation("== ([name], string[Supplier#000000042])");
+			func balance = view->compileComputation("+ ([acctbal], int[1])");
+			MyDB_RecordPtr view2 = supplierTable.getEmptyRecordView();
+			function <bool ()> before = buildRecordComparator(view, view2, "[name]");
+
+			cout << "scan both ways..." << flush;
+			MyDB_RecordIteratorPtr myIter = supplierTable.getIterator(temp);
+			MyDB_RecordIteratorPtr viewIter = supplierTable.getIterator(view);
+			int counter = 0, matches = 0;
+			while (myIter->hasNext()) {
+				myIter->getNext();
+				if (!viewIter->hasNext()) {
+					result = false;
+					break;
+				}
+				viewIter->getNext();
+				stringstream ss, ss2;
+				ss << temp;
+				ss2 << (MyDB_RecordPtr) view;
+				if (ss.str() != ss2.str() || view->getBinarySize() != temp->getBinarySize()) result = false;
+				if (balance()->toDouble() != temp->getAtt(5)->toDouble() + 1) result = false;
+				if (nameMatches()->toBool()) matches++;
+				counter++;
+			}
+			if (viewIter->hasNext() || counter != 10000 || matches != 1) result = false;
+
+			cout << "compare views..." << flush;
+			MyDB_PageReaderWriter page = supplierTable[0];
+			MyDB_RecordIteratorAltPtr first = page.getIteratorAlt();
+			MyDB_RecordIteratorAltPtr second = page.getIteratorAlt();
+			first->advance();
+			second->advance();
+			second->getCurrent(temp);
+			second->advance();
+			first->getCurrent(view);
+			second->getCurrent(view2);
+			if (!before() || view->getAtt(1)->toString() >= view2->getAtt(1)->toString()) result = false;
+
+			cout << "copy a view..." << flush;
+			void *space = malloc(view->getBinarySize());
+			view->toBinary(space);
+			temp->fromBinary(space);
+			string name = "changed";
+			view->getAtt(1)->fromString(name);
+			if (temp->getAtt(1)->toString() == name || view->getAtt(1)->toString() != name) result = false;
+			free(space);
+
+			cout << "shutdown manager..." << flush;
+		}
+		if (result) cout << "CORRECT" << endl << flush;
+		else cout << "***FAIL***" << endl << flush;
+		QUNIT_IS_TRUE(result);
+	}
+	FALLTHROUGH_INTENDED;
+	case 13:
+	{
+		// strings are length-prefixed, while pages from before the prefixes are
+		// still read and written with null-terminated strings
+		cout << "TEST 13..." << flush;
+		initialize();
+		bool result = true;
+		{
+			cout << "create manager..." << flush;
+			MyDB_CatalogPtr myCatalog = make_shared <MyDB_Catalog>("catFile");
+			map <string, MyDB_TablePtr> allTables = MyDB_Table::getAllTables(myCatalog);
+			MyDB_BufferManagerPtr myMgr = make_shared <MyDB_BufferManager>(1024, 16, "tempFile");
+			MyDB_TableReaderWriter supplierTable(allTables["supplier"], myMgr);
+			MyDB_RecordPtr temp = supplierTable.getEmptyRecord();
+			MyDB_RecordPtr temp2 = supplierTable.getEmptyRecord();
+
+			cout << "long strings..." << flush;
+			MyDB_RecordIteratorPtr myIter = supplierTable.getIterator(temp);
+			myIter->getNext();
+			if (temp->getBinarySize() != temp->getLegacyBinarySize()) result = false;
+			string comment(300, 'c');
+			temp->getAtt(6)->fromString(comment);
+			if (temp->getBinarySize() != temp->getLegacyBinarySize() + 1) result = false;
+			MyDB_PageReaderWriter page(*myMgr);
+			page.clear();
+			if (!page.append(temp) || !page.getRecord(0, temp2) || temp2->getAtt(6)->toString() != comment) result = false;
+
+			cout << "legacy page..." << flush;
+			vector <string> expected;
+			page.clear();
+			((MyDB_PageHeader *) page.getBytes())->version = LENGTH_PREFIX_VERSION - 1;
+			while (myIter->hasNext()) {
+				myIter->getNext();
+				if (!page.append(temp)) break;
+				stringstream ss;
+				ss << temp;
+				expected.push_back(ss.str());
+			}
+			if (!MyDB_PageReaderWriter::isLegacy(page.getBytes())) result = false;
+			MyDB_PageSlot *slot = MyDB_PageHeader::getSlot(page.getBytes(), page.getPageSize(), 0);
+			char *name = ((char *) page.getBytes()) + slot->offset + sizeof(int);
+			if (strlen(name) != temp->getAtt(1)->toString().size()) result = false;
+
+			cout << "read legacy page..." << flush;
+			MyDB_PageReaderWriterPtr sorted = page.sort(buildRecordComparator(temp, temp2, "[name]"), temp, temp2);
+			MyDB_RecordIteratorPtr pageIter = sorted->getIterator(temp);
+			size_t counter = 0;
+			while (pageIter->hasNext()) {
+				pageIter->getNext();
+				stringstream ss;
+				ss << temp;
+				if (counter >= expected.size() || ss.str() != expected[counter]) result = false;
+				counter++;
+			}
+			if (counter != expected.size() || !MyDB_PageReaderWriter::isLegacy(sorted->getBytes())) result = false;
+
+			cout << "shutdown manager..." << flush;
+		}
+		if (result) cout << "CORRECT" << endl << flush;
+		else cout << "***FAIL***" << endl << flush;
+		QUNIT_IS_TRUE(result);
+	}
+	FALLTHROUGH_INTENDED;
+	case 14:
+	{
+		// a "pax" table, whose pages keep each attribute together, holds the same
+		// records as the regular one, and can be scanned a few attributes at a time
+		cout << "TEST 14..." << flush;
+		initialize();
+		bool result = true;
+		{
+			cout << "create manager..." << flush;
+			MyDB_CatalogPtr myCatalog = make_shared <MyDB_Catalog>("catFile");
+			map <string, MyDB_TablePtr> allTables = MyDB_Table::getAllTables(myCatalog);
+			MyDB_BufferManagerPtr myMgr = make_shared <MyDB_BufferManager>(1024, 16, "tempFile");
+			MyDB_TableReaderWriter supplierTable(allTables["supplier"], myMgr);
+			MyDB_TablePtr paxTable = make_shared <MyDB_Table>("supplierpax", "supplierpax.bin",
+				allTables["supplier"]->getSchema(), "pax", "suppkey");
+			MyDB_TableReaderWriter paxSupplierTable(paxTable, myMgr);
+			paxSupplierTable.loadFromTextFile("supplier.tbl");
+			MyDB_RecordPtr temp = supplierTable.getEmptyRecord();
+			MyDB_RecordPtr temp2 = paxSupplierTable.getEmptyRecord();
+
+			cout << "scan both tables..." << flush;
+			MyDB_RecordIteratorPtr myIter = supplierTable.getIterator(temp);
+			MyDB_RecordIteratorPtr paxIter = paxSupplierTable.getIterator(temp2);
+			int counter = 0;
+			double total = 0;
+			while (myIter->hasNext()) {
+				myIter->getNext();
+				if (!paxIter->hasNext()) {
+					result = false;
+					break;
+				}
+				paxIter->getNext();
+				stringstream ss, ss2;
+				ss << temp;
+				ss2 << temp2;
+				if (ss.str() != ss2.str()) result = false;
+				total += temp->getAtt(5)->toDouble();
+				counter++;
+			}
+			if (paxIter->hasNext() || counter != 10000) result = false;
+			if (paxSupplierTable[0].getType() != MyDB_PageType::PaxPage) result = false;
+
+			cout << "scan some attributes..." << flush;
+			MyDB_RecordViewPtr view = paxSupplierTable.getEmptyRecordView();
+			paxIter = paxSupplierTable.getIterator(view, vector <string> {"suppkey", "acctbal"});
+			double paxTotal = 0;
+			counter = 0;
+			while (paxIter->hasNext()) {
+				paxIter->getNext();
+				if (view->getAtt(0)->toInt() != counter + 1) result = false;
+				paxTotal += view->getAtt(5)->toDouble();
+				counter++;
+			}
+			if (counter != 10000 || paxTotal != total || view->getAtt(1)->toString() != "") result = false;
+			if (paxSupplierTable.getIterator(view, vector <string> {"suppkey", "acctbl"}) != nullptr) result = false;
+
+			cout << "alt iterator..." << flush;
+			MyDB_RecordIteratorAltPtr altIter = paxSupplierTable.getIteratorAlt();
+			counter = 0;
+			while (altIter->advance()) {
+				altIter->getCurrent(temp2);
+				if (temp2->getAtt(0)->toInt() != counter + 1) result = false;
+				counter++;
+			}
+			if (counter != 10000) result = false;
+
+			cout << "random access..." << flush;
+			MyDB_PageReaderWriter page = paxSupplierTable[1];
+			MyDB_RecordIteratorPtr pageIter = page.getIterator(temp);
+			for (int i = 0; i <= 3; i++)
+				pageIter->getNext();
+			stringstream ss, ss2;
+			ss << temp;
+			if (!page.getRecord(3, temp2) || page.getRecord(page.getNumSlots(), temp2)) result = false;
+			ss2 << temp2;
+			if (ss.str() != ss2.str() || page.deleteRecord(3) || page.updateRecord(3, temp)) result = false;
+
+			cout << "sort..." << flush;
+			int numRecs = page.getNumSlots();
+			function <bool ()> byName = buildRecordComparator(temp, temp2, "[name]");
+			function <bool ()> byComment = buildRecordComparator(temp, temp2, "[comment]");
+			MyDB_PageReaderWriterPtr sorted = page.sort(byName, temp, temp2);
+			page.sortInPlace(byComment, temp, temp2);
+			for (MyDB_PageReaderWriter *check : {sorted.get(), &page}) {
+				string last = "";
+				int att = check == &page ? 6 : 1;
+				counter = 0;
+				pageIter = check->getIterator(temp);
+				while (pageIter->hasNext()) {
+					pageIter->getNext();
+					if (temp->getAtt(att)->toString() < last) result = false;
+					last = temp->getAtt(att)->toString();
+					counter++;
+				}
+				if (counter != numRecs || check->getType() != MyDB_PageType::PaxPage) result = false;
+			}
+
+			cout << "shutdown manager..." << flush;
+		}
+		if (result) cout << "CORRECT" << endl << flush;
+		else cout << "***FAIL***" << endl << flush;
+		QUNIT_IS_TRUE(result);
+	}
+	FALLTHROUGH_INTENDED;
+	case 15:
+	{
+		// the zone map lets a scan for a range of values skip the pages that
+		// cannot have any, and it is kept in the catalog along with the table
+		cout << "TEST 15..." << flush;
+		initialize();
+		bool result = true;
+		{
+			cout << "create manager..." << flush;
+			MyDB_CatalogPtr myCatalog = make_shared <MyDB_Catalog>("catFile");
+			map <string, MyDB_TablePtr> allTables = MyDB_Table::getAllTables(myCatalog);
+			MyDB_BufferManagerPtr myMgr = make_shared <MyDB_BufferManager>(1024, 16, "tempFile");
+			MyDB_TableReaderWriter supplierTable(allTables["supplier"], myMgr);
+			MyDB_RecordPtr temp = supplierTable.getEmptyRecord();
+			MyDB_ZoneMapPtr zones = allTables["supplier"]->getZoneMap();
+
+			cout << "read zone map..." << flush;
+			long total = 0;
+			for (int i = 0; i < supplierTable.getNumPages(); i++)
+				total += zones->getNumRecords(i);
+			if (total != 10000) result = false;
+
+			// counts the records that the filtered scan returns, and those of them
+			// with a key in [low, high]
+			auto scan = [&] (vector <MyDB_AttRange> filter, int low, int high, int &numMatches) {
+				MyDB_RecordIteratorAltPtr myIter = supplierTable.getIteratorAlt(filter);
+				int counter = 0;
+				numMatches = 0;
+				while (myIter->advance()) {
+					myIter->getCurrent(temp);
+					int key = temp->getAtt(0)->toInt();
+					if (key >= low && key <= high) numMatches++;
+					counter++;
+				}
+				return counter;
+			};
+
+			cout << "int range..." << flush;
+			MyDB_IntAttValPtr low = make_shared <MyDB_IntAttVal>();
+			MyDB_IntAttValPtr high = make_shared <MyDB_IntAttVal>();
+			low->set(5000);
+			high->set(5010);
+			int numMatches;
+			int counter = scan({{0, low, high}}, 5000, 5010, numMatches);
+			if (numMatches != 11 || counter > 30) result = false;
+			low->set(20000);
+			if (scan({{0, low, nullptr}}, 0, 0, numMatches) != 0) result = false;
+			if (scan({}, 1, 10000, numMatches) != 10000 || numMatches != 10000) result = false;
+
+			cout << "string range..." << flush;
+			MyDB_StringAttValPtr name = make_shared <MyDB_StringAttVal>();
+			name->set("Supplier#000000042");
+			counter = scan({{1, name, name}}, 42, 42, numMatches);
+			if (numMatches != 1 || counter > 10) result = false;
+
+			cout << "append..." << flush;
+			string key = "99999";
+			temp->getAtt(0)->fromString(key);
+			supplierTable.append(temp);
+			low->set(99999);
+			counter = scan({{0, low, low}}, 99999, 99999, numMatches);
+			if (numMatches != 1 || counter > 10) result = false;
+
+			cout << "catalog..." << flush;
+			allTables["supplier"]->putInCatalog(myCatalog);
+			MyDB_CatalogPtr newCatalog = make_shared <MyDB_Catalog>("catFile");
+			MyDB_ZoneMapPtr newZones = MyDB_Table::getAllTables(newCatalog)["supplier"]->getZoneMap();
+			vector <MyDB_AttRange> filter {{0, low, low}};
+			for (int i = 0; i < supplierTable.getNumPages(); i++) {
+				if (newZones->getNumRecords(i) != zones->getNumRecords(i)) result = false;
+				if (newZones->mightMatch(i, filter) != zones->mightMatch(i, filter)) result = false;
+			}
+
+			// once the table changes, the zone map in the catalog is not used until
+			// the table is put back into the catalog
+			cout << "stale zone map..." << flush;
+			key = "99998";
+			temp->getAtt(0)->fromString(key);
+			supplierTable.append(temp);
+			newCatalog = make_shared <MyDB_Catalog>("catFile");
+			newZones = MyDB_Table::getAllTables(newCatalog)["supplier"]->getZoneMap();
+			for (int i = 0; i < supplierTable.getNumPages(); i++) {
+				if (newZones->getNumRecords(i) != -1) result = false;
+			}
+
+			cout << "shutdown manager..." << flush;
+		}
+		if (result) cout << "CORRECT" << endl << flush;
+		else cout << "***FAIL***" << endl << flush;
+		QUNIT_IS_TRUE(result);
+	}
+	FALLTHROUGH_INTENDED;
+	case 16:
+	{
+		// the pages of a "compressed" table hold more records than those of a
+		// "pax" one, and the records read back the same
+		cout << "TEST 16..." << flush;
+		initialize();
+		bool result = true;
+		{
+			cout << "create manager..." << flush;
+			MyDB_CatalogPtr myCatalog = make_shared <MyDB_Catalog>("catFile");
+			map <string, MyDB_TablePtr> allTables = MyDB_Table::getAllTables(myCatalog);
+			MyDB_BufferManagerPtr myMgr = make_shared <MyDB_BufferManager>(1024, 16, "tempFile");
+			MyDB_TableReaderWriter supplierTable(allTables["supplier"], myMgr);
+			MyDB_SchemaPtr mySchema = allTables["supplier"]->getSchema();
+			// compression pays off with pages of a more usual size
+			MyDB_BufferManagerPtr bigMgr = make_shared <MyDB_BufferManager>(65536, 16, "tempFile2");
+			MyDB_TableReaderWriter paxTable(make_shared <MyDB_Table>("supplierpax", "supplierpax.bin",
+				mySchema, "pax", "suppkey"), bigMgr);
+			MyDB_TableReaderWriter compressedTable(make_shared <MyDB_Table>("suppliercomp", "suppliercomp.bin",
+				mySchema, "compressed", "suppkey"), bigMgr);
+			MyDB_RecordPtr temp = supplierTable.getEmptyRecord();
+
+			// give the phone number long runs, and the comment only a few values
+			cout << "load..." << flush;
+			vector <string> expected;
+			vector <string> modes {"AIR", "RAIL", "SHIP", "TRUCK"};
+			MyDB_RecordIteratorPtr myIter = supplierTable.getIterator(temp);
+			while (myIter->hasNext()) {
+				myIter->getNext();
+				string phone = temp->getAtt(0)->toInt() <= 5000 ? "low" : "high";
+				temp->getAtt(4)->fromString(phone);
+				temp->getAtt(6)->fromString(modes[temp->getAtt(0)->toInt() % 4]);
+				paxTable.append(temp);
+				compressedTable.append(temp);
+				stringstream ss;
+				ss << temp;
+				expected.push_back(ss.str());
+			}
+			if (compressedTable.getNumPages() >= paxTable.getNumPages()) result = false;
+
+			cout << "encodings..." << flush;
+			MyDB_PageReaderWriter page = compressedTable[1];
+			void *bytes = page.getBytes();
+			if (MINI_PAGE(bytes, 0)->encoding != PaxBitPacked || MINI_PAGE(bytes, 3)->encoding != PaxBitPacked ||
+				MINI_PAGE(bytes, 4)->encoding != PaxRunLength || MINI_PAGE(bytes, 6)->encoding != PaxDictionary ||
+				MINI_PAGE(bytes, 1)->encoding != PaxPlain)
+				result = false;
+
+			cout << "scan..." << flush;
+			MyDB_RecordViewPtr view = compressedTable.getEmptyRecordView();
+			myIter = compressedTable.getIterator(view);
+			MyDB_RecordIteratorAltPtr altIter = compressedTable.getIteratorAlt();
+			size_t counter = 0;
+			while (myIter->hasNext()) {
+				myIter->getNext();
+				if (!altIter->advance()) {
+					result = false;
+					break;
+				}
+				altIter->getCurrent(temp);
+				stringstream ss, ss2;
+				ss << (MyDB_RecordPtr) view;
+				ss2 << temp;
+				if (counter >= expected.size() || ss.str() != expected[counter] || ss2.str() != expected[counter])
+					result = false;
+				counter++;
+			}
+			if (counter != expected.size() || altIter->advance()) result = false;
+
+			cout << "random access and sort..." << flush;
+			int numRecs = page.getNumSlots();
+			MyDB_RecordPtr temp2 = supplierTable.getEmptyRecord();
+			if (!page.getRecord(numRecs - 1, temp2) || temp2->getAtt(6)->toString() != modes[temp2->getAtt(0)->toInt() % 4])
+				result = false;
+			page.sortInPlace(buildRecordComparator(temp, temp2, "[comment]"), temp, temp2);
+			myIter = page.getIterator(temp);
+			string last = "";
+			counter = 0;
+			while (myIter->hasNext()) {
+				myIter->getNext();
+				if (temp->getAtt(6)->toString() < last) result = false;
+				last = temp->getAtt(6)->toString();
+				counter++;
+			}
+			if ((int) counter != numRecs) result = false;
+
+			cout << "shutdown manager..." << flush;
+		}
+		if (result) cout << "CORRECT" << endl << flush;
+		else cout << "***FAIL***" << endl << flush;
+		QUNIT_IS_TRUE(result);
+	}
+	FALLTHROUGH_INTENDED;
+	case 17:
+	{
+		// the sort key of a record never puts it after a record that the comparator
+		// puts after it, and exact keys agree with the comparator completely
+		cout << "TEST 17..." << flush;
+		initialize();
+		bool result = true;
+		{
+			cout << "create manager..." << flush;
+			MyDB_CatalogPtr myCatalog = make_shared <MyDB_Catalog>("catFile");
+			map <string, MyDB_TablePtr> allTables = MyDB_Table::getAllTables(myCatalog);
+			MyDB_BufferManagerPtr myMgr = make_shared <MyDB_BufferManager>(1024, 16, "tempFile");
+			MyDB_TableReaderWriter supplierTable(allTables["supplier"], myMgr);
+			MyDB_RecordPtr temp = supplierTable.getEmptyRecord();
+			MyDB_RecordPtr temp2 = supplierTable.getEmptyRecord();
+
+			cout << "load..." << flush;
+			vector <vector <char>> rows;
+			MyDB_RecordIteratorPtr myIter = supplierTable.getIterator(temp);
+			while (myIter->hasNext()) {
+				myIter->getNext();
+				rows.push_back(vector <char>(temp->getBinarySize()));
+				temp->toBinary(rows.back().data());
+			}
+
+			vector <string> computations {"[suppkey]", "[acctbal]", "[name]", "[comment]", "- (int [0], [nationkey])",
+				"* ([acctbal], double [-1.0])", "> ([acctbal], double [0.0])"};
+			for (string &computation : computations) {
+				cout << computation << "..." << flush;
+				function <bool ()> before = buildRecordComparator(temp, temp2, computation);
+				MyDB_SortKey key(temp, computation);
+				size_t n = rows.size();
+				for (size_t i = 0; i < n; i++) {
+					size_t j = (i * 7919 + 13) % n;
+					temp->fromBinary(rows[j].data());
+					uint64_t keyJ = key.getKey();
+					temp->fromBinary(rows[i].data());
+					uint64_t keyI = key.getKey();
+					temp2->fromBinary(rows[j].data());
+					bool iFirst = before();
+					temp->fromBinary(rows[j].data());
+					temp2->fromBinary(rows[i].data());
+					bool jFirst = before();
+					if ((keyI < keyJ && jFirst) || (keyJ < keyI && iFirst)) result = false;
+					if (key.isExact() && ((keyI < keyJ) != iFirst || (keyJ < keyI) != jFirst)) result = false;
+				}
+			}
+			if (!MyDB_SortKey(temp, "[acctbal]").isExact() || MyDB_SortKey(temp, "[name]").isExact()) result = false;
+
+			cout << "shutdown manager..." << flush;
+		}
+		if (result) cout << "CORRECT" << endl << flush;
+		else cout << "***FAIL***" << endl << flush;
+		QUNIT_IS_TRUE(result);
+	}
+	FALLTHROUGH_INTENDED;
+	case 18:
+	{
+		// sorting a page with a sort key gives the same records as sorting it with
+		// the comparator, in order, both with a radix sort (for an int or a double)
+		// and with the comparator breaking ties (for a string)
+		cout << "TEST 18..." << flush;
+		initialize();
+		bool result = true;
+		{
+			cout << "create manager..." << flush;
+			MyDB_CatalogPtr myCatalog = make_shared <MyDB_Catalog>("catFile");
+			map <string, MyDB_TablePtr> allTables = MyDB_Table::getAllTables(myCatalog);
+			MyDB_BufferManagerPtr myMgr = make_shared <MyDB_BufferManager>(1024, 16, "tempFile");
+			MyDB_TableReaderWriter supplierTable(allTables["supplier"], myMgr);
+			MyDB_BufferManagerPtr bigMgr = make_shared <MyDB_BufferManager>(65536, 16, "tempFile2");
+			MyDB_TablePtr bigTable = make_shared <MyDB_Table>("supplierbig", "supplierbig.bin",
+				allTables["supplier"]->getSchema());
+			MyDB_TableReaderWriter bigRW(bigTable, bigMgr);
+			MyDB_RecordPtr temp = supplierTable.getEmptyRecord();
+			MyDB_RecordPtr temp2 = supplierTable.getEmptyRecord();
+
+			cout << "load..." << flush;
+			MyDB_PageReaderWriter page = bigRW[0];
+			page.clear();
+			MyDB_RecordIteratorPtr myIter = supplierTable.getIterator(temp);
+			while (myIter->hasNext()) {
+				myIter->getNext();
+				if (!page.append(temp))
+					break;
+			}
+			page.deleteRecord(3);
+
+			// returns the records on a page as text (in sorted order, since records
+			// that are tied can come out of a sort in any order), and checks that
+			// they are in order according to before
+			auto contents = [&] (MyDB_PageReaderWriter &fromMe, function <bool ()> before) {
+				vector <string> returnVal;
+				for (int i = 0; i < fromMe.getNumSlots(); i++) {
+					if (i > 0) {
+						fromMe.getRecord(i - 1, temp2);
+						fromMe.getRecord(i, temp);
+						if (before()) result = false;
+					}
+					fromMe.getRecord(i, temp);
+					stringstream ss;
+					ss << temp;
+					returnVal.push_back(ss.str());
+				}
+				sort(returnVal.begin(), returnVal.end());
+				return returnVal;
+			};
+
+			for (string computation : {"[acctbal]", "[suppkey]", "[name]", "- (int [0], [nationkey])"}) {
+				cout << computation << "..." << flush;
+				function <bool ()> before = buildRecordComparator(temp, temp2, computation);
+				MyDB_SortKeyPtr key = make_shared <MyDB_SortKey>(temp, computation);
+				vector <string> expected = contents(*page.sort(before, temp, temp2), before);
+				if (contents(*page.sort(before, temp, temp2, key), before) != expected) result = false;
+
+				MyDB_PageReaderWriter copy = bigRW[1];
+				memcpy(copy.getBytes(), page.getBytes(), 65536);
+				copy.sortInPlace(before, temp, temp2, key);
+				if (contents(copy, before) != expected) result = false;
+			}
+
+			cout << "shutdown manager..." << flush;
+		}
+		if (result) cout << "CORRECT" << endl << flush;
+		else cout << "***FAIL***" << endl << flush;
+		QUNIT_IS_TRUE(result);
+	}
+	FALLTHROUGH_INTENDED;
+	case 19:
+	{
+		// sorting the pages of a "compressed" table loses no records, even though
+		// the records do not compress as well once the runs are broken up
+		cout << "TEST 19..." << flush;
+		initialize();
+		bool result = true;
+		{
+			cout << "create manager..." << flush;
+			MyDB_CatalogPtr myCatalog = make_shared <MyDB_Catalog>("catFile");
+			map <string, MyDB_TablePtr> allTables = MyDB_Table::getAllTables(myCatalog);
+			MyDB_BufferManagerPtr myMgr = make_shared <MyDB_BufferManager>(1024, 16, "tempFile");
+			MyDB_TableReaderWriter supplierTable(allTables["supplier"], myMgr);
+			MyDB_BufferManagerPtr bigMgr = make_shared <MyDB_BufferManager>(65536, 16, "tempFile2");
+			MyDB_TableReaderWriter compressedTable(make_shared <MyDB_Table>("suppliersort", "suppliersort.bin",
+				allTables["supplier"]->getSchema(), "compressed", "suppkey"), bigMgr);
+			MyDB_RecordPtr temp = supplierTable.getEmptyRecord();
+			MyDB_RecordPtr temp2 = supplierTable.getEmptyRecord();
+
+			// the phone number and the comment come in runs of 50
+			cout << "load..." << flush;
+			MyDB_RecordIteratorPtr myIter = supplierTable.getIterator(temp);
+			while (myIter->hasNext()) {
+				myIter->getNext();
+				string phone = "phone " + to_string(temp->getAtt(0)->toInt() / 50);
+				string comment = "comment " + to_string(temp->getAtt(0)->toInt() / 50);
+				temp->getAtt(4)->fromString(phone);
+				temp->getAtt(6)->fromString(comment);
+				compressedTable.append(temp);
+			}
+
+			// returns the records on the pages as text, in sorted order, and checks
+			// that they are in order according to before
+			auto contents = [&] (vector <MyDB_PageReaderWriter> &fromMe, function <bool ()> before) {
+				vector <string> returnVal;
+				vector <char> last;
+				for (MyDB_PageReaderWriter &page : fromMe) {
+					MyDB_RecordIteratorPtr pageIter = page.getIterator(temp);
+					while (pageIter->hasNext()) {
+						pageIter->getNext();
+						if (before != nullptr && !last.empty()) {
+							temp2->fromBinary(last.data());
+							if (before()) result = false;
+						}
+						last.resize(temp->getBinarySize());
+						temp->toBinary(last.data());
+						stringstream ss;
+						ss << temp;
+						returnVal.push_back(ss.str());
+					}
+				}
+				sort(returnVal.begin(), returnVal.end());
+				return returnVal;
+			};
+
+			cout << "sort pages..." << flush;
+			function <bool ()> before = buildRecordComparator(temp, temp2, "[acctbal]");
+			MyDB_SortKeyPtr key = make_shared <MyDB_SortKey>(temp, "[acctbal]");
+			size_t counter = 0, overflows = 0;
+			for (int i = 0; i < compressedTable.getNumPages(); i++) {
+				vector <MyDB_PageReaderWriter> page {compressedTable[i]};
+				vector <string> expected = contents(page, nullptr);
+				counter += expected.size();
+
+				vector <MyDB_PageReaderWriter> sorted = page[0].sortIntoList(before, temp, temp2, key);
+				if (contents(sorted, before) != expected) result = false;
+				if (sorted.size() > 1) overflows++;
+
+				try {
+					vector <MyDB_PageReaderWriter> one {*page[0].sort(before, temp, temp2)};
+					if (sorted.size() > 1 || contents(one, before) != expected) result = false;
+				} catch (MyDB_PageOverflowError &e) {
+					if (sorted.size() == 1) result = false;
+				}
+
+				try {
+					page[0].sortInPlace(before, temp, temp2, key);
+					if (sorted.size() > 1 || contents(page, before) != expected) result = false;
+				} catch (MyDB_PageOverflowError &e) {
+					if (sorted.size() == 1 || contents(page, nullptr) != expected) result = false;
+				}
+			}
+			cout << counter << " records, " << overflows << " pages overflow..." << flush;
+			if (counter != 10000 || overflows == 0) result = false;
+
+			cout << "shutdown manager..." << flush;
+		}
+		if (result) cout << "CORRECT" << endl << flush;
+		else cout << "***FAIL***" << endl << flush;
+		QUNIT_IS_TRUE(result);
+	}
+	FALLTHROUGH_INTENDED;
+	case 20:
+	{
+		// tables written before the page header, and before the slot directory, can
+		// be read; opened read-only they are left as they are, and otherwise they
+		// are rewritten in the current format, unless they are B+-trees
+		cout << "TEST 20..." << flush;
+		initialize();
+		bool result = true;
+		for (int version = 0; version < SLOT_DIRECTORY_VERSION; version++) {
+			cout << "create manager..." << flush;
+			MyDB_CatalogPtr myCatalog = make_shared <MyDB_Catalog>("catFile");
+			map <string, MyDB_TablePtr> allTables = MyDB_Table::getAllTables(myCatalog);
+			MyDB_BufferManagerPtr myMgr = make_shared <MyDB_BufferManager>(1024, 16, "tempFile");
+			MyDB_TableReaderWriter supplierTable(allTables["supplier"], myMgr);
+			MyDB_RecordPtr temp = supplierTable.getEmptyRecord();
+
+			// write the pages as they used to be written: with version 0, a page has no
+			// header, just the page type and the number of bytes used, and with version
+			// 1, it has a header but no slots.  Either way, the records are one after
+			// another, with null-terminated strings
+			cout << "write version " << version << " pages..." << flush;
+			vector <string> expected;
+			vector <char> page(1024, 0);
+			size_t start = version == 0 ? 2 * sizeof(size_t) : sizeof(MyDB_PageHeader);
+			size_t used = start;
+			int numPages = 0;
+			ofstream out("supplierold.bin", ios::binary | ios::trunc);
+			auto writePage = [&] () {
+				if (version == 1) {
+					MyDB_PageHeader::format(page.data());
+					((MyDB_PageHeader *) page.data())->version = version;
+				}
+				*((size_t *) &page[sizeof(size_t)]) = used;
+				MyDB_PageHeader::stamp(page.data(), page.size());
+				out.write(page.data(), page.size());
+				fill(page.begin(), page.end(), 0);
+				used = start;
+				numPages++;
+			};
+			MyDB_RecordIteratorPtr myIter = supplierTable.getIterator(temp);
+			while (myIter->hasNext()) {
+				myIter->getNext();
+				if (used + temp->getLegacyBinarySize() > page.size())
+					writePage();
+				temp->toLegacyBinary(&page[used]);
+				used += temp->getLegacyBinarySize();
+				stringstream ss;
+				ss << temp;
+				expected.push_back(ss.str());
+			}
+			writePage();
+			out.close();
+			MyDB_TablePtr oldTable = make_shared <MyDB_Table>("supplierold", "supplierold.bin",
+				allTables["supplier"]->getSchema());
+			oldTable->setLastPage(numPages - 1);
+
+			// changes the type of the first page, as the B+-tree of the time would have
+			auto setType = [&] (MyDB_PageType type) {
+				fstream patch("supplierold.bin", ios::binary | ios::in | ios::out);
+				patch.read(page.data(), page.size());
+				*((MyDB_PageType *) page.data()) = type;
+				MyDB_PageHeader::stamp(page.data(), page.size());
+				patch.seekp(0);
+				patch.write(page.data(), page.size());
+			};
+
+			// checks that both kinds of iterator give back the records that were written
+			auto scan = [&] (MyDB_TableReaderWriter &scanMe) {
+				size_t counter = 0;
+				MyDB_RecordIteratorPtr scanIter = scanMe.getIterator(temp);
+				while (scanIter->hasNext()) {
+					scanIter->getNext();
+					stringstream ss;
+					ss << temp;
+					if (counter >= expected.size() || ss.str() != expected[counter]) result = false;
+					counter++;
+				}
+				size_t altCounter = 0;
+				MyDB_RecordIteratorAltPtr altIter = scanMe.getIteratorAlt();
+				while (altIter->advance()) {
+					altIter->getCurrent(temp);
+					altCounter++;
+				}
+				if (counter != expected.size() || altCounter != expected.size()) result = false;
+			};
+
+			cout << "read-only..." << flush;
+			{
+				MyDB_BufferManagerPtr oldMgr = make_shared <MyDB_BufferManager>(1024, 16, "tempFile2");
+				MyDB_TableReaderWriter oldRW(oldTable, oldMgr, true);
+				scan(oldRW);
+				if (oldRW.getNumPages() != numPages) result = false;
+				try {
+					oldRW[0].getNumSlots();
+					result = false;
+				} catch (MyDB_PageFormatError &e) {}
+			}
+
+			cout << "B+-tree..." << flush;
+			{
+				setType(MyDB_PageType::DirectoryPage);
+				MyDB_BufferManagerPtr oldMgr = make_shared <MyDB_BufferManager>(1024, 16, "tempFile2");
+				try {
+					MyDB_TableReaderWriter oldRW(oldTable, oldMgr);
+					result = false;
+				} catch (MyDB_PageFormatError &e) {}
+				if (oldTable->lastPage() != numPages - 1) result = false;
+			}
+
+			cout << "rewrite..." << flush;
+			{
+				setType(MyDB_PageType::RegularPage);
+				MyDB_BufferManagerPtr oldMgr = make_shared <MyDB_BufferManager>(1024, 16, "tempFile2");
+				MyDB_TableReaderWriter oldRW(oldTable, oldMgr);
+				scan(oldRW);
+				if (MyDB_PageHeader::isSequential(oldRW[0].getBytes()) ||
+					MyDB_PageReaderWriter::isLegacy(oldRW[0].getBytes()) || oldRW[0].getNumSlots() == 0)
+					result = false;
+			}
+
+			cout << "shutdown manager..." << flush;
+		}
+		if (result) cout << "CORRECT" << endl << flush;
+		else cout << "***FAIL***" << endl << flush;
+		QUNIT_IS_TRUE(result);
+	}
+	FALLTHROUGH_INTENDED;
+	case 21:
+	{
+		// the pages of a table opened read-only are served from a mapping of the
+		// file, but they are checked just like the pages that are read: a damaged
+		// page, or one that has lost its header, is not handed out
+		cout << "TEST 21..." << flush;
+		initialize();
+		bool result = true;
+		{
+			cout << "create manager..." << flush;
+			MyDB_CatalogPtr myCatalog = make_shared <MyDB_Catalog>("catFile");
+			map <string, MyDB_TablePtr> allTables = MyDB_Table::getAllTables(myCatalog);
+			MyDB_TablePtr damagedTable = make_shared <MyDB_Table>("supplierdamaged", "supplierdamaged.bin",
+				allTables["supplier"]->getSchema());
+
+			cout << "load..." << flush;
+			{
+				MyDB_BufferManagerPtr myMgr = make_shared <MyDB_BufferManager>(1024, 16, "tempFile");
+				MyDB_TableReaderWriter damagedRW(damagedTable, myMgr);
+				damagedRW.loadFromTextFile("supplier.tbl");
+			}
+
+			cout << "damage pages..." << flush;
+			{
+				fstream patch("supplierdamaged.bin", ios::binary | ios::in | ios::out);
+				patch.seekp(1024 + 200);
+				patch.write("XXXX", 4);
+				vector <char> zeros(sizeof(MyDB_PageHeader), 0);
+				patch.seekp(2 * 1024);
+				patch.write(zeros.data(), zeros.size());
+			}
+
+			cout << "scan read-only..." << flush;
+			MyDB_BufferManagerPtr myMgr = make_shared <MyDB_BufferManager>(1024, 16, "tempFile");
+			MyDB_TableReaderWriter damagedRW(damagedTable, myMgr, true);
+			MyDB_RecordPtr temp = damagedRW.getEmptyRecord();
+			try {
+				MyDB_RecordIteratorPtr myIter = damagedRW.getIterator(temp);
+				while (myIter->hasNext())
+					myIter->getNext();
+				result = false;
+			} catch (MyDB_PageCorruptError &e) {}
+
+			cout << "page by page..." << flush;
+			int numBad = 0;
+			for (int i = 0; i < damagedRW.getNumPages(); i++) {
+				try {
+					damagedRW[i].getNumSlots();
+				} catch (MyDB_PageCorruptError &e) {
+					if (i != 1 && i != 2) result = false;
+					numBad++;
+				}
+			}
+			if (numBad != 2 || myMgr->getStats().numChecksumFailures != 3 || myMgr->getNumMisses() != 0)
+				result = false;
+
+			cout << "shutdown manager..." << flush;
+		}
+		if (result) cout << "CORRECT" << endl << flush;
+		else cout << "***FAIL***" << endl << flush;
+		QUNIT_IS_TRUE(result);
+	}
+	FALLTHROUGH_INTENDED;
 	case 0:
 	{
 		// table hasNext with all pages cleared
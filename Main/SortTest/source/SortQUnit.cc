@@ -13,8 +13,34 @@
 #include "MyDB_Schema.h"
 #include "QUnit.h"
 #include "Sorting.h"
+#include <chrono>
+#include <cstdio>
 #include <iostream>
 
+// iterate through the table, reading the records into rec1 and rec2 by turns; counter
+// gets the number of records, and the return value is the number that are less than the
+// record before them (comp says rec1 < rec2, and otherComp says rec2 < rec1)
+static int countOutOfOrder (MyDB_TableReaderWriter &table, MyDB_RecordPtr rec1, MyDB_RecordPtr rec2, 
+	function <bool ()> comp, function <bool ()> otherComp, int &counter) {
+
+	MyDB_RecordIteratorAltPtr myIter = table.getIteratorAlt ();
+	int outOfOrder = 0;
+	counter = 0;
+	while (myIter->advance ()) {
+		if (counter % 2 == 0) {
+			myIter->getCurrent (rec1);
+			if (counter > 0 && comp ())
+				outOfOrder++;
+		} else {
+			myIter->getCurrent (rec2);
+			if (otherComp ())
+				outOfOrder++;
+		}
+		counter++;
+	}
+	return outOfOrder;
+}
+
 int main () {
 
 	QUnit::UnitTest qunit(cerr, QUnit::verbose);
@@ -153,6 +179,182 @@ int main () {
 
                 QUNIT_IS_EQUAL (matches, 320000);
 	}
+
+	{
+		// sort again, with most of the buffer pinned by someone else, so that the
+		// sort has to make do with shorter runs
+		MyDB_CatalogPtr myCatalog = make_shared <MyDB_Catalog> ("catFile");
+		map <string, MyDB_TablePtr> allTables = MyDB_Table :: getAllTables (myCatalog);
+		MyDB_BufferManagerPtr myMgr = make_shared <MyDB_BufferManager> (131072, 128, "tempFile");
+		MyDB_TableReaderWriter supplierTable (allTables["supplier"], myMgr);
+		MyDB_TablePtr outTable = make_shared <MyDB_Table> ("supplierSortedPinned", 
+			"supplierSortedPinned.bin", allTables["supplier"]->getSchema ());
+		MyDB_TableReaderWriter outputTable (outTable, myMgr);
+
+		vector <MyDB_PageHandle> pinned;
+		for (int i = 0; i < 100; i++)
+			pinned.push_back (myMgr->getPinnedPage ());
+
+		MyDB_RecordPtr rec1 = supplierTable.getEmptyRecord ();
+		MyDB_RecordPtr rec2 = supplierTable.getEmptyRecord ();
+		function <bool ()> myComp = buildRecordComparator (rec1, rec2, "[acctbal]");
+		function <bool ()> otherComp = buildRecordComparator (rec2, rec1, "[acctbal]");
+		sort (64, supplierTable, outputTable, myComp, rec1, rec2);
+
+		// the records alternate between rec1 and rec2, and none can be less than the one before
+		int counter;
+		int outOfOrder = countOutOfOrder (outputTable, rec1, rec2, myComp, otherComp, counter);
+		QUNIT_IS_EQUAL (counter, 320000);
+		QUNIT_IS_EQUAL (outOfOrder, 0);
+	}
+
+	{
+		// sort with several threads making the runs at once; the result has to be
+		// the same as the one-thread sort
+		MyDB_CatalogPtr myCatalog = make_shared <MyDB_Catalog> ("catFile");
+		map <string, MyDB_TablePtr> allTables = MyDB_Table :: getAllTables (myCatalog);
+		MyDB_BufferManagerPtr myMgr = make_shared <MyDB_BufferManager> (131072, 128, "tempFile");
+		MyDB_TableReaderWriter supplierTable (allTables["supplier"], myMgr);
+		MyDB_TablePtr outTable = make_shared <MyDB_Table> ("supplierSortedParallel", 
+			"supplierSortedParallel.bin", allTables["supplier"]->getSchema ());
+		MyDB_TableReaderWriter outputTable (outTable, myMgr);
+
+		sort (16, 4, supplierTable, outputTable, "[acctbal]");
+
+		MyDB_RecordPtr rec1 = supplierTable.getEmptyRecord ();
+		MyDB_RecordPtr rec2 = supplierTable.getEmptyRecord ();
+		function <bool ()> myComp = buildRecordComparator (rec1, rec2, "[acctbal]");
+		function <bool ()> otherComp = buildRecordComparator (rec2, rec1, "[acctbal]");
+		int counter;
+		int outOfOrder = countOutOfOrder (outputTable, rec1, rec2, myComp, otherComp, counter);
+		QUNIT_IS_EQUAL (counter, 320000);
+		QUNIT_IS_EQUAL (outOfOrder, 0);
+	}
+
+	{
+		// sort with several threads again, asking for runs so long that together they
+		// take up the whole buffer, so that the workers have to kick out each other's pages;
+		// the runs are cut down so that no worker has to wait for a frame
+		MyDB_CatalogPtr myCatalog = make_shared <MyDB_Catalog> ("catFile");
+		map <string, MyDB_TablePtr> allTables = MyDB_Table :: getAllTables (myCatalog);
+		MyDB_BufferManagerPtr myMgr = make_shared <MyDB_BufferManager> (131072, 128, "tempFile");
+		MyDB_TableReaderWriter supplierTable (allTables["supplier"], myMgr);
+		MyDB_TablePtr outTable = make_shared <MyDB_Table> ("supplierSortedParallelFull", 
+			"supplierSortedParallelFull.bin", allTables["supplier"]->getSchema ());
+		MyDB_TableReaderWriter outputTable (outTable, myMgr);
+
+		sort (128, 4, supplierTable, outputTable, "[acctbal]");
+		QUNIT_IS_EQUAL (myMgr->getStats ().numPinFailures, 0);
+
+		MyDB_RecordPtr rec1 = supplierTable.getEmptyRecord ();
+		MyDB_RecordPtr rec2 = supplierTable.getEmptyRecord ();
+		function <bool ()> myComp = buildRecordComparator (rec1, rec2, "[acctbal]");
+		function <bool ()> otherComp = buildRecordComparator (rec2, rec1, "[acctbal]");
+		int counter;
+		int outOfOrder = countOutOfOrder (outputTable, rec1, rec2, myComp, otherComp, counter);
+		QUNIT_IS_EQUAL (counter, 320000);
+		QUNIT_IS_EQUAL (outOfOrder, 0);
+	}
+
+	{
+		// deal the sorted supplier table out into k sorted runs, and merge them back together
+		// with the loser tree (with and without sort keys) and with the priority queue, for
+		// more and more runs; the small
+		// pages are so that every run can have its current page in the buffer
+		MyDB_CatalogPtr myCatalog = make_shared <MyDB_Catalog> ("catFile");
+		map <string, MyDB_TablePtr> allTables = MyDB_Table :: getAllTables (myCatalog);
+		MyDB_BufferManagerPtr myMgr = make_shared <MyDB_BufferManager> (131072, 128, "tempFile");
+		MyDB_TableReaderWriter sortedTable (allTables["supplierSorted"], myMgr);
+		MyDB_BufferManagerPtr runMgr = make_shared <MyDB_BufferManager> (4096, 2048, "tempFile2");
+
+		MyDB_RecordPtr rec1 = sortedTable.getEmptyRecord ();
+		MyDB_RecordPtr rec2 = sortedTable.getEmptyRecord ();
+		function <bool ()> myComp = buildRecordComparator (rec1, rec2, "[acctbal]");
+		function <bool ()> otherComp = buildRecordComparator (rec2, rec1, "[acctbal]");
+		MyDB_SortKeyPtr myKey = make_shared <MyDB_SortKey> (rec1, "[acctbal]");
+
+		for (int k = 16; k <= 1024; k *= 4) {
+
+			vector <vector <MyDB_PageReaderWriter>> runs (k);
+			MyDB_RecordIteratorAltPtr myIter = sortedTable.getIteratorAlt ();
+			for (int i = 0; myIter->advance (); i++) {
+				myIter->getCurrent (rec1);
+				vector <MyDB_PageReaderWriter> &run = runs[i % k];
+				if (run.empty () || !run.back ().append (rec1)) {
+					run.push_back (MyDB_PageReaderWriter (*runMgr));
+					run.back ().append (rec1);
+				}
+			}
+
+			int counts[3], outOfOrder[3];
+			double secs[3];
+			for (int which = 0; which < 3; which++) {
+				MyDB_TablePtr outTable = make_shared <MyDB_Table> ("supplierMerged", 
+					"supplierMerged.bin", allTables["supplier"]->getSchema ());
+				MyDB_TableReaderWriter outputTable (outTable, runMgr);
+				vector <MyDB_RecordIteratorAltPtr> runIters;
+				for (auto &run : runs)
+					runIters.push_back (getIteratorAlt (run));
+
+				auto start = chrono :: steady_clock :: now ();
+				if (which == 0)
+					mergeIntoFile (outputTable, runIters, myComp, rec1, rec2);
+				else if (which == 1)
+					mergeIntoFile (outputTable, runIters, myComp, rec1, rec2, myKey);
+				else
+					mergeIntoFileWithHeap (outputTable, runIters, myComp, rec1, rec2);
+				secs[which] = chrono :: duration <double> (chrono :: steady_clock :: now () - start).count ();
+
+				outOfOrder[which] = countOutOfOrder (outputTable, rec1, rec2, myComp, otherComp, counts[which]);
+				remove ("supplierMerged.bin");
+			}
+
+			cout << k << " runs: loser tree " << secs[0] << "s, with keys " << secs[1] << "s, heap " << secs[2] << "s\n" << flush;
+			for (int which = 0; which < 3; which++) {
+				QUNIT_IS_EQUAL (counts[which], 320000);
+				QUNIT_IS_EQUAL (outOfOrder[which], 0);
+			}
+		}
+	}
+
+	{
+		// sort each page of the supplier table on an int and on a double, with the
+		// comparator and with a radix sort on the keys
+		MyDB_CatalogPtr myCatalog = make_shared <MyDB_Catalog> ("catFile");
+		map <string, MyDB_TablePtr> allTables = MyDB_Table :: getAllTables (myCatalog);
+		MyDB_BufferManagerPtr myMgr = make_shared <MyDB_BufferManager> (131072, 128, "tempFile");
+		MyDB_TableReaderWriter supplierTable (allTables["supplier"], myMgr);
+		MyDB_RecordPtr rec1 = supplierTable.getEmptyRecord ();
+		MyDB_RecordPtr rec2 = supplierTable.getEmptyRecord ();
+
+		for (string computation : {"[suppkey]", "[acctbal]"}) {
+			function <bool ()> myComp = buildRecordComparator (rec1, rec2, computation);
+			MyDB_SortKeyPtr myKey = make_shared <MyDB_SortKey> (rec1, computation);
+			int counts[2] = {0, 0}, outOfOrder = 0;
+			double secs[2] = {0, 0};
+			for (int which = 0; which < 2; which++) {
+				for (int i = 0; i < supplierTable.getNumPages (); i++) {
+					auto start = chrono :: steady_clock :: now ();
+					MyDB_PageReaderWriterPtr sorted = supplierTable[i].sort (myComp, rec1, rec2, 
+						which == 0 ? nullptr : myKey);
+					secs[which] += chrono :: duration <double> (chrono :: steady_clock :: now () - start).count ();
+					for (int j = 0; j < sorted->getNumSlots (); j++) {
+						if (which == 1 && j > 0) {
+							sorted->getRecord (j - 1, rec2);
+							sorted->getRecord (j, rec1);
+							if (myComp ())
+								outOfOrder++;
+						}
+						counts[which]++;
+					}
+				}
+			}
+			cout << "page sorts on " << computation << ": comparator " << secs[0] << "s, radix " << secs[1] << "s\n" << flush;
+			QUNIT_IS_EQUAL (counts[0], 320000);
+			QUNIT_IS_EQUAL (counts[1], 320000);
+			QUNIT_IS_EQUAL (outOfOrder, 0);
+		}
+	}
 }
 
 #endif